@@ -1,4 +1,5 @@
 #include "aes.h"
+#include "sccrypto.h"
 #include <string.h>   /* for memcpy */
 
 /* forward S‑box */
@@ -61,6 +62,7 @@ static inline uint32_t SubWord(uint32_t w) {
 /* ----------------------------------------------------------------------- */
 void aes_key_setup(aes_key_t *ks, const uint8_t *key, size_t key_bits)
 {
+    sccrypto_init();
     int Nk = (int)(key_bits / 32);          /* words in the input key */
     int Nb = 4;                             /* AES block is always 4 words */
     ks->Nr = Nk + 6;                        /* 10/12/14 */
@@ -0,0 +1,258 @@
+/* aes_reader.c – random-access decrypting reader with a page LRU cache */
+#define _POSIX_C_SOURCE 200809L
+#include "aes_reader.h"
+#include "aes.h"
+#include "compress.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define IV_BYTES        16
+
+typedef struct {
+    uint64_t  page;
+    int32_t   prev, next;      /* LRU list, head = most recently used */
+    int32_t   hnext;           /* bucket chain                        */
+    uint8_t  *data;
+} cache_slot_t;
+
+struct aes_reader {
+    int            fd;
+    aes_key_t      ks;
+    uint64_t       ct_len;     /* ciphertext bytes after the IV */
+    uint64_t       size;       /* plaintext bytes               */
+    uint64_t       npages;
+
+    cache_slot_t  *slots;
+    size_t         cap, used;
+    int32_t       *buckets;
+    size_t         nbuckets;
+    int32_t        head, tail;
+
+    uint64_t       next_seq;   /* offset a sequential read would start at */
+    size_t         ra_window;  /* pages fetched ahead on the next miss    */
+    uint8_t       *io;         /* IV/previous block ⧺ batch of ciphertext */
+};
+
+static int read_exact(int fd, uint8_t *dst, size_t len, uint64_t off)
+{
+    while (len) {
+        ssize_t r = pread(fd, dst, len, (off_t)off);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) { if (r == 0) errno = EIO; return -1; }
+        dst += r; len -= (size_t)r; off += (uint64_t)r;
+    }
+    return 0;
+}
+
+/* ---------- LRU cache -------------------------------------------------- */
+static size_t bucket_of(const aes_reader_t *r, uint64_t page)
+{
+    return (size_t)((page * 0x9E3779B97F4A7C15ull) >> 32) % r->nbuckets;
+}
+
+static int32_t cache_lookup(const aes_reader_t *r, uint64_t page)
+{
+    for (int32_t i = r->buckets[bucket_of(r, page)]; i >= 0; i = r->slots[i].hnext)
+        if (r->slots[i].page == page) return i;
+    return -1;
+}
+
+static void lru_unlink(aes_reader_t *r, int32_t i)
+{
+    cache_slot_t *s = &r->slots[i];
+    if (s->prev >= 0) r->slots[s->prev].next = s->next; else r->head = s->next;
+    if (s->next >= 0) r->slots[s->next].prev = s->prev; else r->tail = s->prev;
+}
+
+static void lru_push_front(aes_reader_t *r, int32_t i)
+{
+    r->slots[i].prev = -1;
+    r->slots[i].next = r->head;
+    if (r->head >= 0) r->slots[r->head].prev = i;
+    r->head = i;
+    if (r->tail < 0) r->tail = i;
+}
+
+static void cache_touch(aes_reader_t *r, int32_t i)
+{
+    if (r->head == i) return;
+    lru_unlink(r, i);
+    lru_push_front(r, i);
+}
+
+/* Takes a free slot, or evicts the least recently used one */
+static int32_t cache_insert(aes_reader_t *r, uint64_t page)
+{
+    int32_t i;
+    if (r->used < r->cap) {
+        i = (int32_t)r->used++;
+    } else {
+        i = r->tail;
+        lru_unlink(r, i);
+        int32_t *link = &r->buckets[bucket_of(r, r->slots[i].page)];
+        while (*link != i) link = &r->slots[*link].hnext;
+        *link = r->slots[i].hnext;
+    }
+    size_t b = bucket_of(r, page);
+    r->slots[i].page = page;
+    r->slots[i].hnext = r->buckets[b];
+    r->buckets[b] = i;
+    lru_push_front(r, i);
+    return i;
+}
+
+/* ---------- page loading ----------------------------------------------- */
+static size_t page_bytes(const aes_reader_t *r, uint64_t page)
+{
+    uint64_t left = r->ct_len - page * AES_READER_PAGE;
+    return left < AES_READER_PAGE ? (size_t)left : AES_READER_PAGE;
+}
+
+/* Reads pages [first, first + count) with one pread and decrypts every
+ * page that is not cached yet.  The ciphertext of page p starts at file
+ * offset IV_BYTES + p * PAGE, so starting the read one block earlier picks
+ * up the IV or the previous ciphertext block the first page chains from. */
+static int load_pages(aes_reader_t *r, uint64_t first, size_t count)
+{
+    if (first + count > r->npages) count = (size_t)(r->npages - first);
+    size_t bytes = (count - 1) * (size_t)AES_READER_PAGE + page_bytes(r, first + count - 1);
+    if (read_exact(r->fd, r->io, IV_BYTES + bytes, first * AES_READER_PAGE) != 0)
+        return -1;
+
+    for (size_t k = 0; k < count; ++k) {
+        uint64_t page = first + k;
+        if (cache_lookup(r, page) >= 0) continue;
+        int32_t i = cache_insert(r, page);
+
+        const uint8_t *ct = r->io + IV_BYTES + k * AES_READER_PAGE;
+        uint8_t *pt = r->slots[i].data;
+        size_t n = page_bytes(r, page);
+        for (size_t off = 0; off < n; off += AES_BLOCK_SIZE) {
+            aes_decrypt_block(&r->ks, ct + off, pt + off);
+            for (int b = 0; b < AES_BLOCK_SIZE; ++b) pt[off + b] ^= ct[off + b - AES_BLOCK_SIZE];
+        }
+    }
+    return 0;
+}
+
+/* ---------- public API ------------------------------------------------- */
+aes_reader_t *aes_reader_open(const char *path, const uint8_t *key, size_t key_len,
+                              size_t cache_pages)
+{
+    if (key_len != 16 && key_len != 24 && key_len != 32) { errno = EINVAL; return NULL; }
+
+    aes_reader_t *r = calloc(1, sizeof *r);
+    if (!r) return NULL;
+    r->fd = open(path, O_RDONLY);
+    if (r->fd < 0) { free(r); return NULL; }
+    aes_key_setup(&r->ks, key, key_len * 8);
+
+    struct stat st;
+    uint8_t tail[2 * AES_BLOCK_SIZE], last[AES_BLOCK_SIZE];
+    if (fstat(r->fd, &st) != 0) goto fail;
+    if (st.st_size < IV_BYTES + AES_BLOCK_SIZE || (st.st_size - IV_BYTES) % AES_BLOCK_SIZE) {
+        errno = EINVAL;
+        goto fail;
+    }
+    r->ct_len = (uint64_t)st.st_size - IV_BYTES;
+    r->npages = (r->ct_len + AES_READER_PAGE - 1) / AES_READER_PAGE;
+
+    /* the plaintext size comes from the PKCS#7 byte in the last block */
+    if (read_exact(r->fd, tail, sizeof tail, (uint64_t)st.st_size - sizeof tail) != 0)
+        goto fail;
+    aes_decrypt_block(&r->ks, tail + AES_BLOCK_SIZE, last);
+    for (int b = 0; b < AES_BLOCK_SIZE; ++b) last[b] ^= tail[b];
+    uint8_t pad = last[AES_BLOCK_SIZE - 1];
+    int bad = pad == 0 || pad > AES_BLOCK_SIZE;
+    for (int b = 1; !bad && b <= pad; ++b) bad = last[AES_BLOCK_SIZE - b] != pad;
+    if (bad) { errno = EINVAL; goto fail; }
+    r->size = r->ct_len - pad;
+
+    r->cap = cache_pages ? cache_pages : AES_READER_CACHE;
+    if (r->cap < AES_READER_READAHEAD + 1) r->cap = AES_READER_READAHEAD + 1;
+    r->nbuckets = r->cap * 2;
+    r->slots   = calloc(r->cap, sizeof *r->slots);
+    r->buckets = malloc(r->nbuckets * sizeof *r->buckets);
+    r->io      = malloc(IV_BYTES + (size_t)(AES_READER_READAHEAD + 1) * AES_READER_PAGE);
+    if (!r->slots || !r->buckets || !r->io) goto fail;
+    for (size_t i = 0; i < r->cap; ++i)
+        if (!(r->slots[i].data = malloc(AES_READER_PAGE))) goto fail;
+    for (size_t b = 0; b < r->nbuckets; ++b) r->buckets[b] = -1;
+    r->head = r->tail = -1;
+
+    /* aes_cbc -z output is an LZ container; its bytes are not the data */
+    uint8_t head[LZ_MAGIC_SIZE];
+    ssize_t n = aes_reader_pread(r, head, sizeof head, 0);
+    if (n < 0) goto fail;
+    if (compress_is_container(head, (size_t)n)) { errno = EINVAL; goto fail; }
+    r->next_seq = 0;
+    return r;
+
+fail: {
+        int saved = errno;
+        aes_reader_close(r);
+        errno = saved;
+        return NULL;
+    }
+}
+
+uint64_t aes_reader_size(const aes_reader_t *r)
+{
+    return r->size;
+}
+
+ssize_t aes_reader_pread(aes_reader_t *r, void *buf, size_t len, uint64_t off)
+{
+    if (off >= r->size || len == 0) return 0;
+    if (len > r->size - off) len = (size_t)(r->size - off);
+    if (len > SSIZE_MAX) len = SSIZE_MAX;
+
+    /* a read that starts where the last one ended grows the read-ahead window */
+    if (off == r->next_seq && off != 0)
+        r->ra_window = r->ra_window ? 2 * r->ra_window : 1;
+    else
+        r->ra_window = 0;
+    if (r->ra_window > AES_READER_READAHEAD) r->ra_window = AES_READER_READAHEAD;
+
+    uint8_t *dst = buf;
+    size_t done = 0;
+    while (done < len) {
+        uint64_t page = (off + done) / AES_READER_PAGE;
+        size_t in_page = (size_t)((off + done) % AES_READER_PAGE);
+        int32_t i = cache_lookup(r, page);
+        if (i < 0) {
+            if (load_pages(r, page, 1 + r->ra_window) != 0)
+                return done ? (ssize_t)done : -1;
+            i = cache_lookup(r, page);
+        }
+        cache_touch(r, i);
+
+        size_t n = AES_READER_PAGE - in_page;
+        if (n > len - done) n = len - done;
+        memcpy(dst + done, r->slots[i].data + in_page, n);
+        done += n;
+    }
+    r->next_seq = off + done;
+    return (ssize_t)done;
+}
+
+void aes_reader_close(aes_reader_t *r)
+{
+    if (!r) return;
+    if (r->slots)
+        for (size_t i = 0; i < r->cap; ++i) {
+            if (r->slots[i].data) memset(r->slots[i].data, 0, AES_READER_PAGE);
+            free(r->slots[i].data);
+        }
+    if (r->fd >= 0) close(r->fd);
+    memset(&r->ks, 0, sizeof r->ks);
+    free(r->slots);
+    free(r->buckets);
+    free(r->io);
+    free(r);
+}
@@ -0,0 +1,37 @@
+/****************  aes_reader.h  ****************/
+#ifndef AES_READER_H
+#define AES_READER_H
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/* Random-access reader over files written by aes_cbc (IV ⧺ CBC ciphertext).
+ * Files compressed with -z (see compress.h) are not supported.
+ *
+ * CBC decryption of block i only needs ciphertext blocks i-1 and i, so a
+ * read decrypts just the pages it touches.  Decrypted pages are kept in a
+ * bounded LRU cache, and sequential reads grow a read-ahead window that
+ * fetches and decrypts the following pages with a single pread().
+ *
+ * A reader is not thread-safe; open one per thread. */
+#define AES_READER_PAGE       4096   /* plaintext bytes per cached page */
+#define AES_READER_CACHE      64     /* default cache capacity (pages)  */
+#define AES_READER_READAHEAD  16     /* max pages fetched ahead         */
+
+typedef struct aes_reader aes_reader_t;
+
+/* key_len is 16, 24 or 32; cache_pages 0 selects AES_READER_CACHE.
+ * Returns NULL (errno set) if the file cannot be opened, its padding does
+ * not check out under the given key, or it holds compressed data (EINVAL). */
+aes_reader_t *aes_reader_open(const char *path, const uint8_t *key, size_t key_len,
+                              size_t cache_pages);
+
+/* Plaintext size, i.e. ciphertext size minus IV and padding */
+uint64_t aes_reader_size(const aes_reader_t *r);
+
+/* Like pread(2): returns bytes copied, 0 at end of file, -1 on I/O error */
+ssize_t aes_reader_pread(aes_reader_t *r, void *buf, size_t len, uint64_t off);
+
+void aes_reader_close(aes_reader_t *r);
+
+#endif /* AES_READER_H */
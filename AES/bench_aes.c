@@ -0,0 +1,239 @@
+/* bench_aes.c – throughput / latency sweep over the AES kernels.
+ *
+ * For each key size (128/192/256) this times key setup, single blocks
+ * and ECB / CBC encryption and decryption of whole messages from 16 B up
+ * to -m bytes, at every thread count given with -t. The AES code has no
+ * multi-threaded mode, so with T threads each thread works through its
+ * own messages: the figures are then aggregate throughput (ns, cycles
+ * per message of all T streams together), the shape of aes_archive
+ * extraction. Results go to a table and optionally JSON / CSV.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include "bench.h"
+#include "sccrypto.h"
+#include <pthread.h>
+
+#define BENCH_MAX_THREADS 64
+#define DEFAULT_MAX_SIZE  (16u << 20)
+
+typedef enum { OP_ECB_ENC, OP_ECB_DEC, OP_CBC_ENC, OP_CBC_DEC, OP_COUNT } op_t;
+static const char *const op_names[OP_COUNT] = {
+    "ecb_encrypt", "ecb_decrypt", "cbc_encrypt", "cbc_decrypt"
+};
+
+typedef struct {
+    aes_key_t ks;
+    uint8_t   key[32];
+    size_t    key_bits;
+    op_t      op;
+    size_t    len;
+    int       threads;
+    uint8_t  *buf[BENCH_MAX_THREADS];   /* one message per stream */
+} sweep_t;
+
+typedef struct {
+    const sweep_t *s;
+    uint8_t       *buf;
+    size_t         iters;
+} stream_t;
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-n SAMPLES] [-m MAX_SIZE] [-t T1,T2,..] [-f NAME]\n"
+                    "          [-j | -o FILE.json] [-c FILE.csv]\n", prog);
+    fprintf(stderr, "  Message sizes run from 16 B to MAX_SIZE (default 16M; K/M/G\n"
+                    "  suffixes, up to 1G); -t defaults to 1, 2, 4 .. up to the CPU count.\n"
+                    "  -f runs only names containing NAME, e.g. aes256 or cbc_decrypt.\n");
+    exit(EXIT_FAILURE);
+}
+
+static FILE *open_output(FILE *prev, const char *fname)
+{
+    FILE *f = prev ? NULL : fopen(fname, "w");
+    if (!f) {
+        if (!prev) perror(fname);
+        exit(EXIT_FAILURE);
+    }
+    return f;
+}
+
+/* "64K", "16M", "1G" */
+static size_t parse_size(const char *str)
+{
+    char *end;
+    unsigned long long v = strtoull(str, &end, 10);
+    switch (*end) {
+    case 'K': case 'k': v <<= 10; end++; break;
+    case 'M': case 'm': v <<= 20; end++; break;
+    case 'G': case 'g': v <<= 30; end++; break;
+    }
+    return *end || v < 16 || v > (1ull << 30) ? 0 : (size_t)v;
+}
+
+/* Comma-separated thread counts; returns how many were stored */
+static int parse_threads(const char *str, int *out, int max)
+{
+    int n = 0;
+    while (*str && n < max) {
+        char *end;
+        long t = strtol(str, &end, 10);
+        if (end == str || t < 1 || t > BENCH_MAX_THREADS) return 0;
+        out[n++] = (int)t;
+        if (*end && *end != ',') return 0;
+        str = *end ? end + 1 : end;
+    }
+    return n;
+}
+
+/* Message contents only need to look random to the table lookups */
+static void fill_pseudorandom(uint8_t *buf, size_t len, uint64_t seed)
+{
+    uint64_t x = seed * 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < len; ++i) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        buf[i] = (uint8_t)(x >> 32);
+    }
+}
+
+static void run_stream(const sweep_t *s, uint8_t *buf, size_t iters)
+{
+    static const uint8_t iv[16];
+    for (size_t i = 0; i < iters; ++i) {
+        switch (s->op) {
+        case OP_ECB_ENC:
+            for (size_t off = 0; off < s->len; off += AES_BLOCK_SIZE)
+                aes_encrypt_block(&s->ks, buf + off, buf + off);
+            break;
+        case OP_ECB_DEC:
+            for (size_t off = 0; off < s->len; off += AES_BLOCK_SIZE)
+                aes_decrypt_block(&s->ks, buf + off, buf + off);
+            break;
+        case OP_CBC_ENC: cbc_encrypt(buf, s->len, &s->ks, iv); break;
+        case OP_CBC_DEC: cbc_decrypt(buf, s->len, &s->ks, iv); break;
+        default: break;
+        }
+    }
+}
+
+static void *stream_worker(void *arg)
+{
+    stream_t *st = arg;
+    run_stream(st->s, st->buf, st->iters);
+    return NULL;
+}
+
+/* iters rounds of one message per stream, the streams in parallel */
+static void run_sweep(void *ctx, size_t iters)
+{
+    sweep_t *s = ctx;
+    pthread_t tid[BENCH_MAX_THREADS];
+    stream_t st[BENCH_MAX_THREADS];
+    int started = 0;
+    for (int t = 0; t < s->threads; ++t)
+        st[t] = (stream_t){ s, s->buf[t], iters };
+    for (; started < s->threads - 1; ++started)
+        if (pthread_create(&tid[started], NULL, stream_worker, &st[started + 1]) != 0) break;
+    run_stream(s, s->buf[0], iters);
+    /* streams whose thread did not start run here */
+    for (int t = started + 1; t < s->threads; ++t) run_stream(s, s->buf[t], iters);
+    for (int t = 0; t < started; ++t) pthread_join(tid[t], NULL);
+}
+
+static void run_key_setup(void *ctx, size_t iters)
+{
+    sweep_t *s = ctx;
+    for (size_t i = 0; i < iters; ++i) aes_key_setup(&s->ks, s->key, s->key_bits);
+}
+
+static void run_block_encrypt(void *ctx, size_t iters)
+{
+    sweep_t *s = ctx;
+    for (size_t i = 0; i < iters; ++i) aes_encrypt_block(&s->ks, s->buf[0], s->buf[0]);
+}
+
+static void run_block_decrypt(void *ctx, size_t iters)
+{
+    sweep_t *s = ctx;
+    for (size_t i = 0; i < iters; ++i) aes_decrypt_block(&s->ks, s->buf[0], s->buf[0]);
+}
+
+int main(int argc, char **argv)
+{
+    FILE *json = NULL, *csv = NULL;
+    const char *filter = NULL;
+    int samples = BENCH_SAMPLES, to_stdout = 0, nthreads = 0;
+    int thread_list[BENCH_MAX_THREADS];
+    size_t max_size = DEFAULT_MAX_SIZE;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) samples = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-m") && i + 1 < argc) {
+            if (!(max_size = parse_size(argv[++i]))) usage(argv[0]);
+        } else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            if (!(nthreads = parse_threads(argv[++i], thread_list, BENCH_MAX_THREADS))) usage(argv[0]);
+        } else if (!strcmp(argv[i], "-f") && i + 1 < argc) filter = argv[++i];
+        else if (!strcmp(argv[i], "-j")) to_stdout = 1;
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) json = open_output(json, argv[++i]);
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc) csv = open_output(csv, argv[++i]);
+        else usage(argv[0]);
+    }
+    if (samples <= 0 || (to_stdout && json)) usage(argv[0]);
+    if (!nthreads) {
+        int cpus = bench_cpu_count();
+        for (int t = 1; t < cpus && t < BENCH_MAX_THREADS; t *= 2) thread_list[nthreads++] = t;
+        thread_list[nthreads++] = cpus < BENCH_MAX_THREADS ? cpus : BENCH_MAX_THREADS;
+    }
+
+    bench_t b;
+    bench_init(&b, "aes", to_stdout ? stderr : stdout, to_stdout ? stdout : json, csv);
+    b.samples = samples;
+    b.filter = filter;
+    b.backend = sccrypto_impl("aes");
+
+    static sweep_t s;
+    int max_threads = 1;
+    for (int i = 0; i < nthreads; i++)
+        if (thread_list[i] > max_threads) max_threads = thread_list[i];
+    for (int t = 0; t < max_threads; t++) {
+        if (!(s.buf[t] = malloc(max_size))) {
+            fprintf(stderr, "Memory allocation failed (%d x %zu bytes)\n", max_threads, max_size);
+            return EXIT_FAILURE;
+        }
+        fill_pseudorandom(s.buf[t], max_size, (uint64_t)t + 1);
+    }
+    random_bytes(s.key, sizeof s.key);
+
+    for (size_t key_bits = 128; key_bits <= 256; key_bits += 64) {
+        char name[64];
+        s.key_bits = key_bits;
+        aes_key_setup(&s.ks, s.key, key_bits);
+
+        b.threads = 1;
+        b.ops_per_call = 1;
+        snprintf(name, sizeof name, "aes%zu/key_setup", key_bits);
+        bench_run(&b, name, 0, run_key_setup, &s, NULL);
+        snprintf(name, sizeof name, "aes%zu/encrypt_block", key_bits);
+        bench_run(&b, name, AES_BLOCK_SIZE, run_block_encrypt, &s, NULL);
+        snprintf(name, sizeof name, "aes%zu/decrypt_block", key_bits);
+        bench_run(&b, name, AES_BLOCK_SIZE, run_block_decrypt, &s, NULL);
+
+        for (op_t op = 0; op < OP_COUNT; op++) {
+            snprintf(name, sizeof name, "aes%zu/%s", key_bits, op_names[op]);
+            s.op = op;
+            for (size_t len = 16; len <= max_size; len *= 16) {
+                s.len = len;
+                for (int i = 0; i < nthreads; i++) {
+                    s.threads = b.threads = b.ops_per_call = thread_list[i];
+                    bench_run(&b, name, len, run_sweep, &s, NULL);
+                }
+            }
+        }
+    }
+
+    bench_finish(&b);
+    for (int t = 0; t < max_threads; t++) free(s.buf[t]);
+    memset(&s, 0, sizeof s);
+    if (json) fclose(json);
+    if (csv) fclose(csv);
+    return EXIT_SUCCESS;
+}
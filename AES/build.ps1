@@ -1,5 +1,5 @@
 # PowerShell Build Script for AES (Advanced Encryption Standard) Implementation
-# Usage: .\build.ps1 [clean|all|test]
+# Usage: .\build.ps1 [clean|all|test|bench]
 
 param(
     [string]$Target = "all"
@@ -7,12 +7,16 @@ param(
 
 $ErrorActionPreference = "Stop"
 
+# Every tool links ..\libsccrypto\libsccrypto.a; sccrypto.h needs the
+# headers of all three directories
+$Includes = @("-I.", "-I..\libsccrypto", "-I..\TEA", "-I..\ecc_25519")
+
 function Build-Object {
     param([string]$Source)
     
     $Object = $Source -replace "\.c$", ".o"
     Write-Host "Compiling $Source..." -ForegroundColor Green
-    gcc -Wall -Wextra -O2 -std=c99 -c $Source -o $Object
+    gcc -Wall -Wextra -O2 -std=c99 @Includes -c $Source -o $Object
     if ($LASTEXITCODE -ne 0) {
         throw "Failed to compile $Source"
     }
@@ -30,28 +34,52 @@ function Build-Executable {
 
 function Clear-Build {
     Write-Host "Cleaning build artifacts..." -ForegroundColor Yellow
-    Remove-Item -Force -ErrorAction SilentlyContinue "*.o", "*.exe"
+    Remove-Item -Force -ErrorAction SilentlyContinue "*.o", "*.exe", "*.a"
     Write-Host "Clean complete." -ForegroundColor Green
 }
 
+function Build-Library {
+    # libsccrypto builds from this directory's sources and the other two
+    Push-Location "..\libsccrypto"
+    try {
+        & .\build.ps1 lib
+    } finally {
+        Pop-Location
+    }
+    if ($LASTEXITCODE -ne 0) {
+        throw "Failed to build libsccrypto"
+    }
+}
+
 function Build-All {
     Write-Host "Building AES (Advanced Encryption Standard) Implementation..." -ForegroundColor Cyan
     
-    # Compile core source files
-    Build-Object "aes.c"
+    # Compile source files
     Build-Object "common.c"
-    
-    # Compile driver files
     Build-Object "driver_aes_CBC.c"
     Build-Object "driver_aes_ECB.c"
+    Build-Object "driver_aes_archive.c"
+    Build-Object "driver_aes_sparse.c"
+    Build-Object "driver_aes_log.c"
+    Build-Object "bench_aes.c"
     
-    # Link executables
-    Build-Executable "aes_cbc" @("aes.o", "common.o", "driver_aes_CBC.o")
-    Build-Executable "aes_ecb" @("aes.o", "common.o", "driver_aes_ECB.o")
+    # Link executables against libsccrypto (AES core, reader, kernel dispatch)
+    Build-Library
+    $Lib = @("..\libsccrypto\libsccrypto.a", "-pthread")
+    Build-Executable "aes_cbc" (@("common.o", "driver_aes_CBC.o") + $Lib)
+    Build-Executable "aes_ecb" (@("common.o", "driver_aes_ECB.o") + $Lib)
+    Build-Executable "aes_archive" (@("common.o", "driver_aes_archive.o") + $Lib)
+    Build-Executable "aes_sparse" (@("common.o", "driver_aes_sparse.o") + $Lib)
+    Build-Executable "aes_log" (@("common.o", "driver_aes_log.o") + $Lib)
+    Build-Executable "bench_aes" (@("bench_aes.o") + $Lib)
     
     Write-Host "`nBuild complete! Generated executables:" -ForegroundColor Green
     Write-Host "  - aes_cbc.exe     (AES CBC mode - recommended for security)" -ForegroundColor White
     Write-Host "  - aes_ecb.exe     (AES ECB mode - for demonstration only)" -ForegroundColor White
+    Write-Host "  - aes_archive.exe (multi-file encrypted archive)" -ForegroundColor White
+    Write-Host "  - aes_sparse.exe  (sparse-file aware CBC, encrypts data extents only)" -ForegroundColor White
+    Write-Host "  - aes_log.exe     (append-only authenticated encrypted log)" -ForegroundColor White
+    Write-Host "  - bench_aes.exe   (throughput / latency benchmark sweep)" -ForegroundColor White
     Write-Host "`nNote: CBC mode is cryptographically secure, ECB mode is NOT secure for real data!" -ForegroundColor Yellow
 }
 
@@ -85,6 +113,15 @@ function Show-Tests {
     Write-Host "   .\aes_cbc.exe -e -i input.txt -k key192.txt -o encrypted_192.bin" -ForegroundColor Gray
     Write-Host "   .\aes_cbc.exe -e -i input.txt -k key256.txt -o encrypted_256.bin" -ForegroundColor Gray
     
+    Write-Host "`n7. Compress before encrypting (decrypt detects it, no -z needed):" -ForegroundColor White
+    Write-Host "   .\aes_cbc.exe -e -z -i input.txt -k key128.txt -o encrypted_z.bin" -ForegroundColor Gray
+    Write-Host "   .\aes_cbc.exe -d -i encrypted_z.bin -k key128.txt -o decrypted_z.txt" -ForegroundColor Gray
+    
+    Write-Host "`n8. Archive several files and extract them in parallel:" -ForegroundColor White
+    Write-Host "   .\aes_archive.exe -c -k key128.txt -o files.scar input.txt encrypted_cbc.bin" -ForegroundColor Gray
+    Write-Host "   .\aes_archive.exe -l -k key128.txt -i files.scar" -ForegroundColor Gray
+    Write-Host "   .\aes_archive.exe -x -k key128.txt -i files.scar -C restored -t 4" -ForegroundColor Gray
+    
     Write-Host "`nSecurity Notes:" -ForegroundColor Yellow
     Write-Host "  - CBC mode uses random IV and is cryptographically secure" -ForegroundColor White
     Write-Host "  - ECB mode is deterministic and reveals patterns in data" -ForegroundColor White
@@ -93,6 +130,15 @@ function Show-Tests {
     Write-Host "  - AES-256 provides additional security margin" -ForegroundColor White
 }
 
+function Run-Bench {
+    Build-All
+    Write-Host "`nRunning benchmarks (results in bench_aes.json / bench_aes.csv)..." -ForegroundColor Cyan
+    .\bench_aes.exe -o bench_aes.json -c bench_aes.csv
+    if ($LASTEXITCODE -ne 0) {
+        throw "bench_aes failed"
+    }
+}
+
 function Show-Usage {
     Write-Host "`nAES (Advanced Encryption Standard) Build Script" -ForegroundColor Cyan
     Write-Host "Usage: .\build.ps1 [command]" -ForegroundColor White
@@ -100,6 +146,7 @@ function Show-Usage {
     Write-Host "  all     - Build all executables (default)" -ForegroundColor White
     Write-Host "  clean   - Clean build artifacts" -ForegroundColor White
     Write-Host "  test    - Show manual testing instructions" -ForegroundColor White
+    Write-Host "  bench   - Build and run bench_aes" -ForegroundColor White
     Write-Host "  help    - Show this help message" -ForegroundColor White
     Write-Host "`nExamples:" -ForegroundColor Yellow
     Write-Host "  .\build.ps1                # Build everything" -ForegroundColor White
@@ -121,6 +168,7 @@ try {
         "all" { Build-All }
         "clean" { Clear-Build }
         "test" { Show-Tests }
+        "bench" { Run-Bench }
         "help" { Show-Usage }
         default { 
             Write-Host "Unknown target: $Target" -ForegroundColor Red
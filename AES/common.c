@@ -2,7 +2,7 @@
 
 static void usage(const char *prog)
 {
-    fprintf(stderr, "Usage: %s (-e|-d) -i <input> -k <key> -o <output>\n", prog);
+    fprintf(stderr, "Usage: %s (-e|-d) [-z] -i <input> -k <key> -o <output>\n", prog);
     exit(EXIT_FAILURE);
 }
 
@@ -15,6 +15,7 @@ void parse_cli(int argc, char **argv, cli_args_t *a)
         else if (!strcmp(argv[i], "-i")) a->in_fname = argv[++i];
         else if (!strcmp(argv[i], "-k")) a->key_fname = argv[++i];
         else if (!strcmp(argv[i], "-o")) a->out_fname = argv[++i];
+        else if (!strcmp(argv[i], "-z")) a->compress = 1;
         else usage(argv[0]);
     }
     if (!a->in_fname || !a->key_fname || !a->out_fname)
@@ -13,6 +13,7 @@ typedef struct {
     const char *in_fname;
     const char *key_fname;
     const char *out_fname;
+    int compress;          /* -z: LZ stage in front of the cipher */
 } cli_args_t;
 
 void parse_cli(int argc, char **argv, cli_args_t *args);
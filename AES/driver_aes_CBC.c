@@ -6,70 +6,49 @@
  * The IV is chosen at random when encrypting and stored as the first
  * 16 bytes of the ciphertext file.  Decrypt simply reads it back.
  *
+ * --stats prints time, bytes and throughput of every stage (read,
+ * compress, pad, cipher, ...) to stderr, SCCRYPTO_PERF=1 in the
+ * environment adds hardware counters, and --trace FILE writes the stages
+ * as Chrome trace events, the cipher one span per chunk. The AES core
+ * comes from libsccrypto; --stats also lists the kernels it bound.
  */
 #include "common.h"
-#include "aes.h"
-#include <fcntl.h>
-#include <unistd.h>
+#include "sccrypto.h"
+#include "compress.h"
+#include "perfcnt.h"
 
-#define IV_BYTES 16
+#define IV_BYTES  16
+#define CBC_CHUNK (1u << 20)   /* bytes per cipher stage call */
 
-/* ---------- PKCS#7 helpers -------------------------------------------- */
-static void pkcs7_pad(uint8_t **buf, size_t *len)
-{
-    size_t pad = AES_BLOCK_SIZE - (*len % AES_BLOCK_SIZE);
-    if (pad == 0) pad = AES_BLOCK_SIZE;
-    *buf = realloc(*buf, *len + pad);
-    memset(*buf + *len, (uint8_t)pad, pad);
-    *len += pad;
-}
-
-static int pkcs7_unpad(uint8_t *buf, size_t *len)
-{
-    if (*len == 0 || *len % AES_BLOCK_SIZE) return -1;
-    uint8_t pad = buf[*len - 1];
-    if (pad == 0 || pad > AES_BLOCK_SIZE)   return -1;
-    for (size_t i = 1; i <= pad; ++i)
-        if (buf[*len - i] != pad) return -1;
-    *len -= pad;
-    return 0;
-}
+static perf_profile_t prof;
 
-/* ---------- Random IV -------------------------------------------------- */
-static void random_bytes(uint8_t *dst, size_t n)
+static void report_profile(void)
 {
-    int fd = open("/dev/urandom", O_RDONLY);
-    if (fd < 0 || read(fd, dst, n) != (ssize_t)n) {
-        perror("/dev/urandom"); exit(EXIT_FAILURE);
-    }
-    close(fd);
+    if (prof.stats) sccrypto_report(stderr);
+    perf_profile_finish(&prof, stderr);
 }
 
-/* ---------- CBC core --------------------------------------------------- */
-static void cbc_encrypt(uint8_t *buf, size_t len,
-                        const aes_key_t *ks, const uint8_t iv[16])
+/* In-place CBC over the buffer in CBC_CHUNK pieces, one profile stage
+ * call each. The last ciphertext block of a piece chains into the next,
+ * so the result is the same as one cbc_encrypt / cbc_decrypt call. */
+static void cbc_chunks(uint8_t *buf, size_t len, const aes_key_t *ks,
+                       const uint8_t iv[IV_BYTES], int decrypt)
 {
-    uint8_t chain[16];
-    memcpy(chain, iv, 16);
-
-    for (size_t off = 0; off < len; off += AES_BLOCK_SIZE) {
-        for (int i = 0; i < 16; ++i) buf[off + i] ^= chain[i];
-        aes_encrypt_block(ks, buf + off, buf + off);
-        memcpy(chain, buf + off, 16);
-    }
-}
-
-static void cbc_decrypt(uint8_t *buf, size_t len,
-                        const aes_key_t *ks, const uint8_t iv[16])
-{
-    uint8_t chain[16], next_chain[16];
-    memcpy(chain, iv, 16);
-
-    for (size_t off = 0; off < len; off += AES_BLOCK_SIZE) {
-        memcpy(next_chain, buf + off, 16);
-        aes_decrypt_block(ks, buf + off, buf + off);
-        for (int i = 0; i < 16; ++i) buf[off + i] ^= chain[i];
-        memcpy(chain, next_chain, 16);
+    uint8_t chain[IV_BYTES], next[IV_BYTES];
+    memcpy(chain, iv, IV_BYTES);
+    for (size_t off = 0; off < len; off += CBC_CHUNK) {
+        size_t n = len - off < CBC_CHUNK ? len - off : CBC_CHUNK;
+        uint8_t *last = buf + off + n - AES_BLOCK_SIZE;
+        perf_profile_begin(&prof, decrypt ? "decrypt" : "encrypt");
+        if (decrypt) {
+            memcpy(next, last, IV_BYTES);
+            cbc_decrypt(buf + off, n, ks, chain);
+        } else {
+            cbc_encrypt(buf + off, n, ks, chain);
+            memcpy(next, last, IV_BYTES);
+        }
+        perf_profile_end(&prof, n);
+        memcpy(chain, next, IV_BYTES);
     }
 }
 
@@ -77,9 +56,12 @@ static void cbc_decrypt(uint8_t *buf, size_t len,
 int main(int argc, char **argv)
 {
     cli_args_t a = {0};
+    perf_profile_init(&prof, &argc, argv);
     parse_cli(argc, argv, &a);
+    atexit(report_profile);
 
     /* --- key ----------------------------------------------------------- */
+    perf_profile_begin(&prof, "key_setup");
     size_t klen; uint8_t *kbuf = read_file(a.key_fname, &klen);
     if (klen != 16 && klen != 24 && klen != 32) {
         fprintf(stderr, "Key length must be 16, 24 or 32 bytes\n");
@@ -87,25 +69,42 @@ int main(int argc, char **argv)
     }
     aes_key_t ks;
     aes_key_setup(&ks, kbuf, klen * 8);
+    perf_profile_end(&prof, 0);
 
     /* ------------------------------------------------------------------- */
     if (a.mode == MODE_ENCRYPT) {
+        perf_profile_begin(&prof, "read");
         size_t ilen; uint8_t *ibuf = read_file(a.in_fname, &ilen);
+        perf_profile_end(&prof, ilen);
+        if (compress_needed(ibuf, ilen, a.compress)) {
+            perf_profile_begin(&prof, "compress");
+            size_t zlen; uint8_t *zbuf = compress_chunks(ibuf, ilen, &zlen);
+            perf_profile_end(&prof, ilen);
+            if (!zbuf) { fprintf(stderr, "Compression failed\n"); return EXIT_FAILURE; }
+            free(ibuf);
+            ibuf = zbuf; ilen = zlen;
+        }
+        perf_profile_begin(&prof, "pad");
         pkcs7_pad(&ibuf, &ilen);
+        perf_profile_end(&prof, 0);
 
         uint8_t iv[IV_BYTES];
         random_bytes(iv, IV_BYTES);
-        cbc_encrypt(ibuf, ilen, &ks, iv);
+        cbc_chunks(ibuf, ilen, &ks, iv, 0);
 
         /* IV ⧺ ciphertext */
+        perf_profile_begin(&prof, "write");
         FILE *out = fopen(a.out_fname, "wb");
         if (!out) { perror(a.out_fname); exit(EXIT_FAILURE); }
         fwrite(iv, 1, IV_BYTES, out);
         fwrite(ibuf, 1, ilen, out);
         fclose(out);
+        perf_profile_end(&prof, IV_BYTES + ilen);
         free(ibuf);
     } else { /* MODE_DECRYPT */
+        perf_profile_begin(&prof, "read");
         size_t clen; uint8_t *cbuf = read_file(a.in_fname, &clen);
+        perf_profile_end(&prof, clen);
         if (clen < IV_BYTES || (clen - IV_BYTES) % AES_BLOCK_SIZE) {
             fprintf(stderr, "Ciphertext length invalid\n");
             return EXIT_FAILURE;
@@ -115,12 +114,31 @@ int main(int argc, char **argv)
         uint8_t *pbuf = cbuf + IV_BYTES;
         size_t  plen = clen - IV_BYTES;
 
-        cbc_decrypt(pbuf, plen, &ks, iv);
-        if (pkcs7_unpad(pbuf, &plen) != 0) {
+        cbc_chunks(pbuf, plen, &ks, iv, 1);
+        perf_profile_begin(&prof, "unpad");
+        int bad_pad = pkcs7_unpad(pbuf, &plen) != 0;
+        perf_profile_end(&prof, 0);
+        if (bad_pad) {
             fprintf(stderr, "Bad padding — wrong key or tampered data?\n");
             return EXIT_FAILURE;
         }
-        write_file(a.out_fname, pbuf, plen);
+        if (compress_is_container(pbuf, plen)) {   /* encrypted with -z */
+            perf_profile_begin(&prof, "decompress");
+            size_t zlen; uint8_t *zbuf = decompress_chunks(pbuf, plen, &zlen);
+            perf_profile_end(&prof, plen);
+            if (!zbuf) {
+                fprintf(stderr, "Bad compressed stream — wrong key or corrupt file?\n");
+                return EXIT_FAILURE;
+            }
+            perf_profile_begin(&prof, "write");
+            write_file(a.out_fname, zbuf, zlen);
+            perf_profile_end(&prof, zlen);
+            free(zbuf);
+        } else {
+            perf_profile_begin(&prof, "write");
+            write_file(a.out_fname, pbuf, plen);
+            perf_profile_end(&prof, plen);
+        }
         free(cbuf); /* frees both buffers, since pbuf is inside cbuf */
     }
 
@@ -1,25 +1,6 @@
 #include "common.h"
-#include "aes.h"
-
-static void pkcs7_pad(uint8_t **buf, size_t *len)
-{
-    size_t pad = AES_BLOCK_SIZE - (*len % AES_BLOCK_SIZE);
-    if (pad == 0) pad = AES_BLOCK_SIZE;
-    *buf = realloc(*buf, *len + pad);
-    memset(*buf + *len, (uint8_t)pad, pad);
-    *len += pad;
-}
-
-static int pkcs7_unpad(uint8_t *buf, size_t *len)
-{
-    if (*len == 0 || *len % AES_BLOCK_SIZE) return -1;
-    uint8_t pad = buf[*len - 1];
-    if (pad == 0 || pad > AES_BLOCK_SIZE)   return -1;
-    for (size_t i = 1; i <= pad; ++i)
-        if (buf[*len - i] != pad) return -1;
-    *len -= pad;
-    return 0;
-}
+#include "sccrypto.h"
+#include "compress.h"
 
 int main(int argc, char **argv)
 {
@@ -44,6 +25,12 @@ int main(int argc, char **argv)
     uint8_t *obuf = NULL;
 
     if (a.mode == MODE_ENCRYPT) {
+        if (compress_needed(ibuf, ilen, a.compress)) {
+            size_t zlen; uint8_t *zbuf = compress_chunks(ibuf, ilen, &zlen);
+            if (!zbuf) { fprintf(stderr, "Compression failed\n"); return EXIT_FAILURE; }
+            free(ibuf);
+            ibuf = zbuf; ilen = zlen;
+        }
         pkcs7_pad(&ibuf, &ilen);
         olen = ilen;
     } else if (ilen % AES_BLOCK_SIZE) {
@@ -66,6 +53,15 @@ int main(int argc, char **argv)
             fprintf(stderr, "Bad padding – wrong key or tampered data?\n");
             return EXIT_FAILURE;
         }
+        if (compress_is_container(obuf, olen)) {   /* encrypted with -z */
+            size_t zlen; uint8_t *zbuf = decompress_chunks(obuf, olen, &zlen);
+            if (!zbuf) {
+                fprintf(stderr, "Bad compressed stream – wrong key or corrupt file?\n");
+                return EXIT_FAILURE;
+            }
+            free(obuf);
+            obuf = zbuf; olen = zlen;
+        }
     }
 
     write_file(a.out_fname, obuf, olen);
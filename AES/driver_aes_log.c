@@ -0,0 +1,379 @@
+/* driver_aes_log.c – append-only encrypted log
+ *
+ *   append: aes_log -a -k key.bin -o app.log [-i input|-] [-n every]
+ *   read:   aes_log -r -k key.bin -i app.log [-o output|-] [-f]
+ *
+ * Append never reads previous records: it only checks the fixed file
+ * header, then writes every input line as an independently authenticated
+ * segment with a single O_APPEND write().  Every `every` records (and at
+ * the end of the run) a footer binding the session's records together is
+ * written and the file is fsync'd.  The reader verifies each segment and,
+ * with -f, keeps following the file as it grows.
+ *
+ * Layout (integers little-endian):
+ *
+ *   header   "SCLG" u32 version | log_id[16] | CMAC[16]
+ *   segment  u8 type | 3 zero | u32 body_len | u64 seq | session[8]
+ *            body | CMAC(log_id ⧺ segment header ⧺ body)[16]
+ *
+ *   record body: IV | CBC(PKCS#7(line))             seq = record number
+ *   footer body: chain[16]                          seq = record count
+ *
+ * chain starts at zero and absorbs each record tag of the session as
+ * chain = CMAC(chain ⧺ tag), so a verified footer proves that no earlier
+ * record of that session was dropped or reordered.  Encryption and MAC
+ * keys are derived from the key file with aes_derive_key().
+ */
+#define _POSIX_C_SOURCE 200809L
+#include "byteorder.h"
+#include "common.h"
+#include "sccrypto.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#define IV_BYTES        16
+#define TAG_BYTES       16
+#define LOG_MAGIC       "SCLG"
+#define LOG_VERSION     1
+#define LOG_HDR_SIZE    40
+#define SEG_HDR_SIZE    24
+#define SEG_RECORD      1
+#define SEG_FOOTER      2
+#define LOG_MAX_RECORD  (64u << 10)   /* longer lines are split */
+#define LOG_FOOTER_EVERY 64
+#define LOG_POLL_NS     200000000L
+
+typedef struct {
+    aes_key_t enc, mac;
+    uint8_t   log_id[16];
+} log_keys_t;
+
+typedef struct {
+    uint8_t  id[8];
+    uint64_t count;
+    uint64_t sealed;       /* records covered by the last verified footer */
+    uint8_t  chain[16];
+} session_t;
+
+static void die(const char *msg) { fprintf(stderr, "%s\n", msg); exit(EXIT_FAILURE); }
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+        "Usage: %s -a -k <key> -o <log> [-i <input>|-] [-n <footer every>]\n"
+        "       %s -r -k <key> -i <log> [-o <output>|-] [-f]\n", prog, prog);
+    exit(EXIT_FAILURE);
+}
+
+static int tags_equal(const uint8_t *a, const uint8_t *b)
+{
+    uint8_t d = 0;
+    for (int i = 0; i < TAG_BYTES; ++i) d |= a[i] ^ b[i];
+    return d == 0;
+}
+
+static void chain_absorb(const log_keys_t *k, uint8_t chain[16], const uint8_t tag[16])
+{
+    uint8_t buf[32];
+    memcpy(buf, chain, 16);
+    memcpy(buf + 16, tag, 16);
+    aes_cmac(&k->mac, buf, sizeof buf, chain);
+}
+
+static void header_tag(const log_keys_t *k, const uint8_t hdr[LOG_HDR_SIZE], uint8_t tag[16])
+{
+    aes_cmac(&k->mac, hdr, LOG_HDR_SIZE - TAG_BYTES, tag);
+}
+
+static void write_all(int fd, const uint8_t *p, size_t len)
+{
+    while (len) {
+        ssize_t w = write(fd, p, len);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) die("Write error");
+        p += w; len -= (size_t)w;
+    }
+}
+
+/* ---------- append ----------------------------------------------------- */
+/* Builds log_id ⧺ segment in buf, MACs it and appends the segment with a
+ * single write() so concurrent appenders never interleave inside it. */
+static void append_segment(int fd, const log_keys_t *k, uint8_t *buf, uint8_t type,
+                           size_t body_len, uint64_t seq, const session_t *s, uint8_t tag[16])
+{
+    uint8_t *seg = buf + 16;
+    memcpy(buf, k->log_id, 16);
+    memset(seg, 0, SEG_HDR_SIZE);
+    seg[0] = type;
+    put_u32(seg + 4, (uint32_t)body_len);
+    put_u64(seg + 8, seq);
+    memcpy(seg + 16, s->id, 8);
+    aes_cmac(&k->mac, buf, 16 + SEG_HDR_SIZE + body_len, tag);
+    memcpy(seg + SEG_HDR_SIZE + body_len, tag, TAG_BYTES);
+    write_all(fd, seg, SEG_HDR_SIZE + body_len + TAG_BYTES);
+}
+
+static void append_footer(int fd, const log_keys_t *k, uint8_t *buf, const session_t *s)
+{
+    uint8_t tag[16];
+    memcpy(buf + 16 + SEG_HDR_SIZE, s->chain, 16);
+    append_segment(fd, k, buf, SEG_FOOTER, 16, s->count, s, tag);
+    if (fsync(fd) != 0) perror("fsync");
+}
+
+/* Creates a new log with its header already in place: the header goes to
+ * a temporary file (O_CREAT | O_EXCL through mkstemp) that is then linked
+ * to log_fname, so no appender ever sees a log without a header, and an
+ * existing log is never replaced.  Losing the race to another appender
+ * that created it first is fine, its header is used. */
+static void log_create(const char *log_fname, const log_keys_t *k)
+{
+    size_t len = strlen(log_fname);
+    char *tmp = malloc(len + sizeof ".XXXXXX");
+    if (!tmp) die("Memory allocation failed");
+    memcpy(tmp, log_fname, len);
+    memcpy(tmp + len, ".XXXXXX", sizeof ".XXXXXX");
+    int fd = mkstemp(tmp);
+    if (fd < 0) { perror(tmp); exit(EXIT_FAILURE); }
+
+    uint8_t hdr[LOG_HDR_SIZE];
+    memcpy(hdr, LOG_MAGIC, 4);
+    put_u32(hdr + 4, LOG_VERSION);
+    random_bytes(hdr + 8, 16);
+    header_tag(k, hdr, hdr + 24);
+    write_all(fd, hdr, LOG_HDR_SIZE);
+    if (fsync(fd) != 0 || close(fd) != 0 || (link(tmp, log_fname) != 0 && errno != EEXIST)) {
+        perror(log_fname);
+        unlink(tmp);
+        exit(EXIT_FAILURE);
+    }
+    unlink(tmp);
+    free(tmp);
+}
+
+static void log_append(const char *log_fname, const char *in_fname, const aes_key_t *ks,
+                       long every)
+{
+    log_keys_t k;
+    uint8_t sub[32];
+    aes_derive_key(ks, 'E', sub, 32);
+    aes_key_setup(&k.enc, sub, 256);
+    aes_derive_key(ks, 'M', sub, 16);
+    aes_key_setup(&k.mac, sub, 128);
+
+    int fd = open(log_fname, O_RDWR | O_APPEND);
+    if (fd < 0 && errno == ENOENT) {
+        log_create(log_fname, &k);
+        fd = open(log_fname, O_RDWR | O_APPEND);
+    }
+    if (fd < 0) { perror(log_fname); exit(EXIT_FAILURE); }
+
+    uint8_t hdr[LOG_HDR_SIZE], tag[16];
+    if (pread(fd, hdr, LOG_HDR_SIZE, 0) != LOG_HDR_SIZE || memcmp(hdr, LOG_MAGIC, 4) ||
+        get_u32(hdr + 4) != LOG_VERSION) {
+        die("Not an encrypted log");
+    }
+    header_tag(&k, hdr, tag);
+    if (!tags_equal(tag, hdr + 24)) die("Log header does not verify — wrong key?");
+    memcpy(k.log_id, hdr + 8, 16);
+
+    FILE *in = strcmp(in_fname, "-") ? fopen(in_fname, "rb") : stdin;
+    if (!in) { perror(in_fname); exit(EXIT_FAILURE); }
+
+    session_t s = { {0}, 0, 0, {0} };
+    random_bytes(s.id, sizeof s.id);
+    uint8_t *buf = malloc(16 + SEG_HDR_SIZE + IV_BYTES + LOG_MAX_RECORD + AES_BLOCK_SIZE + TAG_BYTES);
+    if (!buf) die("Memory allocation failed");
+
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t n;
+    while ((n = getline(&line, &cap, in)) > 0) {
+        for (size_t off = 0; off < (size_t)n; off += LOG_MAX_RECORD) {
+            size_t len = (size_t)n - off < LOG_MAX_RECORD ? (size_t)n - off : LOG_MAX_RECORD;
+            uint8_t *iv = buf + 16 + SEG_HDR_SIZE, *ct = iv + IV_BYTES;
+            size_t pad = AES_BLOCK_SIZE - len % AES_BLOCK_SIZE;
+            memcpy(ct, line + off, len);
+            memset(ct + len, (uint8_t)pad, pad);
+            /* IV = E(session ⧺ seq): unique per record, no syscall per line */
+            memcpy(iv, s.id, 8);
+            put_u64(iv + 8, s.count);
+            aes_encrypt_block(&k.enc, iv, iv);
+            cbc_encrypt(ct, len + pad, &k.enc, iv);
+
+            append_segment(fd, &k, buf, SEG_RECORD, IV_BYTES + len + pad, s.count, &s, tag);
+            chain_absorb(&k, s.chain, tag);
+            if (++s.count % (uint64_t)every == 0) append_footer(fd, &k, buf, &s);
+        }
+    }
+    if (s.count % (uint64_t)every != 0 || s.count == 0) append_footer(fd, &k, buf, &s);
+
+    printf("Appended %llu records to %s\n", (unsigned long long)s.count, log_fname);
+    free(line);
+    free(buf);
+    if (in != stdin) fclose(in);
+    close(fd);
+}
+
+/* ---------- read / follow ---------------------------------------------- */
+/* Reads exactly len bytes; at end of file either returns the short count
+ * or, when following, waits for the writer to append more. */
+static size_t read_follow(int fd, uint8_t *dst, size_t len, int follow)
+{
+    size_t got = 0;
+    struct timespec poll = { 0, LOG_POLL_NS };
+    while (got < len) {
+        ssize_t r = read(fd, dst + got, len - got);
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0) die("Read error");
+        if (r == 0) {
+            if (!follow) break;
+            nanosleep(&poll, NULL);
+            continue;
+        }
+        got += (size_t)r;
+    }
+    return got;
+}
+
+static session_t *find_session(session_t **v, size_t *n, const uint8_t id[8])
+{
+    for (size_t i = 0; i < *n; ++i)
+        if (!memcmp((*v)[i].id, id, 8)) return &(*v)[i];
+    *v = realloc(*v, (*n + 1) * sizeof **v);
+    if (!*v) die("Memory allocation failed");
+    session_t *s = &(*v)[(*n)++];
+    memcpy(s->id, id, 8);
+    s->count = s->sealed = 0;
+    memset(s->chain, 0, 16);
+    return s;
+}
+
+static void log_read(const char *log_fname, const char *out_fname, const aes_key_t *ks, int follow)
+{
+    log_keys_t k;
+    int fd = open(log_fname, O_RDONLY);
+    if (fd < 0) { perror(log_fname); exit(EXIT_FAILURE); }
+
+    uint8_t sub[32];
+    aes_derive_key(ks, 'E', sub, 32);
+    aes_key_setup(&k.enc, sub, 256);
+    aes_derive_key(ks, 'M', sub, 16);
+    aes_key_setup(&k.mac, sub, 128);
+
+    uint8_t hdr[LOG_HDR_SIZE], tag[16];
+    if (read_follow(fd, hdr, LOG_HDR_SIZE, follow) != LOG_HDR_SIZE ||
+        memcmp(hdr, LOG_MAGIC, 4) || get_u32(hdr + 4) != LOG_VERSION)
+        die("Not an encrypted log");
+    header_tag(&k, hdr, tag);
+    if (!tags_equal(tag, hdr + 24)) die("Log header does not verify — wrong key?");
+    memcpy(k.log_id, hdr + 8, 16);
+
+    FILE *out = strcmp(out_fname, "-") ? fopen(out_fname, "wb") : stdout;
+    if (!out) { perror(out_fname); exit(EXIT_FAILURE); }
+
+    size_t max_body = IV_BYTES + LOG_MAX_RECORD + AES_BLOCK_SIZE;
+    uint8_t *buf = malloc(16 + SEG_HDR_SIZE + max_body + TAG_BYTES);
+    if (!buf) die("Memory allocation failed");
+    memcpy(buf, k.log_id, 16);
+
+    session_t *sessions = NULL;
+    size_t nsessions = 0;
+    uint64_t records = 0, footers = 0;
+    for (;;) {
+        uint8_t *seg = buf + 16;
+        size_t got = read_follow(fd, seg, SEG_HDR_SIZE, follow);
+        if (got == 0) break;
+        if (got < SEG_HDR_SIZE) { fprintf(stderr, "Ignoring truncated final segment\n"); break; }
+
+        uint8_t type = seg[0];
+        size_t body_len = get_u32(seg + 4);
+        uint64_t seq = get_u64(seg + 8);
+        if ((type != SEG_RECORD && type != SEG_FOOTER) || body_len > max_body ||
+            (type == SEG_FOOTER && body_len != 16))
+            die("Corrupt segment header");
+        if (read_follow(fd, seg + SEG_HDR_SIZE, body_len + TAG_BYTES, follow) != body_len + TAG_BYTES) {
+            fprintf(stderr, "Ignoring truncated final segment\n");
+            break;
+        }
+        aes_cmac(&k.mac, buf, 16 + SEG_HDR_SIZE + body_len, tag);
+        if (!tags_equal(tag, seg + SEG_HDR_SIZE + body_len))
+            die("Segment authentication failed — tampered data?");
+
+        session_t *s = find_session(&sessions, &nsessions, seg + 16);
+        if (type == SEG_FOOTER) {
+            if (seq != s->count || !tags_equal(seg + SEG_HDR_SIZE, s->chain))
+                die("Footer does not match the records before it — records missing?");
+            s->sealed = s->count;
+            ++footers;
+            continue;
+        }
+        if (seq != s->count) die("Record out of sequence — records missing or reordered?");
+
+        uint8_t *iv = seg + SEG_HDR_SIZE, *ct = iv + IV_BYTES;
+        size_t len = body_len - IV_BYTES;
+        if (body_len < IV_BYTES + AES_BLOCK_SIZE || len % AES_BLOCK_SIZE) die("Corrupt record");
+        cbc_decrypt(ct, len, &k.enc, iv);
+        if (pkcs7_unpad(ct, &len) != 0) die("Bad padding in authenticated record");
+        if (fwrite(ct, 1, len, out) != len) die("Write error");
+        if (follow) fflush(out);
+
+        chain_absorb(&k, s->chain, tag);
+        s->count++;
+        records++;
+    }
+
+    for (size_t i = 0; i < nsessions; ++i)
+        if (sessions[i].count != sessions[i].sealed)
+            fprintf(stderr, "Warning: %llu trailing records are not covered by a footer yet\n",
+                    (unsigned long long)(sessions[i].count - sessions[i].sealed));
+    if (out != stdout) {
+        fclose(out);
+        printf("Read %llu records (%llu footers verified)\n",
+               (unsigned long long)records, (unsigned long long)footers);
+    }
+    free(sessions);
+    free(buf);
+    close(fd);
+}
+
+/* ---------- main ------------------------------------------------------- */
+int main(int argc, char **argv)
+{
+    char op = 0;
+    const char *key_fname = NULL, *in_fname = NULL, *out_fname = NULL;
+    long every = LOG_FOOTER_EVERY;
+    int follow = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-a") || !strcmp(argv[i], "-r")) op = argv[i][1];
+        else if (!strcmp(argv[i], "-f")) follow = 1;
+        else if (i + 1 >= argc) usage(argv[0]);
+        else if (!strcmp(argv[i], "-k")) key_fname = argv[++i];
+        else if (!strcmp(argv[i], "-i")) in_fname = argv[++i];
+        else if (!strcmp(argv[i], "-o")) out_fname = argv[++i];
+        else if (!strcmp(argv[i], "-n")) every = strtol(argv[++i], NULL, 10);
+        else usage(argv[0]);
+    }
+    if (!op || !key_fname) usage(argv[0]);
+    if (op == 'a' && !out_fname) usage(argv[0]);
+    if (op == 'r' && !in_fname) usage(argv[0]);
+    if (every < 1) every = 1;
+
+    size_t klen; uint8_t *kbuf = read_file(key_fname, &klen);
+    if (klen != 16 && klen != 24 && klen != 32) {
+        fprintf(stderr, "Key length must be 16, 24 or 32 bytes\n");
+        return EXIT_FAILURE;
+    }
+    aes_key_t ks;
+    aes_key_setup(&ks, kbuf, klen * 8);
+    free(kbuf);
+
+    if (op == 'a')
+        log_append(out_fname, in_fname ? in_fname : "-", &ks, every);
+    else
+        log_read(in_fname, out_fname ? out_fname : "-", &ks, follow);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,203 @@
+/* driver_aes_sparse.c – sparse-file aware AES-CBC tool
+ *
+ *   encrypt: aes_sparse -e -i disk.img  -k key.bin -o disk.scsp
+ *   decrypt: aes_sparse -d -i disk.scsp -k key.bin -o disk.img
+ *
+ * Only the allocated ranges of the input are read and encrypted; they are
+ * found with lseek(SEEK_DATA/SEEK_HOLE).  Holes are recorded implicitly
+ * as the gaps between segments, and decrypt recreates them by sizing the
+ * output with ftruncate() and writing each segment at its offset.
+ *
+ * Layout (integers little-endian, segment offsets are not encrypted):
+ *
+ *   "SCSP" u32 version | u64 logical_size | u64 nsegments
+ *   nsegments * ( u64 offset | u64 length | IV | CBC(PKCS#7(data)) )
+ *
+ * Extents longer than SPARSE_SEGMENT are split so memory stays bounded.
+ */
+#define _GNU_SOURCE
+#include "byteorder.h"
+#include "common.h"
+#include "sccrypto.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define IV_BYTES       16
+#define SPARSE_MAGIC   "SCSP"
+#define SPARSE_VERSION 1
+#define SPARSE_SEGMENT (4u << 20)
+
+typedef struct {
+    uint64_t off, len;
+} extent_t;
+
+static void die(const char *msg) { fprintf(stderr, "%s\n", msg); exit(EXIT_FAILURE); }
+
+static void read_at(int fd, uint8_t *dst, size_t len, uint64_t off)
+{
+    while (len) {
+        ssize_t r = pread(fd, dst, len, (off_t)off);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) die("Read error");
+        dst += r; len -= (size_t)r; off += (uint64_t)r;
+    }
+}
+
+static void write_at(int fd, const uint8_t *src, size_t len, uint64_t off)
+{
+    while (len) {
+        ssize_t w = pwrite(fd, src, len, (off_t)off);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) die("Write error");
+        src += w; len -= (size_t)w; off += (uint64_t)w;
+    }
+}
+
+/* ---------- extent walk ------------------------------------------------ */
+/* Collects the data segments of fd, split at SPARSE_SEGMENT.  Filesystems
+ * without SEEK_DATA support report the whole file as one data extent. */
+static extent_t *map_extents(int fd, uint64_t size, size_t *count)
+{
+    size_t n = 0, cap = 64;
+    extent_t *v = malloc(cap * sizeof *v);
+    if (!v) die("Memory allocation failed");
+
+    uint64_t pos = 0;
+    while (pos < size) {
+        uint64_t data = pos, hole = size;
+#ifdef SEEK_DATA
+        off_t d = lseek(fd, (off_t)pos, SEEK_DATA);
+        if (d < 0 && errno == ENXIO) break;             /* only holes remain */
+        if (d >= 0) {
+            off_t h = lseek(fd, d, SEEK_HOLE);
+            data = (uint64_t)d;
+            hole = h >= 0 ? (uint64_t)h : size;
+        }
+#endif
+        if (hole > size) hole = size;
+        for (uint64_t off = data; off < hole; off += SPARSE_SEGMENT) {
+            if (n == cap) {
+                cap *= 2;
+                v = realloc(v, cap * sizeof *v);
+                if (!v) die("Memory allocation failed");
+            }
+            v[n].off = off;
+            v[n].len = hole - off < SPARSE_SEGMENT ? hole - off : SPARSE_SEGMENT;
+            ++n;
+        }
+        pos = hole;
+    }
+    *count = n;
+    return v;
+}
+
+/* ---------- encrypt / decrypt ----------------------------------------- */
+static void sparse_encrypt(const char *in_fname, const char *out_fname, const aes_key_t *ks)
+{
+    int fd = open(in_fname, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) { perror(in_fname); exit(EXIT_FAILURE); }
+    uint64_t size = (uint64_t)st.st_size;
+
+    size_t nseg;
+    extent_t *seg = map_extents(fd, size, &nseg);
+
+    FILE *out = fopen(out_fname, "wb");
+    if (!out) { perror(out_fname); exit(EXIT_FAILURE); }
+    uint8_t hdr[24];
+    memcpy(hdr, SPARSE_MAGIC, 4);
+    put_u32(hdr + 4, SPARSE_VERSION);
+    put_u64(hdr + 8, size);
+    put_u64(hdr + 16, nseg);
+    if (fwrite(hdr, 1, sizeof hdr, out) != sizeof hdr) die("Write error");
+
+    uint8_t *buf = malloc(SPARSE_SEGMENT + AES_BLOCK_SIZE);
+    if (!buf) die("Memory allocation failed");
+    uint64_t data_bytes = 0;
+    for (size_t i = 0; i < nseg; ++i) {
+        size_t len = (size_t)seg[i].len;
+        read_at(fd, buf, len, seg[i].off);
+        data_bytes += len;
+
+        uint8_t meta[16 + IV_BYTES];
+        put_u64(meta, seg[i].off);
+        put_u64(meta + 8, seg[i].len);
+        random_bytes(meta + 16, IV_BYTES);
+
+        /* pad in place: buf always has a spare block */
+        size_t pad = AES_BLOCK_SIZE - len % AES_BLOCK_SIZE;
+        memset(buf + len, (uint8_t)pad, pad);
+        len += pad;
+        cbc_encrypt(buf, len, ks, meta + 16);
+        if (fwrite(meta, 1, sizeof meta, out) != sizeof meta || fwrite(buf, 1, len, out) != len)
+            die("Write error");
+    }
+    fclose(out);
+    close(fd);
+    printf("Encrypted %llu data bytes in %zu segments (%llu bytes logical)\n",
+           (unsigned long long)data_bytes, nseg, (unsigned long long)size);
+    free(buf);
+    free(seg);
+}
+
+static void sparse_decrypt(const char *in_fname, const char *out_fname, const aes_key_t *ks)
+{
+    FILE *in = fopen(in_fname, "rb");
+    if (!in) { perror(in_fname); exit(EXIT_FAILURE); }
+    uint8_t hdr[24];
+    if (fread(hdr, 1, sizeof hdr, in) != sizeof hdr || memcmp(hdr, SPARSE_MAGIC, 4) ||
+        get_u32(hdr + 4) != SPARSE_VERSION)
+        die("Not a sparse AES file");
+    uint64_t size = get_u64(hdr + 8), nseg = get_u64(hdr + 16);
+
+    int fd = open(out_fname, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) { perror(out_fname); exit(EXIT_FAILURE); }
+    if (ftruncate(fd, (off_t)size) != 0) { perror(out_fname); exit(EXIT_FAILURE); }
+
+    uint8_t *buf = malloc(SPARSE_SEGMENT + AES_BLOCK_SIZE);
+    if (!buf) die("Memory allocation failed");
+    for (uint64_t i = 0; i < nseg; ++i) {
+        uint8_t meta[16 + IV_BYTES];
+        if (fread(meta, 1, sizeof meta, in) != sizeof meta) die("Truncated input");
+        uint64_t off = get_u64(meta), len = get_u64(meta + 8);
+        if (len == 0 || len > SPARSE_SEGMENT || off > size || len > size - off)
+            die("Corrupt segment table");
+
+        size_t clen = (size_t)len + AES_BLOCK_SIZE - (size_t)len % AES_BLOCK_SIZE;
+        if (fread(buf, 1, clen, in) != clen) die("Truncated input");
+        cbc_decrypt(buf, clen, ks, meta + 16);
+        if (pkcs7_unpad(buf, &clen) != 0 || clen != len)
+            die("Bad padding — wrong key or tampered data?");
+        write_at(fd, buf, clen, off);
+    }
+    if (fgetc(in) != EOF) die("Trailing data after last segment");
+    fclose(in);
+    close(fd);
+    free(buf);
+}
+
+/* ---------- main ------------------------------------------------------- */
+int main(int argc, char **argv)
+{
+    cli_args_t a = {0};
+    parse_cli(argc, argv, &a);
+
+    /* --- key ----------------------------------------------------------- */
+    size_t klen; uint8_t *kbuf = read_file(a.key_fname, &klen);
+    if (klen != 16 && klen != 24 && klen != 32) {
+        fprintf(stderr, "Key length must be 16, 24 or 32 bytes\n");
+        return EXIT_FAILURE;
+    }
+    aes_key_t ks;
+    aes_key_setup(&ks, kbuf, klen * 8);
+    free(kbuf);
+
+    if (a.compress) fprintf(stderr, "Note: -z is ignored in sparse mode\n");
+    if (a.mode == MODE_ENCRYPT)
+        sparse_encrypt(a.in_fname, a.out_fname, &ks);
+    else
+        sparse_decrypt(a.in_fname, a.out_fname, &ks);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+/* modes.c – CBC core, CMAC, PKCS#7 padding and IV generation shared by
+ * the AES drivers. */
+#include "modes.h"
+#include "common.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+/* ---------- PKCS#7 helpers -------------------------------------------- */
+void pkcs7_pad(uint8_t **buf, size_t *len)
+{
+    size_t pad = AES_BLOCK_SIZE - (*len % AES_BLOCK_SIZE);
+    if (pad == 0) pad = AES_BLOCK_SIZE;
+    *buf = realloc(*buf, *len + pad);
+    memset(*buf + *len, (uint8_t)pad, pad);
+    *len += pad;
+}
+
+int pkcs7_unpad(uint8_t *buf, size_t *len)
+{
+    if (*len == 0 || *len % AES_BLOCK_SIZE) return -1;
+    uint8_t pad = buf[*len - 1];
+    if (pad == 0 || pad > AES_BLOCK_SIZE)   return -1;
+    for (size_t i = 1; i <= pad; ++i)
+        if (buf[*len - i] != pad) return -1;
+    *len -= pad;
+    return 0;
+}
+
+/* ---------- Random IV -------------------------------------------------- */
+void random_bytes(uint8_t *dst, size_t n)
+{
+    int fd = open("/dev/urandom", O_RDONLY);
+    if (fd < 0 || read(fd, dst, n) != (ssize_t)n) {
+        perror("/dev/urandom"); exit(EXIT_FAILURE);
+    }
+    close(fd);
+}
+
+/* ---------- CBC core --------------------------------------------------- */
+void cbc_encrypt(uint8_t *buf, size_t len,
+                 const aes_key_t *ks, const uint8_t iv[16])
+{
+    uint8_t chain[16];
+    memcpy(chain, iv, 16);
+
+    for (size_t off = 0; off < len; off += AES_BLOCK_SIZE) {
+        for (int i = 0; i < 16; ++i) buf[off + i] ^= chain[i];
+        aes_encrypt_block(ks, buf + off, buf + off);
+        memcpy(chain, buf + off, 16);
+    }
+}
+
+void cbc_decrypt(uint8_t *buf, size_t len,
+                 const aes_key_t *ks, const uint8_t iv[16])
+{
+    uint8_t chain[16], next_chain[16];
+    memcpy(chain, iv, 16);
+
+    for (size_t off = 0; off < len; off += AES_BLOCK_SIZE) {
+        memcpy(next_chain, buf + off, 16);
+        aes_decrypt_block(ks, buf + off, buf + off);
+        for (int i = 0; i < 16; ++i) buf[off + i] ^= chain[i];
+        memcpy(chain, next_chain, 16);
+    }
+}
+
+/* ---------- CMAC ------------------------------------------------------- */
+/* Doubling in GF(2^128) used to derive the CMAC subkeys */
+static void cmac_dbl(uint8_t b[16])
+{
+    uint8_t carry = b[0] >> 7;
+    for (int i = 0; i < 15; ++i) b[i] = (uint8_t)((b[i] << 1) | (b[i + 1] >> 7));
+    b[15] = (uint8_t)((b[15] << 1) ^ (carry ? 0x87 : 0));
+}
+
+void aes_cmac(const aes_key_t *ks, const uint8_t *msg, size_t len, uint8_t tag[16])
+{
+    uint8_t k1[16] = {0}, k2[16], x[16] = {0}, last[16];
+    aes_encrypt_block(ks, k1, k1);
+    cmac_dbl(k1);
+    memcpy(k2, k1, 16);
+    cmac_dbl(k2);
+
+    size_t n = (len + 15) / 16;
+    int complete = n > 0 && len % 16 == 0;
+    if (n == 0) n = 1;
+
+    for (size_t b = 0; b + 1 < n; ++b) {
+        for (int i = 0; i < 16; ++i) x[i] ^= msg[16*b + i];
+        aes_encrypt_block(ks, x, x);
+    }
+
+    size_t rem = len - 16*(n - 1);
+    if (complete) {
+        for (int i = 0; i < 16; ++i) last[i] = msg[16*(n - 1) + i] ^ k1[i];
+    } else {
+        memset(last, 0, 16);
+        memcpy(last, msg + 16*(n - 1), rem);
+        last[rem] = 0x80;
+        for (int i = 0; i < 16; ++i) last[i] ^= k2[i];
+    }
+    for (int i = 0; i < 16; ++i) x[i] ^= last[i];
+    aes_encrypt_block(ks, x, tag);
+}
+
+void aes_derive_key(const aes_key_t *ks, uint8_t label, uint8_t *out, size_t len)
+{
+    uint8_t in[16] = {0}, blk[16];
+    in[0] = label;
+    for (size_t off = 0; off < len; off += 16) {
+        in[1] = (uint8_t)(off / 16);
+        aes_encrypt_block(ks, in, blk);
+        memcpy(out + off, blk, len - off < 16 ? len - off : 16);
+    }
+}
@@ -0,0 +1,25 @@
+/****************  modes.h  ****************/
+#ifndef MODES_H
+#define MODES_H
+#include <stdint.h>
+#include <stddef.h>
+#include "aes.h"
+
+/* PKCS#7 – pad grows *buf with realloc, unpad only shrinks *len */
+void pkcs7_pad(uint8_t **buf, size_t *len);
+int  pkcs7_unpad(uint8_t *buf, size_t *len);
+
+/* n bytes from /dev/urandom, exits on failure */
+void random_bytes(uint8_t *dst, size_t n);
+
+/* In-place CBC over whole blocks; len must be a multiple of 16 */
+void cbc_encrypt(uint8_t *buf, size_t len, const aes_key_t *ks, const uint8_t iv[16]);
+void cbc_decrypt(uint8_t *buf, size_t len, const aes_key_t *ks, const uint8_t iv[16]);
+
+/* AES-CMAC (NIST SP 800-38B) over len bytes of msg */
+void aes_cmac(const aes_key_t *ks, const uint8_t *msg, size_t len, uint8_t tag[16]);
+
+/* Derives len bytes of subkey material: block i = E_K(label ⧺ i ⧺ 0…) */
+void aes_derive_key(const aes_key_t *ks, uint8_t label, uint8_t *out, size_t len);
+
+#endif /* MODES_H */
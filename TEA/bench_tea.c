@@ -0,0 +1,188 @@
+#include "bench.h"
+#include "sccrypto.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Throughput / latency sweep over the TEA kernels: every backend this CPU
+// supports x mode x message size (16 B up to -m) x thread count (-t).
+// Thread counts apply to the modes with a multi-threaded path, CTR and
+// CBC decryption, where they split each message across the workers as
+// tea_cbc does; ECB and the serial CBC encryption run on one thread.
+#define DEFAULT_MAX_SIZE (16u << 20)
+
+static const char *const backends[] = { "scalar", "sse2", "avx2", "avx512" };
+
+typedef enum { OP_ECB_ENC, OP_ECB_DEC, OP_CBC_ENC, OP_CBC_DEC, OP_CTR } op_t;
+
+typedef struct {
+    tea_ctx_t ctx;
+    uint8_t key[TEA_KEY_SIZE];
+    uint8_t iv[TEA_BLOCK_SIZE];
+    op_t op;
+    size_t len;
+    int threads;
+    uint8_t *in, *out;
+} sweep_t;
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-n SAMPLES] [-m MAX_SIZE] [-t T1,T2,..] [-f NAME]\n", prog);
+    fprintf(stderr, "          [-j | -o FILE.json] [-c FILE.csv]\n");
+    fprintf(stderr, "  Message sizes run from 16 B to MAX_SIZE (default 16M; K/M/G suffixes,\n");
+    fprintf(stderr, "  up to 1G); -t defaults to 1, 2, 4 .. up to the CPU count. -f runs only\n");
+    fprintf(stderr, "  names containing NAME, e.g. ctr or cbc_decrypt\n");
+    exit(EXIT_FAILURE);
+}
+
+static FILE *open_output(FILE *prev, const char *fname) {
+    FILE *f = prev ? NULL : fopen(fname, "w");
+    if (!f) {
+        if (!prev) perror(fname);
+        exit(EXIT_FAILURE);
+    }
+    return f;
+}
+
+// "64K", "16M", "1G"
+static size_t parse_size(const char *str) {
+    char *end;
+    unsigned long long v = strtoull(str, &end, 10);
+    switch (*end) {
+    case 'K': case 'k': v <<= 10; end++; break;
+    case 'M': case 'm': v <<= 20; end++; break;
+    case 'G': case 'g': v <<= 30; end++; break;
+    }
+    return *end || v < 16 || v > (1ull << 30) ? 0 : (size_t)v;
+}
+
+// Comma-separated thread counts; returns how many were stored
+static int parse_threads(const char *str, int *out, int max) {
+    int n = 0;
+    while (*str && n < max) {
+        char *end;
+        long t = strtol(str, &end, 10);
+        if (end == str || t < 1 || t > TEA_MT_MAX_THREADS) return 0;
+        out[n++] = (int)t;
+        if (*end && *end != ',') return 0;
+        str = *end ? end + 1 : end;
+    }
+    return n;
+}
+
+static void fill_pseudorandom(uint8_t *buf, size_t len, uint64_t seed) {
+    uint64_t x = seed * 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < len; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        buf[i] = (uint8_t)(x >> 32);
+    }
+}
+
+static void run_sweep(void *p, size_t iters) {
+    sweep_t *s = p;
+    size_t blocks = s->len / TEA_BLOCK_SIZE;
+    for (size_t i = 0; i < iters; i++) {
+        switch (s->op) {
+        case OP_ECB_ENC: tea_ecb_encrypt(&s->ctx, s->in, s->out, blocks); break;
+        case OP_ECB_DEC: tea_ecb_decrypt(&s->ctx, s->in, s->out, blocks); break;
+        case OP_CBC_DEC:
+            tea_cbc_decrypt_mt(&s->ctx, s->iv, s->in, s->out, s->len, s->threads);
+            break;
+        case OP_CTR: tea_ctr_crypt(&s->ctx, s->iv, s->in, s->out, s->len, s->threads); break;
+        case OP_CBC_ENC: {
+            // The streaming API as tea_cbc uses it, key setup included
+            tea_cbc_ctx_t c;
+            size_t n, tail;
+            tea_cbc_init(&c, s->key, s->iv, 0);
+            n = tea_cbc_update(&c, s->in, s->len, s->out);
+            tea_cbc_final(&c, s->out + n, &tail);
+            break;
+        }
+        }
+    }
+}
+
+static void run_block(void *p, size_t iters) {
+    sweep_t *s = p;
+    for (size_t i = 0; i < iters; i++) tea_encrypt_block_ctx(&s->ctx, s->out, s->out);
+}
+
+// One mode over every size, and every thread count if it has threads
+static void sweep_sizes(bench_t *b, sweep_t *s, const char *name, op_t op, size_t max_size,
+                        const int *threads, int nthreads) {
+    s->op = op;
+    for (size_t len = 16; len <= max_size; len *= 16) {
+        s->len = len;
+        for (int i = 0; i < nthreads; i++) {
+            s->threads = b->threads = threads[i];
+            bench_run(b, name, len, run_sweep, s, NULL);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    FILE *json = NULL, *csv = NULL;
+    const char *filter = NULL;
+    int samples = BENCH_SAMPLES, to_stdout = 0, nthreads = 0;
+    int thread_list[TEA_MT_MAX_THREADS];
+    static const int one_thread[] = { 1 };
+    size_t max_size = DEFAULT_MAX_SIZE;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) samples = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-m") && i + 1 < argc) {
+            if (!(max_size = parse_size(argv[++i]))) usage(argv[0]);
+        } else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            if (!(nthreads = parse_threads(argv[++i], thread_list, TEA_MT_MAX_THREADS))) usage(argv[0]);
+        } else if (!strcmp(argv[i], "-f") && i + 1 < argc) filter = argv[++i];
+        else if (!strcmp(argv[i], "-j")) to_stdout = 1;
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) json = open_output(json, argv[++i]);
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc) csv = open_output(csv, argv[++i]);
+        else usage(argv[0]);
+    }
+    if (samples <= 0 || (to_stdout && json)) usage(argv[0]);
+    if (!nthreads) {
+        int cpus = bench_cpu_count();
+        for (int t = 1; t < cpus && t < TEA_MT_MAX_THREADS; t *= 2) thread_list[nthreads++] = t;
+        thread_list[nthreads++] = cpus < TEA_MT_MAX_THREADS ? cpus : TEA_MT_MAX_THREADS;
+    }
+
+    static sweep_t s;
+    s.in = malloc(max_size);
+    s.out = malloc(max_size + TEA_BLOCK_SIZE);
+    if (!s.in || !s.out) {
+        fprintf(stderr, "Memory allocation failed (2 x %zu bytes)\n", max_size);
+        return EXIT_FAILURE;
+    }
+    fill_pseudorandom(s.in, max_size, 1);
+    fill_pseudorandom(s.key, sizeof s.key, 2);
+    fill_pseudorandom(s.iv, sizeof s.iv, 3);
+    tea_ctx_init(&s.ctx, s.key);
+
+    bench_t b;
+    bench_init(&b, "tea", to_stdout ? stderr : stdout, to_stdout ? stdout : json, csv);
+    b.samples = samples;
+    b.filter = filter;
+
+    // Paths that do not go through the multi-block kernels
+    b.threads = 1;
+    bench_run(&b, "tea/encrypt_block", TEA_BLOCK_SIZE, run_block, &s, NULL);
+    sweep_sizes(&b, &s, "tea/cbc_encrypt", OP_CBC_ENC, max_size, one_thread, 1);
+
+    for (size_t k = 0; k < sizeof backends / sizeof *backends; k++) {
+        if (tea_ctx_set_backend(&s.ctx, backends[k]) != 0) continue;
+        b.backend = backends[k];
+        sweep_sizes(&b, &s, "tea/ecb_encrypt", OP_ECB_ENC, max_size, one_thread, 1);
+        sweep_sizes(&b, &s, "tea/ecb_decrypt", OP_ECB_DEC, max_size, one_thread, 1);
+        sweep_sizes(&b, &s, "tea/cbc_decrypt", OP_CBC_DEC, max_size, thread_list, nthreads);
+        sweep_sizes(&b, &s, "tea/ctr", OP_CTR, max_size, thread_list, nthreads);
+    }
+
+    bench_finish(&b);
+    free(s.in);
+    free(s.out);
+    memset(&s, 0, sizeof s);
+    if (json) fclose(json);
+    if (csv) fclose(csv);
+    return EXIT_SUCCESS;
+}
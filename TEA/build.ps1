@@ -1,5 +1,5 @@
 # PowerShell Build Script for TEA (Tiny Encryption Algorithm) Implementation
-# Usage: .\build.ps1 [clean|all|test]
+# Usage: .\build.ps1 [clean|all|test|bench]
 
 param(
     [string]$Target = "all"
@@ -7,12 +7,16 @@ param(
 
 $ErrorActionPreference = "Stop"
 
+# Every tool links ..\libsccrypto\libsccrypto.a; sccrypto.h needs the
+# headers of all three directories
+$Includes = @("-I.", "-I..\libsccrypto", "-I..\AES", "-I..\ecc_25519")
+
 function Build-Object {
     param([string]$Source)
     
     $Object = $Source -replace "\.c$", ".o"
     Write-Host "Compiling $Source..." -ForegroundColor Green
-    gcc -Wall -Wextra -O2 -std=c99 -c $Source -o $Object
+    gcc -Wall -Wextra -O2 -std=c99 @Includes -c $Source -o $Object
     if ($LASTEXITCODE -ne 0) {
         throw "Failed to compile $Source"
     }
@@ -34,19 +38,36 @@ function Clear-Build {
     Write-Host "Clean complete." -ForegroundColor Green
 }
 
+function Build-Library {
+    # libsccrypto builds from this directory's sources and the other two
+    Push-Location "..\libsccrypto"
+    try {
+        & .\build.ps1 lib
+    } finally {
+        Pop-Location
+    }
+    if ($LASTEXITCODE -ne 0) {
+        throw "Failed to build libsccrypto"
+    }
+}
+
 function Build-All {
     Write-Host "Building TEA (Tiny Encryption Algorithm) Implementation..." -ForegroundColor Cyan
     
     # Compile source files
-    Build-Object "tea.c"
     Build-Object "common.c"
     Build-Object "tea_main.c"
+    Build-Object "bench_tea.c"
     
-    # Link executable
-    Build-Executable "tea_cbc" @("tea.o", "common.o", "tea_main.o")
+    # Link executables against libsccrypto (TEA core, kernel dispatch)
+    Build-Library
+    $Lib = @("..\libsccrypto\libsccrypto.a", "-pthread")
+    Build-Executable "tea_cbc" (@("common.o", "tea_main.o") + $Lib)
+    Build-Executable "bench_tea" (@("bench_tea.o") + $Lib)
     
-    Write-Host "`nBuild complete! Generated executable:" -ForegroundColor Green
+    Write-Host "`nBuild complete! Generated executables:" -ForegroundColor Green
     Write-Host "  - tea_cbc.exe     (TEA CBC mode encrypt/decrypt)" -ForegroundColor White
+    Write-Host "  - bench_tea.exe   (throughput / latency benchmark sweep)" -ForegroundColor White
 }
 
 function Show-Tests {
@@ -61,6 +82,17 @@ function Show-Tests {
     Write-Host "   .\tea_cbc.exe -d -i encrypted.bin -k key.txt -o decrypted.txt" -ForegroundColor Gray
     Write-Host "5. Verify:" -ForegroundColor White
     Write-Host "   Get-Content decrypted.txt" -ForegroundColor Gray
+    Write-Host "6. Compressed:" -ForegroundColor White
+    Write-Host "   add -z to the encrypt command; decrypt detects it" -ForegroundColor Gray
+}
+
+function Run-Bench {
+    Build-All
+    Write-Host "`nRunning benchmarks (results in bench_tea.json / bench_tea.csv)..." -ForegroundColor Cyan
+    .\bench_tea.exe -o bench_tea.json -c bench_tea.csv
+    if ($LASTEXITCODE -ne 0) {
+        throw "bench_tea failed"
+    }
 }
 
 function Show-Usage {
@@ -70,6 +102,7 @@ function Show-Usage {
     Write-Host "  all     - Build all executables (default)" -ForegroundColor White
     Write-Host "  clean   - Clean build artifacts" -ForegroundColor White
     Write-Host "  test    - Show manual testing instructions" -ForegroundColor White
+    Write-Host "  bench   - Build and run bench_tea" -ForegroundColor White
     Write-Host "  help    - Show this help message" -ForegroundColor White
     Write-Host "`nExamples:" -ForegroundColor Yellow
     Write-Host "  .\build.ps1                # Build everything" -ForegroundColor White
@@ -87,6 +120,7 @@ try {
         "all" { Build-All }
         "clean" { Clear-Build }
         "test" { Show-Tests }
+        "bench" { Run-Bench }
         "help" { Show-Usage }
         default { 
             Write-Host "Unknown target: $Target" -ForegroundColor Red
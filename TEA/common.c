@@ -2,7 +2,8 @@
 
 static void usage(const char *prog)
 {
-    fprintf(stderr, "Usage: %s (-e|-d) -i <input> -k <key> -o <output>\n", prog);
+    fprintf(stderr, "Usage: %s (-e|-d) [-z] [-m cbc|ctr] [-t threads] -i <input> -k <key> -o <output>\n", prog);
+    fprintf(stderr, "  --stats: per-stage time and throughput on stderr; --trace FILE: Chrome trace\n");
     exit(EXIT_FAILURE);
 }
 
@@ -15,8 +16,12 @@ void parse_cli(int argc, char **argv, cli_args_t *a)
         else if (!strcmp(argv[i], "-i")) a->in_fname = argv[++i];
         else if (!strcmp(argv[i], "-k")) a->key_fname = argv[++i];
         else if (!strcmp(argv[i], "-o")) a->out_fname = argv[++i];
+        else if (!strcmp(argv[i], "-z")) a->compress = 1;
+        else if (!strcmp(argv[i], "-m") && i + 1 < argc) a->cipher_mode = argv[++i];
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) a->threads = atoi(argv[++i]);
         else usage(argv[0]);
     }
+    if (!a->cipher_mode) a->cipher_mode = "cbc";
     if (!a->in_fname || !a->key_fname || !a->out_fname)
         usage(argv[0]);
 }
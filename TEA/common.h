@@ -13,6 +13,9 @@ typedef struct {
     const char *in_fname;
     const char *key_fname;
     const char *out_fname;
+    int compress;          /* -z: LZ stage in front of the cipher */
+    const char *cipher_mode; /* -m: "cbc" (default) or "ctr"       */
+    int threads;           /* -t: worker threads, 0 = one per CPU */
 } cli_args_t;
 
 void parse_cli(int argc, char **argv, cli_args_t *args);
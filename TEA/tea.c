@@ -1,7 +1,135 @@
 #include "tea.h"
+#include "tea_simd.h"
+#include "sccrypto.h"
 #include <string.h>
 
-// Encrypt a single 64-bit block using TEA
+// Kernel sets in order of preference; the first usable one is picked
+typedef struct {
+    const char *name;
+    tea_blocks_fn encrypt_blocks;
+    tea_blocks_fn decrypt_blocks;
+} tea_backend_t;
+
+static const tea_backend_t tea_backends[] = {
+#ifdef TEA_HAVE_X86_SIMD
+    { "avx512", tea_avx512_encrypt_blocks, tea_avx512_decrypt_blocks },
+    { "avx2",   tea_avx2_encrypt_blocks,   tea_avx2_decrypt_blocks },
+    { "sse2",   tea_sse2_encrypt_blocks,   tea_sse2_decrypt_blocks },
+#endif
+    { "scalar", tea_scalar_encrypt_blocks, tea_scalar_decrypt_blocks },
+};
+
+static int tea_backend_supported(const char *name) {
+#ifdef TEA_HAVE_X86_SIMD
+    if (!strcmp(name, "avx512")) return __builtin_cpu_supports("avx512f");
+    if (!strcmp(name, "avx2"))   return __builtin_cpu_supports("avx2");
+    if (!strcmp(name, "sse2"))   return __builtin_cpu_supports("sse2");
+#endif
+    return !strcmp(name, "scalar");
+}
+
+// Kernel set tea_ctx_init binds first, NULL to take the fastest one
+static const char *tea_default_backend;
+
+int tea_set_default_backend(const char *name) {
+    if (!name) {
+        tea_default_backend = NULL;
+        return 0;
+    }
+    for (size_t i = 0; i < sizeof tea_backends / sizeof tea_backends[0]; i++) {
+        if (strcmp(tea_backends[i].name, name) != 0) continue;
+        if (!tea_backend_supported(name)) return -1;
+        tea_default_backend = tea_backends[i].name;
+        return 0;
+    }
+    return -1;
+}
+
+// Set up the key context: unpack the key words once and precompute the
+// per-round sum constants, then bind the default or the fastest supported
+// kernels
+void tea_ctx_init(tea_ctx_t *ctx, const uint8_t *key) {
+    sccrypto_init();
+    memcpy(ctx->k, key, TEA_KEY_SIZE);
+    uint32_t sum = 0;
+    for (int i = 0; i < TEA_ROUNDS; i++) {
+        sum += TEA_DELTA;
+        ctx->sum[i] = sum;
+    }
+    
+    if (tea_default_backend && tea_ctx_set_backend(ctx, tea_default_backend) == 0) {
+        return;
+    }
+    for (size_t i = 0; i < sizeof tea_backends / sizeof tea_backends[0]; i++) {
+        if (tea_ctx_set_backend(ctx, tea_backends[i].name) == 0) {
+            break;
+        }
+    }
+}
+
+int tea_ctx_set_backend(tea_ctx_t *ctx, const char *name) {
+    for (size_t i = 0; i < sizeof tea_backends / sizeof tea_backends[0]; i++) {
+        if (strcmp(tea_backends[i].name, name) != 0) continue;
+        if (!tea_backend_supported(name)) return -1;
+        ctx->encrypt_blocks = tea_backends[i].encrypt_blocks;
+        ctx->decrypt_blocks = tea_backends[i].decrypt_blocks;
+        ctx->backend = tea_backends[i].name;
+        return 0;
+    }
+    return -1;
+}
+
+// Encrypt a single block with a prepared context
+void tea_encrypt_block_ctx(const tea_ctx_t *ctx, const uint8_t *in, uint8_t *out) {
+    uint32_t v0, v1;
+    const uint32_t k0 = ctx->k[0], k1 = ctx->k[1], k2 = ctx->k[2], k3 = ctx->k[3];
+    
+    memcpy(&v0, in, 4);
+    memcpy(&v1, in + 4, 4);
+    for (int i = 0; i < TEA_ROUNDS; i++) {
+        v0 += ((v1 << 4) + k0) ^ (v1 + ctx->sum[i]) ^ ((v1 >> 5) + k1);
+        v1 += ((v0 << 4) + k2) ^ (v0 + ctx->sum[i]) ^ ((v0 >> 5) + k3);
+    }
+    memcpy(out, &v0, 4);
+    memcpy(out + 4, &v1, 4);
+}
+
+// Decrypt a single block with a prepared context
+void tea_decrypt_block_ctx(const tea_ctx_t *ctx, const uint8_t *in, uint8_t *out) {
+    uint32_t v0, v1;
+    const uint32_t k0 = ctx->k[0], k1 = ctx->k[1], k2 = ctx->k[2], k3 = ctx->k[3];
+    
+    memcpy(&v0, in, 4);
+    memcpy(&v1, in + 4, 4);
+    for (int i = TEA_ROUNDS - 1; i >= 0; i--) {
+        v1 -= ((v0 << 4) + k2) ^ (v0 + ctx->sum[i]) ^ ((v0 >> 5) + k3);
+        v0 -= ((v1 << 4) + k0) ^ (v1 + ctx->sum[i]) ^ ((v1 >> 5) + k1);
+    }
+    memcpy(out, &v0, 4);
+    memcpy(out + 4, &v1, 4);
+}
+
+void tea_scalar_encrypt_blocks(const tea_ctx_t *ctx, const uint8_t *in, uint8_t *out, size_t nblocks) {
+    for (size_t i = 0; i < nblocks; i++) {
+        tea_encrypt_block_ctx(ctx, in + i * TEA_BLOCK_SIZE, out + i * TEA_BLOCK_SIZE);
+    }
+}
+
+void tea_scalar_decrypt_blocks(const tea_ctx_t *ctx, const uint8_t *in, uint8_t *out, size_t nblocks) {
+    for (size_t i = 0; i < nblocks; i++) {
+        tea_decrypt_block_ctx(ctx, in + i * TEA_BLOCK_SIZE, out + i * TEA_BLOCK_SIZE);
+    }
+}
+
+void tea_ecb_encrypt(const tea_ctx_t *ctx, const uint8_t *in, uint8_t *out, size_t nblocks) {
+    ctx->encrypt_blocks(ctx, in, out, nblocks);
+}
+
+void tea_ecb_decrypt(const tea_ctx_t *ctx, const uint8_t *in, uint8_t *out, size_t nblocks) {
+    ctx->decrypt_blocks(ctx, in, out, nblocks);
+}
+
+// Encrypt a single 64-bit block using TEA (reference implementation)
 void tea_encrypt_block(const uint8_t *plaintext, const uint8_t *key, uint8_t *ciphertext) {
     uint32_t v0, v1;
     uint32_t k0, k1, k2, k3;
@@ -29,7 +157,7 @@ void tea_encrypt_block(const uint8_t *plaintext, const uint8_t *key, uint8_t *ci
     memcpy(ciphertext + 4, &v1, 4);
 }
 
-// Decrypt a single 64-bit block using TEA
+// Decrypt a single 64-bit block using TEA (reference implementation)
 void tea_decrypt_block(const uint8_t *ciphertext, const uint8_t *key, uint8_t *plaintext) {
     uint32_t v0, v1;
     uint32_t k0, k1, k2, k3;
@@ -57,62 +185,174 @@ void tea_decrypt_block(const uint8_t *ciphertext, const uint8_t *key, uint8_t *p
     memcpy(plaintext + 4, &v1, 4);
 }
 
-// CBC mode encryption
-void tea_cbc_encrypt(const uint8_t *plaintext, size_t plaintext_len, 
-                     const uint8_t *key, const uint8_t *iv, 
-                     uint8_t *ciphertext) {
-    uint8_t block[TEA_BLOCK_SIZE];
+// CBC mode decryption core
+// Blocks are independent once the ciphertext is known, so they go through
+// the multi-block kernel a chunk at a time; the chunk is copied first so
+// the chaining still works when plaintext and ciphertext are the same buffer.
+#define TEA_CBC_CHUNK 256
+
+static void tea_cbc_decrypt_chunked(const tea_ctx_t *ctx, const uint8_t *iv,
+                                    const uint8_t *in, uint8_t *out, size_t len,
+                                    int nthreads) {
+    uint8_t chunk[TEA_CBC_CHUNK * TEA_BLOCK_SIZE];
     uint8_t prev_block[TEA_BLOCK_SIZE];
+    size_t num_blocks = len / TEA_BLOCK_SIZE;
+    (void)nthreads;
     
     // Initialize the previous block with the IV
     memcpy(prev_block, iv, TEA_BLOCK_SIZE);
     
-    // CBC encryption processes data in complete blocks
-    size_t num_blocks = plaintext_len / TEA_BLOCK_SIZE;
-    size_t remaining = plaintext_len % TEA_BLOCK_SIZE;
-    
-    // Process each complete block
-    for (size_t i = 0; i < num_blocks; i++) {
-        // XOR plaintext block with previous ciphertext block (or IV for the first block)
+    for (size_t first = 0; first < num_blocks; first += TEA_CBC_CHUNK) {
+        size_t n = num_blocks - first < TEA_CBC_CHUNK ? num_blocks - first : TEA_CBC_CHUNK;
+        uint8_t *dst = &out[first * TEA_BLOCK_SIZE];
+        memcpy(chunk, &in[first * TEA_BLOCK_SIZE], n * TEA_BLOCK_SIZE);
+        
+        // Decrypt the whole chunk, then XOR each block with the ciphertext
+        // block before it (or the IV / last block of the previous chunk)
+        ctx->decrypt_blocks(ctx, chunk, dst, n);
         for (size_t j = 0; j < TEA_BLOCK_SIZE; j++) {
-            block[j] = plaintext[i * TEA_BLOCK_SIZE + j] ^ prev_block[j];
+            dst[j] ^= prev_block[j];
+        }
+        for (size_t i = 1; i < n; i++) {
+            for (size_t j = 0; j < TEA_BLOCK_SIZE; j++) {
+                dst[i * TEA_BLOCK_SIZE + j] ^= chunk[(i - 1) * TEA_BLOCK_SIZE + j];
+            }
+        }
+        memcpy(prev_block, &chunk[(n - 1) * TEA_BLOCK_SIZE], TEA_BLOCK_SIZE);
+    }
+}
+
+// Streaming CBC: set up the key, the chain block and an empty block buffer
+void tea_cbc_init(tea_cbc_ctx_t *s, const uint8_t *key, const uint8_t *iv, int decrypt) {
+    tea_ctx_init(&s->key, key);
+    memcpy(s->chain, iv, TEA_BLOCK_SIZE);
+    s->buf_len = 0;
+    s->decrypt = decrypt;
+    s->decrypt_bulk = tea_cbc_decrypt_chunked;
+    s->threads = 1;
+}
+
+// Encrypt one block from the buffer into out and make it the chain block
+static void tea_cbc_encrypt_buffered(tea_cbc_ctx_t *s, uint8_t *out) {
+    for (size_t j = 0; j < TEA_BLOCK_SIZE; j++) {
+        s->buf[j] ^= s->chain[j];
+    }
+    tea_encrypt_block_ctx(&s->key, s->buf, out);
+    memcpy(s->chain, out, TEA_BLOCK_SIZE);
+    s->buf_len = 0;
+}
+
+// Decrypt the held-back block into out and make it the chain block
+static void tea_cbc_decrypt_buffered(tea_cbc_ctx_t *s, uint8_t *out) {
+    tea_decrypt_block_ctx(&s->key, s->buf, out);
+    for (size_t j = 0; j < TEA_BLOCK_SIZE; j++) {
+        out[j] ^= s->chain[j];
+    }
+    memcpy(s->chain, s->buf, TEA_BLOCK_SIZE);
+    s->buf_len = 0;
+}
+
+size_t tea_cbc_update(tea_cbc_ctx_t *s, const uint8_t *in, size_t len, uint8_t *out) {
+    size_t produced = 0;
+    
+    while (len > 0) {
+        if (s->buf_len == TEA_BLOCK_SIZE) {
+            // More input follows, so a full buffered block is not the last one
+            if (s->decrypt) {
+                tea_cbc_decrypt_buffered(s, out + produced);
+            } else {
+                tea_cbc_encrypt_buffered(s, out + produced);
+            }
+            produced += TEA_BLOCK_SIZE;
         }
         
-        // Encrypt the XOR result
-        tea_encrypt_block(block, key, &ciphertext[i * TEA_BLOCK_SIZE]);
+        if (s->buf_len == 0 && len > TEA_BLOCK_SIZE) {
+            // Whole blocks straight from the input. Decryption keeps at least
+            // one byte back so the final block stays buffered for final()
+            size_t n = (s->decrypt ? len - 1 : len) / TEA_BLOCK_SIZE;
+            size_t bytes = n * TEA_BLOCK_SIZE;
+            if (s->decrypt) {
+                s->decrypt_bulk(&s->key, s->chain, in, out + produced, bytes, s->threads);
+                memcpy(s->chain, in + bytes - TEA_BLOCK_SIZE, TEA_BLOCK_SIZE);
+            } else {
+                for (size_t i = 0; i < bytes; i += TEA_BLOCK_SIZE) {
+                    memcpy(s->buf, in + i, TEA_BLOCK_SIZE);
+                    tea_cbc_encrypt_buffered(s, out + produced + i);
+                }
+            }
+            in += bytes;
+            len -= bytes;
+            produced += bytes;
+        }
         
-        // Save current ciphertext block as previous for next iteration
-        memcpy(prev_block, &ciphertext[i * TEA_BLOCK_SIZE], TEA_BLOCK_SIZE);
+        size_t take = TEA_BLOCK_SIZE - s->buf_len;
+        if (take > len) take = len;
+        memcpy(s->buf + s->buf_len, in, take);
+        s->buf_len += take;
+        in += take;
+        len -= take;
+    }
+    
+    // Encryption has no reason to hold a full block back
+    if (!s->decrypt && s->buf_len == TEA_BLOCK_SIZE) {
+        tea_cbc_encrypt_buffered(s, out + produced);
+        produced += TEA_BLOCK_SIZE;
     }
+    return produced;
+}
+
+int tea_cbc_final(tea_cbc_ctx_t *s, uint8_t *out, size_t *out_len) {
+    int rc = 0;
+    *out_len = 0;
     
-    // Handle the partial last block with PKCS#7 padding if needed
-    if (remaining > 0 || plaintext_len == 0) {
-        uint8_t padding_value = TEA_BLOCK_SIZE - remaining;
+    if (!s->decrypt) {
+        // PKCS#7: always pad, a full block of 8s when the input was aligned
+        uint8_t padding_value = (uint8_t)(TEA_BLOCK_SIZE - s->buf_len);
+        memset(s->buf + s->buf_len, padding_value, padding_value);
+        tea_cbc_encrypt_buffered(s, out);
+        *out_len = TEA_BLOCK_SIZE;
+    } else if (s->buf_len != TEA_BLOCK_SIZE) {
+        rc = -1;  // ciphertext was not a whole number of blocks
+    } else {
+        uint8_t block[TEA_BLOCK_SIZE];
+        tea_cbc_decrypt_buffered(s, block);
         
-        // Copy remaining data
-        for (size_t i = 0; i < remaining; i++) {
-            block[i] = plaintext[num_blocks * TEA_BLOCK_SIZE + i] ^ prev_block[i];
+        uint8_t padding_value = block[TEA_BLOCK_SIZE - 1];
+        if (padding_value == 0 || padding_value > TEA_BLOCK_SIZE) {
+            rc = -1;
         }
-        
-        // Add padding
-        for (size_t i = remaining; i < TEA_BLOCK_SIZE; i++) {
-            block[i] = padding_value ^ prev_block[i];
+        for (size_t i = 1; rc == 0 && i <= padding_value; i++) {
+            if (block[TEA_BLOCK_SIZE - i] != padding_value) rc = -1;
         }
-        
-        // Encrypt the last block
-        tea_encrypt_block(block, key, &ciphertext[num_blocks * TEA_BLOCK_SIZE]);
+        if (rc == 0) {
+            *out_len = TEA_BLOCK_SIZE - padding_value;
+            memcpy(out, block, *out_len);
+        }
+        memset(block, 0, sizeof block);
     }
+    
+    // The context holds key material; wipe it now that the stream is done
+    memset(s, 0, sizeof *s);
+    return rc;
+}
+
+// CBC mode encryption, a single init/update/final pass
+void tea_cbc_encrypt(const uint8_t *plaintext, size_t plaintext_len, 
+                     const uint8_t *key, const uint8_t *iv, 
+                     uint8_t *ciphertext) {
+    tea_cbc_ctx_t s;
+    size_t tail_len;
+    
+    tea_cbc_init(&s, key, iv, 0);
+    size_t n = tea_cbc_update(&s, plaintext, plaintext_len, ciphertext);
+    tea_cbc_final(&s, ciphertext + n, &tail_len);
 }
 
 // CBC mode decryption
 void tea_cbc_decrypt(const uint8_t *ciphertext, size_t ciphertext_len, 
                      const uint8_t *key, const uint8_t *iv, 
                      uint8_t *plaintext) {
-    uint8_t block[TEA_BLOCK_SIZE];
-    uint8_t prev_block[TEA_BLOCK_SIZE];
-    
-    // Initialize the previous block with the IV
-    memcpy(prev_block, iv, TEA_BLOCK_SIZE);
+    tea_ctx_t ctx;
     
     // Ensure the ciphertext length is a multiple of the block size
     if (ciphertext_len % TEA_BLOCK_SIZE != 0 || ciphertext_len == 0) {
@@ -120,22 +360,10 @@ void tea_cbc_decrypt(const uint8_t *ciphertext, size_t ciphertext_len,
         return;
     }
     
+    tea_ctx_init(&ctx, key);
+    tea_cbc_decrypt_chunked(&ctx, iv, ciphertext, plaintext, ciphertext_len, 1);
     size_t num_blocks = ciphertext_len / TEA_BLOCK_SIZE;
     
-    // Process each block
-    for (size_t i = 0; i < num_blocks; i++) {
-        // Decrypt the current ciphertext block
-        tea_decrypt_block(&ciphertext[i * TEA_BLOCK_SIZE], key, block);
-        
-        // XOR with the previous ciphertext block (or IV for the first block)
-        for (size_t j = 0; j < TEA_BLOCK_SIZE; j++) {
-            plaintext[i * TEA_BLOCK_SIZE + j] = block[j] ^ prev_block[j];
-        }
-        
-        // Remember current ciphertext block for next iteration
-        memcpy(prev_block, &ciphertext[i * TEA_BLOCK_SIZE], TEA_BLOCK_SIZE);
-    }
-    
     // Handle PKCS#7 padding removal from the last block
     uint8_t padding_value = plaintext[(num_blocks * TEA_BLOCK_SIZE) - 1];
     
@@ -10,11 +10,76 @@
 #define TEA_DELTA 0x9E3779B9 // Magic constant for TEA
 #define TEA_ROUNDS 32     // Number of rounds in TEA
 
+struct tea_ctx;
+
+// Multi-block ECB kernel: processes nblocks independent 8-byte blocks
+typedef void (*tea_blocks_fn)(const struct tea_ctx *ctx, const uint8_t *in,
+                              uint8_t *out, size_t nblocks);
+
+// Key context, set up once per key. sum[i] is the round constant after
+// i+1 additions of TEA_DELTA; the kernels are picked at init time from the
+// SIMD extensions the CPU supports.
+typedef struct tea_ctx {
+    uint32_t k[4];
+    uint32_t sum[TEA_ROUNDS];
+    tea_blocks_fn encrypt_blocks;
+    tea_blocks_fn decrypt_blocks;
+    const char *backend;  // "scalar", "sse2", "avx2" or "avx512"
+} tea_ctx_t;
+
+// Context setup; set_backend forces one kernel set by name and returns -1
+// if it is not compiled in or not supported by this CPU
+void tea_ctx_init(tea_ctx_t *ctx, const uint8_t *key);
+int  tea_ctx_set_backend(tea_ctx_t *ctx, const char *name);
+// Kernel set for every later tea_ctx_init instead of the fastest one (NULL
+// goes back to the fastest); -1 like set_backend. Not thread-safe against
+// concurrent inits.
+int  tea_set_default_backend(const char *name);
+
+// Single-block reference path
+void tea_encrypt_block_ctx(const tea_ctx_t *ctx, const uint8_t *in, uint8_t *out);
+void tea_decrypt_block_ctx(const tea_ctx_t *ctx, const uint8_t *in, uint8_t *out);
+
 // Function declarations
 void tea_encrypt_block(const uint8_t *plaintext, const uint8_t *key, uint8_t *ciphertext);
 void tea_decrypt_block(const uint8_t *ciphertext, const uint8_t *key, uint8_t *plaintext);
 
-// CBC mode encryption/decryption
+// ECB over nblocks blocks through the selected kernel
+void tea_ecb_encrypt(const tea_ctx_t *ctx, const uint8_t *in, uint8_t *out, size_t nblocks);
+void tea_ecb_decrypt(const tea_ctx_t *ctx, const uint8_t *in, uint8_t *out, size_t nblocks);
+
+// Bulk CBC decryption of len bytes (a whole number of blocks) chaining
+// from iv; in and out must not overlap. tea_cbc_decrypt_mt has this shape.
+typedef void (*tea_cbc_bulk_fn)(const tea_ctx_t *ctx, const uint8_t *iv,
+                                const uint8_t *in, uint8_t *out, size_t len,
+                                int nthreads);
+
+// Streaming CBC state. chain is the previous ciphertext block (the IV at
+// first) and buf collects a partial block between calls. When decrypting,
+// the last full block is held back in buf until more input arrives, since
+// it may be the one carrying the padding. decrypt_bulk/threads may be
+// replaced after init to decrypt long runs of blocks in parallel.
+typedef struct {
+    tea_ctx_t key;
+    uint8_t chain[TEA_BLOCK_SIZE];
+    uint8_t buf[TEA_BLOCK_SIZE];
+    size_t buf_len;
+    int decrypt;
+    tea_cbc_bulk_fn decrypt_bulk;
+    int threads;
+} tea_cbc_ctx_t;
+
+// update returns the number of bytes written to out, which must have room
+// for len + TEA_BLOCK_SIZE bytes and must not overlap in. final writes at
+// most one block: the PKCS#7 padded last block when encrypting, the
+// unpadded tail when decrypting. It returns -1 if the ciphertext length or
+// padding is wrong and always wipes the context.
+void   tea_cbc_init(tea_cbc_ctx_t *s, const uint8_t *key, const uint8_t *iv, int decrypt);
+size_t tea_cbc_update(tea_cbc_ctx_t *s, const uint8_t *in, size_t len, uint8_t *out);
+int    tea_cbc_final(tea_cbc_ctx_t *s, uint8_t *out, size_t *out_len);
+
+// One-shot CBC mode encryption/decryption. Encryption always appends
+// padding, writing (plaintext_len / TEA_BLOCK_SIZE + 1) blocks.
 void tea_cbc_encrypt(const uint8_t *plaintext, size_t plaintext_len, 
                      const uint8_t *key, const uint8_t *iv, 
                      uint8_t *ciphertext);
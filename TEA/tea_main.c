@@ -1,120 +1,305 @@
-#include "tea.h"
 #include "common.h"
-#include <time.h>
+#include "sccrypto.h"
+#include "compress.h"
+#include "perfcnt.h"
+
+// Files are streamed through the cipher in chunks of this size, so memory
+// use does not depend on the file size (except with -z, see below). It is a
+// multiple of TEA_MT_SPAN so every chunk splits evenly across the threads.
+#define IO_CHUNK (1u << 20)
+
+// Fill an IV from the system CSPRNG; CTR mode must never repeat one
+static void random_iv(uint8_t *iv) {
+    FILE *f = fopen("/dev/urandom", "rb");
+    if (!f || fread(iv, 1, TEA_BLOCK_SIZE, f) != TEA_BLOCK_SIZE) {
+        perror("/dev/urandom");
+        exit(EXIT_FAILURE);
+    }
+    fclose(f);
+}
+
+// --stats / --trace / SCCRYPTO_PERF stage report, printed at exit after
+// the kernels libsccrypto bound
+static perf_profile_t prof;
+
+static void report_profile(void) {
+    if (prof.stats) sccrypto_report(stderr);
+    perf_profile_finish(&prof, stderr);
+}
+
+static void fail(const char *msg) {
+    fprintf(stderr, "Error: %s\n", msg);
+    exit(EXIT_FAILURE);
+}
+
+static size_t read_chunk(FILE *in, uint8_t *buf) {
+    perf_profile_begin(&prof, "read");
+    size_t n = fread(buf, 1, IO_CHUNK, in);
+    perf_profile_end(&prof, n);
+    return n;
+}
+
+static void write_chunk(FILE *out, const uint8_t *buf, size_t len) {
+    perf_profile_begin(&prof, "write");
+    if (fwrite(buf, 1, len, out) != len) fail("Write error");
+    perf_profile_end(&prof, len);
+}
+
+// CTR counter block for a position `blocks` blocks into the stream
+static void ctr_iv_at(const uint8_t *iv, uint64_t blocks, uint8_t *out) {
+    uint64_t ctr = 0;
+    for (int i = TEA_BLOCK_SIZE - 1; i >= 0; i--) {
+        ctr = (ctr << 8) | iv[i];
+    }
+    ctr += blocks;
+    for (int i = 0; i < TEA_BLOCK_SIZE; i++) {
+        out[i] = (uint8_t)(ctr >> (8 * i));
+    }
+}
+
+// Plaintext source: mem (the compressed buffer with -z, because the LZ
+// container needs the whole input up front, or the bytes read to look for
+// its magic), then the input file if there is one. Reads are only short at
+// the end of the input.
+typedef struct {
+    FILE *f;
+    const uint8_t *mem;
+    size_t len, pos;
+} source_t;
+
+static size_t source_read(source_t *src, uint8_t *buf, size_t cap) {
+    size_t n = src->len - src->pos < cap ? src->len - src->pos : cap;
+    if (n) memcpy(buf, src->mem + src->pos, n);
+    src->pos += n;
+    if (src->f && n < cap) {
+        perf_profile_begin(&prof, "read");
+        size_t got = fread(buf + n, 1, cap - n, src->f);
+        perf_profile_end(&prof, got);
+        if (got < cap - n && ferror(src->f)) fail("Read error");
+        n += got;
+    }
+    return n;
+}
+
+// Plaintext sink: the output file, or, when the plaintext turns out to be
+// an LZ container (encrypted with -z), a growing buffer that is
+// decompressed at the end. The first bytes are held back until there are
+// enough of them to look for the magic.
+typedef struct {
+    FILE *f;
+    uint8_t *mem;
+    size_t len, cap;
+    int container;   // -1 undecided, 0 plain, 1 LZ container
+} sink_t;
+
+static void sink_write(sink_t *dst, const uint8_t *buf, size_t len) {
+    if (dst->container < 0 && dst->len == 0 && len >= LZ_MAGIC_SIZE) {
+        dst->container = compress_is_container(buf, len);
+    }
+    if (dst->container == 0) {
+        write_chunk(dst->f, buf, len);
+        return;
+    }
+    if (dst->len + len > dst->cap) {
+        size_t cap = dst->cap ? dst->cap : IO_CHUNK;
+        while (cap < dst->len + len) cap *= 2;
+        uint8_t *mem = realloc(dst->mem, cap);
+        if (!mem) fail("Memory allocation failed");
+        dst->mem = mem;
+        dst->cap = cap;
+    }
+    memcpy(dst->mem + dst->len, buf, len);
+    dst->len += len;
+    if (dst->container < 0 && dst->len >= LZ_MAGIC_SIZE) {
+        dst->container = compress_is_container(dst->mem, dst->len);
+        if (!dst->container) {
+            write_chunk(dst->f, dst->mem, dst->len);
+            dst->len = 0;
+        }
+    }
+}
+
+static void encrypt_stream(source_t *src, FILE *out, const uint8_t *key, int ctr, int threads,
+                           uint8_t *in_buf, uint8_t *out_buf) {
+    uint8_t iv[TEA_BLOCK_SIZE];
+    random_iv(iv);
+    write_chunk(out, iv, TEA_BLOCK_SIZE);
+
+    if (ctr) {
+        tea_ctx_t ctx;
+        uint64_t blocks = 0;
+        size_t n;
+        tea_ctx_init(&ctx, key);
+        while ((n = source_read(src, in_buf, IO_CHUNK)) > 0) {
+            uint8_t chunk_iv[TEA_BLOCK_SIZE];
+            ctr_iv_at(iv, blocks, chunk_iv);
+            perf_profile_begin(&prof, "crypt");
+            tea_ctr_crypt(&ctx, chunk_iv, in_buf, out_buf, n, threads);
+            perf_profile_end(&prof, n);
+            write_chunk(out, out_buf, n);
+            blocks += IO_CHUNK / TEA_BLOCK_SIZE;
+        }
+        memset(&ctx, 0, sizeof ctx);
+        return;
+    }
+
+    tea_cbc_ctx_t s;
+    size_t n, produced;
+    tea_cbc_init(&s, key, iv, 0);
+    while ((n = source_read(src, in_buf, IO_CHUNK)) > 0) {
+        perf_profile_begin(&prof, "crypt");
+        produced = tea_cbc_update(&s, in_buf, n, out_buf);
+        perf_profile_end(&prof, n);
+        write_chunk(out, out_buf, produced);
+    }
+    tea_cbc_final(&s, out_buf, &produced);
+    write_chunk(out, out_buf, produced);
+}
+
+static void decrypt_stream(FILE *in, sink_t *dst, const uint8_t *key, int ctr, int threads,
+                           uint8_t *in_buf, uint8_t *out_buf) {
+    uint8_t iv[TEA_BLOCK_SIZE];
+    if (fread(iv, 1, TEA_BLOCK_SIZE, in) != TEA_BLOCK_SIZE) {
+        fail(ctr ? "Invalid ciphertext size for TEA CTR mode"
+                 : "Invalid ciphertext size for TEA CBC mode");
+    }
+
+    if (ctr) {
+        tea_ctx_t ctx;
+        uint64_t blocks = 0;
+        size_t n;
+        tea_ctx_init(&ctx, key);
+        while ((n = read_chunk(in, in_buf)) > 0) {
+            uint8_t chunk_iv[TEA_BLOCK_SIZE];
+            ctr_iv_at(iv, blocks, chunk_iv);
+            perf_profile_begin(&prof, "crypt");
+            tea_ctr_crypt(&ctx, chunk_iv, in_buf, out_buf, n, threads);
+            perf_profile_end(&prof, n);
+            sink_write(dst, out_buf, n);
+            blocks += IO_CHUNK / TEA_BLOCK_SIZE;
+        }
+        if (ferror(in)) fail("Read error");
+        memset(&ctx, 0, sizeof ctx);
+        return;
+    }
+
+    // CBC decryption only chains through ciphertext, so long runs of blocks
+    // are handed to the thread pool
+    tea_cbc_ctx_t s;
+    size_t n, produced;
+    tea_cbc_init(&s, key, iv, 1);
+    s.decrypt_bulk = tea_cbc_decrypt_mt;
+    s.threads = threads;
+    while ((n = read_chunk(in, in_buf)) > 0) {
+        perf_profile_begin(&prof, "crypt");
+        produced = tea_cbc_update(&s, in_buf, n, out_buf);
+        perf_profile_end(&prof, n);
+        sink_write(dst, out_buf, produced);
+    }
+    if (ferror(in)) fail("Read error");
+    if (tea_cbc_final(&s, out_buf, &produced) != 0) {
+        fail("Bad padding or truncated ciphertext (wrong key?)");
+    }
+    sink_write(dst, out_buf, produced);
+}
 
 int main(int argc, char **argv) {
     cli_args_t args = {0};
+    perf_profile_init(&prof, &argc, argv);
     parse_cli(argc, argv, &args);
-    
-    // Read input file
-    size_t input_len;
-    uint8_t *input = read_file(args.in_fname, &input_len);
-    
+    atexit(report_profile);
+
     // Read key file
     size_t key_len;
     uint8_t *key_data = read_file(args.key_fname, &key_len);
-    
+
     // Key must be 16 bytes (128 bits) for TEA
     if (key_len < TEA_KEY_SIZE) {
         fprintf(stderr, "Error: Key must be at least %d bytes for TEA\n", TEA_KEY_SIZE);
-        free(input);
         free(key_data);
         return EXIT_FAILURE;
     }
-    
+
+    int ctr = !strcmp(args.cipher_mode, "ctr");
+    if (!ctr && strcmp(args.cipher_mode, "cbc") != 0) {
+        fprintf(stderr, "Error: Unknown mode '%s' (use cbc or ctr)\n", args.cipher_mode);
+        free(key_data);
+        return EXIT_FAILURE;
+    }
+
+    FILE *in = fopen(args.in_fname, "rb");
+    if (!in) {
+        perror(args.in_fname);
+        return EXIT_FAILURE;
+    }
+    FILE *out = fopen(args.out_fname, "wb");
+    if (!out) {
+        perror(args.out_fname);
+        return EXIT_FAILURE;
+    }
+
+    // CBC update can emit one block more than it was given
+    uint8_t *in_buf = malloc(IO_CHUNK);
+    uint8_t *out_buf = malloc(IO_CHUNK + TEA_BLOCK_SIZE);
+    if (!in_buf || !out_buf) fail("Memory allocation failed");
+
     if (args.mode == MODE_ENCRYPT) {
-        // For CBC encryption, we need:
-        // 1. An initialization vector (IV)
-        // 2. Padding to ensure the plaintext is a multiple of the block size
-        uint8_t iv[TEA_BLOCK_SIZE] = {0};
-        
-        // Generate a random IV
-        // In a real implementation, you would want to use a secure RNG
-        time_t now = time(NULL);
-        memcpy(iv, &now, sizeof(time_t));
-        
-        // Calculate output size: IV + plaintext + potential padding (up to one block)
-        size_t output_len = TEA_BLOCK_SIZE + // IV
-                           ((input_len / TEA_BLOCK_SIZE) + 1) * TEA_BLOCK_SIZE; // padded data
-        
-        uint8_t *output = malloc(output_len);
-        if (!output) {
-            fprintf(stderr, "Memory allocation failed\n");
-            free(input);
-            free(key_data);
-            return EXIT_FAILURE;
-        }
-        
-        // Store the IV at the beginning of the output
-        memcpy(output, iv, TEA_BLOCK_SIZE);
-        
-        // Encrypt the plaintext using CBC mode
-        tea_cbc_encrypt(input, input_len, key_data, iv, output + TEA_BLOCK_SIZE);
-        
-        // Calculate the actual output length after encryption (IV + padded ciphertext)
-        output_len = TEA_BLOCK_SIZE + // IV
-                     ((input_len / TEA_BLOCK_SIZE) + 1) * TEA_BLOCK_SIZE; // padded data
-        
-        // Write output (IV + ciphertext)
-        write_file(args.out_fname, output, output_len);
-        
-        // Clean up
-        free(output);
-        
-    } else { // MODE_DECRYPT
-        if (input_len < TEA_BLOCK_SIZE || input_len % TEA_BLOCK_SIZE != 0) {
-            fprintf(stderr, "Error: Invalid ciphertext size for TEA CBC mode\n");
-            free(input);
-            free(key_data);
-            return EXIT_FAILURE;
+        source_t src = { .f = in };
+        uint8_t *packed = NULL;
+
+        // Peek at the head, which decides on the LZ stage without -z
+        uint8_t head[LZ_MAGIC_SIZE];
+        if (!args.compress) {
+            src.mem = head;
+            src.len = fread(head, 1, sizeof head, in);
+            if (ferror(in)) fail("Read error");
         }
-        
-        // Extract IV from the beginning of the ciphertext
-        uint8_t iv[TEA_BLOCK_SIZE];
-        memcpy(iv, input, TEA_BLOCK_SIZE);
-        
-        // Calculate output size: ciphertext without IV
-        size_t output_len = input_len - TEA_BLOCK_SIZE;
-        
-        uint8_t *output = malloc(output_len);
-        if (!output) {
-            fprintf(stderr, "Memory allocation failed\n");
+        args.compress = compress_needed(head, src.len, args.compress);
+
+        // Optional LZ stage: compress the plaintext before it is encrypted
+        if (args.compress) {
+            size_t input_len;
+            fclose(in);
+            in = NULL;
+            perf_profile_begin(&prof, "read");
+            uint8_t *input = read_file(args.in_fname, &input_len);
+            perf_profile_end(&prof, input_len);
+            perf_profile_begin(&prof, "compress");
+            packed = compress_chunks(input, input_len, &src.len);
+            perf_profile_end(&prof, input_len);
             free(input);
-            free(key_data);
-            return EXIT_FAILURE;
+            if (!packed) fail("Compression failed");
+            src.f = NULL;
+            src.mem = packed;
         }
-        
-        // Decrypt the ciphertext using CBC mode
-        tea_cbc_decrypt(input + TEA_BLOCK_SIZE, output_len, key_data, iv, output);
-        
-        // Determine the actual plaintext length by examining the padding
-        // The last byte indicates the padding size (PKCS#7)
-        uint8_t padding = output[output_len - 1];
-        if (padding > 0 && padding <= TEA_BLOCK_SIZE) {
-            // Verify the padding is correct
-            int valid_padding = 1;
-            for (size_t i = 1; i <= padding; i++) {
-                if (output[output_len - i] != padding) {
-                    valid_padding = 0;
-                    break;
-                }
-            }
-            
-            if (valid_padding) {
-                output_len -= padding;
-            }
+        encrypt_stream(&src, out, key_data, ctr, args.threads, in_buf, out_buf);
+        free(packed);
+
+    } else { // MODE_DECRYPT
+        sink_t dst = { .f = out, .container = -1 };
+        decrypt_stream(in, &dst, key_data, ctr, args.threads, in_buf, out_buf);
+
+        // Undo the LZ stage if the file was encrypted with -z
+        if (dst.container > 0) {
+            size_t unpacked_len;
+            perf_profile_begin(&prof, "decompress");
+            uint8_t *unpacked = decompress_chunks(dst.mem, dst.len, &unpacked_len);
+            perf_profile_end(&prof, dst.len);
+            if (!unpacked) fail("Bad compressed stream (wrong key or corrupt file?)");
+            write_chunk(out, unpacked, unpacked_len);
+            free(unpacked);
+        } else if (dst.len) {
+            write_chunk(out, dst.mem, dst.len);   // shorter than the magic
         }
-        
-        // Write the decrypted plaintext
-        write_file(args.out_fname, output, output_len);
-        
-        // Clean up
-        free(output);
-    }
-    
-    // Common cleanup
-    free(input);
+        free(dst.mem);
+    }
+
+    if (in) fclose(in);
+    if (fclose(out) != 0) fail("Write error");
+    memset(key_data, 0, key_len);
     free(key_data);
-    
+    free(in_buf);
+    free(out_buf);
+
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,121 @@
+#define _POSIX_C_SOURCE 200809L
+#include "tea_mt.h"
+#include "perfcnt.h"
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEA_MT_BATCH 256  // blocks per kernel call inside a span
+
+typedef struct tea_mt_job {
+    const tea_ctx_t *ctx;
+    const uint8_t *iv;
+    const uint8_t *in;
+    uint8_t *out;
+    size_t len;
+    size_t nspans, next;
+    void (*run)(const struct tea_mt_job *job, size_t off, size_t len);
+    const char *name;     // trace span name
+    pthread_mutex_t lock;
+} tea_mt_job_t;
+
+// Encrypts the counter blocks for [off, off + len) and XORs them in
+static void ctr_span(const tea_mt_job_t *job, size_t off, size_t len) {
+    uint8_t ks[TEA_MT_BATCH * TEA_BLOCK_SIZE];
+    uint64_t base = 0;
+    for (int i = 7; i >= 0; i--) {
+        base = (base << 8) | job->iv[i];
+    }
+    
+    for (size_t done = 0; done < len; done += sizeof ks) {
+        size_t n = len - done < sizeof ks ? len - done : sizeof ks;
+        size_t nblocks = (n + TEA_BLOCK_SIZE - 1) / TEA_BLOCK_SIZE;
+        uint64_t ctr = base + (off + done) / TEA_BLOCK_SIZE;
+        for (size_t b = 0; b < nblocks; b++, ctr++) {
+            for (int i = 0; i < 8; i++) {
+                ks[b * TEA_BLOCK_SIZE + i] = (uint8_t)(ctr >> (8 * i));
+            }
+        }
+        job->ctx->encrypt_blocks(job->ctx, ks, ks, nblocks);
+        
+        const uint8_t *src = job->in + off + done;
+        uint8_t *dst = job->out + off + done;
+        for (size_t i = 0; i < n; i++) {
+            dst[i] = src[i] ^ ks[i];
+        }
+    }
+    memset(ks, 0, sizeof ks);
+}
+
+// Decrypts [off, off + len) straight into out, then XORs each block with
+// the ciphertext block before it (the IV for the very first block)
+static void cbc_dec_span(const tea_mt_job_t *job, size_t off, size_t len) {
+    const uint8_t *in = job->in + off;
+    uint8_t *out = job->out + off;
+    
+    const uint8_t *prev = off ? in - TEA_BLOCK_SIZE : job->iv;
+    
+    job->ctx->decrypt_blocks(job->ctx, in, out, len / TEA_BLOCK_SIZE);
+    for (size_t i = 0; i < TEA_BLOCK_SIZE; i++) {
+        out[i] ^= prev[i];
+    }
+    for (size_t i = TEA_BLOCK_SIZE; i < len; i++) {
+        out[i] ^= in[i - TEA_BLOCK_SIZE];
+    }
+}
+
+static void *tea_mt_worker(void *arg) {
+    tea_mt_job_t *job = arg;
+    int trace = perf_trace_enabled();
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        size_t i = job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if (i >= job->nspans) return NULL;
+        
+        size_t off = i * TEA_MT_SPAN;
+        size_t len = job->len - off < TEA_MT_SPAN ? job->len - off : TEA_MT_SPAN;
+        double t0 = trace ? perf_now_ns() : 0;
+        job->run(job, off, len);
+        if (trace) perf_trace_span(job->name, t0, perf_now_ns(), len);
+    }
+}
+
+static void tea_mt_run(tea_mt_job_t *job, int nthreads) {
+    job->nspans = (job->len + TEA_MT_SPAN - 1) / TEA_MT_SPAN;
+    if (nthreads <= 0) {
+        nthreads = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+        nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    }
+    if (nthreads > TEA_MT_MAX_THREADS) nthreads = TEA_MT_MAX_THREADS;
+    if ((size_t)nthreads > job->nspans) nthreads = (int)job->nspans;
+    
+    pthread_t tid[TEA_MT_MAX_THREADS];
+    int started = 0;
+    pthread_mutex_init(&job->lock, NULL);
+    for (; started < nthreads - 1; started++) {
+        if (pthread_create(&tid[started], NULL, tea_mt_worker, job) != 0) break;
+    }
+    tea_mt_worker(job);  // the caller takes spans as well
+    for (int t = 0; t < started; t++) {
+        pthread_join(tid[t], NULL);
+    }
+    pthread_mutex_destroy(&job->lock);
+}
+
+void tea_ctr_crypt(const tea_ctx_t *ctx, const uint8_t *iv,
+                   const uint8_t *in, uint8_t *out, size_t len, int nthreads) {
+    tea_mt_job_t job = { .ctx = ctx, .iv = iv, .in = in, .out = out, .len = len, .run = ctr_span,
+                        .name = "ctr" };
+    tea_mt_run(&job, nthreads);
+}
+
+void tea_cbc_decrypt_mt(const tea_ctx_t *ctx, const uint8_t *iv,
+                        const uint8_t *in, uint8_t *out, size_t len, int nthreads) {
+    if (len % TEA_BLOCK_SIZE != 0) return;
+    tea_mt_job_t job = { .ctx = ctx, .iv = iv, .in = in, .out = out, .len = len, .run = cbc_dec_span,
+                        .name = "cbc_decrypt" };
+    tea_mt_run(&job, nthreads);
+}
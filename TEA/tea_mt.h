@@ -0,0 +1,27 @@
+#ifndef TEA_MT_H
+#define TEA_MT_H
+
+#include "tea.h"
+
+// Multi-threaded TEA modes. The buffer is cut into TEA_MT_SPAN-byte spans
+// that a pool of worker threads picks up one at a time; each span goes
+// through the context's multi-block kernel. nthreads <= 0 uses one thread
+// per online CPU.
+#define TEA_MT_SPAN (64u << 10)
+#define TEA_MT_MAX_THREADS 64
+
+// CTR mode: counter block i is the IV read as a little-endian 64-bit
+// integer plus i (mod 2^64). Encryption and decryption are the same
+// operation; len need not be a multiple of the block size and in may
+// equal out.
+void tea_ctr_crypt(const tea_ctx_t *ctx, const uint8_t *iv,
+                   const uint8_t *in, uint8_t *out, size_t len, int nthreads);
+
+// Parallel CBC decryption without padding removal, producing the same
+// plaintext as tea_cbc_decrypt. len must be a multiple of the block size
+// and in must not overlap out, since each span chains from the ciphertext
+// block in front of it.
+void tea_cbc_decrypt_mt(const tea_ctx_t *ctx, const uint8_t *iv,
+                        const uint8_t *in, uint8_t *out, size_t len, int nthreads);
+
+#endif
@@ -0,0 +1,115 @@
+#include "tea_simd.h"
+
+#ifdef TEA_HAVE_X86_SIMD
+#include <immintrin.h>
+
+// The kernels keep one 32-bit half of a block per vector lane. A pair of
+// vectors holds LANES blocks: v0 gets the first words, v1 the second ones.
+// Loading shuffles [v0 v1 v0 v1 ...] into [v0 v0 v1 v1] per 128-bit lane and
+// then splits the 64-bit halves; storing reverses the same two steps. The
+// lane order inside v0/v1 is permuted, but identically on load and store.
+// Each kernel keeps two independent vector pairs in flight so the 64 serial
+// half-rounds of one group overlap with those of the other.
+
+// ((v << 4) + ka) ^ (v + s) ^ ((v >> 5) + kb)
+#define TEA_F(P, S, v, s, ka, kb)                                         \
+    P##_xor_##S(P##_xor_##S(P##_add_epi32(P##_slli_epi32(v, 4), ka),      \
+                            P##_add_epi32(v, s)),                          \
+                P##_add_epi32(P##_srli_epi32(v, 5), kb))
+
+#define TEA_SIMD_KERNELS(NAME, TARGET, VEC, P, S, LANES)                              \
+static inline __attribute__((target(TARGET)))                                         \
+void NAME##_load(const uint8_t *p, VEC *v0, VEC *v1)                                  \
+{                                                                                     \
+    VEC a = P##_loadu_##S((const VEC *)p);                                            \
+    VEC b = P##_loadu_##S((const VEC *)(p + sizeof(VEC)));                            \
+    a = P##_shuffle_epi32(a, _MM_SHUFFLE(3, 1, 2, 0));                                \
+    b = P##_shuffle_epi32(b, _MM_SHUFFLE(3, 1, 2, 0));                                \
+    *v0 = P##_unpacklo_epi64(a, b);                                                   \
+    *v1 = P##_unpackhi_epi64(a, b);                                                   \
+}                                                                                     \
+                                                                                      \
+static inline __attribute__((target(TARGET)))                                         \
+void NAME##_store(uint8_t *p, VEC v0, VEC v1)                                         \
+{                                                                                     \
+    VEC a = P##_shuffle_epi32(P##_unpacklo_epi64(v0, v1), _MM_SHUFFLE(3, 1, 2, 0));   \
+    VEC b = P##_shuffle_epi32(P##_unpackhi_epi64(v0, v1), _MM_SHUFFLE(3, 1, 2, 0));   \
+    P##_storeu_##S((VEC *)p, a);                                                      \
+    P##_storeu_##S((VEC *)(p + sizeof(VEC)), b);                                      \
+}                                                                                     \
+                                                                                      \
+__attribute__((target(TARGET)))                                                       \
+void tea_##NAME##_encrypt_blocks(const tea_ctx_t *ctx, const uint8_t *in,             \
+                                 uint8_t *out, size_t nblocks)                        \
+{                                                                                     \
+    const VEC k0 = P##_set1_epi32((int)ctx->k[0]), k1 = P##_set1_epi32((int)ctx->k[1]); \
+    const VEC k2 = P##_set1_epi32((int)ctx->k[2]), k3 = P##_set1_epi32((int)ctx->k[3]); \
+    size_t i = 0;                                                                     \
+    for (; i + 2 * LANES <= nblocks; i += 2 * LANES) {                                \
+        VEC a0, a1, b0, b1;                                                           \
+        NAME##_load(in + i * TEA_BLOCK_SIZE, &a0, &a1);                               \
+        NAME##_load(in + (i + LANES) * TEA_BLOCK_SIZE, &b0, &b1);                     \
+        for (int r = 0; r < TEA_ROUNDS; r++) {                                        \
+            const VEC s = P##_set1_epi32((int)ctx->sum[r]);                           \
+            a0 = P##_add_epi32(a0, TEA_F(P, S, a1, s, k0, k1));                       \
+            b0 = P##_add_epi32(b0, TEA_F(P, S, b1, s, k0, k1));                       \
+            a1 = P##_add_epi32(a1, TEA_F(P, S, a0, s, k2, k3));                       \
+            b1 = P##_add_epi32(b1, TEA_F(P, S, b0, s, k2, k3));                       \
+        }                                                                             \
+        NAME##_store(out + i * TEA_BLOCK_SIZE, a0, a1);                               \
+        NAME##_store(out + (i + LANES) * TEA_BLOCK_SIZE, b0, b1);                     \
+    }                                                                                 \
+    for (; i + LANES <= nblocks; i += LANES) {                                        \
+        VEC a0, a1;                                                                   \
+        NAME##_load(in + i * TEA_BLOCK_SIZE, &a0, &a1);                               \
+        for (int r = 0; r < TEA_ROUNDS; r++) {                                        \
+            const VEC s = P##_set1_epi32((int)ctx->sum[r]);                           \
+            a0 = P##_add_epi32(a0, TEA_F(P, S, a1, s, k0, k1));                       \
+            a1 = P##_add_epi32(a1, TEA_F(P, S, a0, s, k2, k3));                       \
+        }                                                                             \
+        NAME##_store(out + i * TEA_BLOCK_SIZE, a0, a1);                               \
+    }                                                                                 \
+    tea_scalar_encrypt_blocks(ctx, in + i * TEA_BLOCK_SIZE,                           \
+                              out + i * TEA_BLOCK_SIZE, nblocks - i);                 \
+}                                                                                     \
+                                                                                      \
+__attribute__((target(TARGET)))                                                       \
+void tea_##NAME##_decrypt_blocks(const tea_ctx_t *ctx, const uint8_t *in,             \
+                                 uint8_t *out, size_t nblocks)                        \
+{                                                                                     \
+    const VEC k0 = P##_set1_epi32((int)ctx->k[0]), k1 = P##_set1_epi32((int)ctx->k[1]); \
+    const VEC k2 = P##_set1_epi32((int)ctx->k[2]), k3 = P##_set1_epi32((int)ctx->k[3]); \
+    size_t i = 0;                                                                     \
+    for (; i + 2 * LANES <= nblocks; i += 2 * LANES) {                                \
+        VEC a0, a1, b0, b1;                                                           \
+        NAME##_load(in + i * TEA_BLOCK_SIZE, &a0, &a1);                               \
+        NAME##_load(in + (i + LANES) * TEA_BLOCK_SIZE, &b0, &b1);                     \
+        for (int r = TEA_ROUNDS - 1; r >= 0; r--) {                                   \
+            const VEC s = P##_set1_epi32((int)ctx->sum[r]);                           \
+            a1 = P##_sub_epi32(a1, TEA_F(P, S, a0, s, k2, k3));                       \
+            b1 = P##_sub_epi32(b1, TEA_F(P, S, b0, s, k2, k3));                       \
+            a0 = P##_sub_epi32(a0, TEA_F(P, S, a1, s, k0, k1));                       \
+            b0 = P##_sub_epi32(b0, TEA_F(P, S, b1, s, k0, k1));                       \
+        }                                                                             \
+        NAME##_store(out + i * TEA_BLOCK_SIZE, a0, a1);                               \
+        NAME##_store(out + (i + LANES) * TEA_BLOCK_SIZE, b0, b1);                     \
+    }                                                                                 \
+    for (; i + LANES <= nblocks; i += LANES) {                                        \
+        VEC a0, a1;                                                                   \
+        NAME##_load(in + i * TEA_BLOCK_SIZE, &a0, &a1);                               \
+        for (int r = TEA_ROUNDS - 1; r >= 0; r--) {                                   \
+            const VEC s = P##_set1_epi32((int)ctx->sum[r]);                           \
+            a1 = P##_sub_epi32(a1, TEA_F(P, S, a0, s, k2, k3));                       \
+            a0 = P##_sub_epi32(a0, TEA_F(P, S, a1, s, k0, k1));                       \
+        }                                                                             \
+        NAME##_store(out + i * TEA_BLOCK_SIZE, a0, a1);                               \
+    }                                                                                 \
+    tea_scalar_decrypt_blocks(ctx, in + i * TEA_BLOCK_SIZE,                           \
+                              out + i * TEA_BLOCK_SIZE, nblocks - i);                 \
+}
+
+TEA_SIMD_KERNELS(sse2,   "sse2",    __m128i, _mm,    si128, 4)
+TEA_SIMD_KERNELS(avx2,   "avx2",    __m256i, _mm256, si256, 8)
+TEA_SIMD_KERNELS(avx512, "avx512f", __m512i, _mm512, si512, 16)
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef TEA_SIMD_H
+#define TEA_SIMD_H
+
+#include "tea.h"
+
+// Scalar reference kernels (tea.c)
+void tea_scalar_encrypt_blocks(const tea_ctx_t *ctx, const uint8_t *in, uint8_t *out, size_t nblocks);
+void tea_scalar_decrypt_blocks(const tea_ctx_t *ctx, const uint8_t *in, uint8_t *out, size_t nblocks);
+
+// Vector kernels (tea_simd.c): 4 / 8 / 16 blocks per vector, two vectors
+// in flight per iteration, leftovers go through the scalar kernel
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TEA_HAVE_X86_SIMD 1
+void tea_sse2_encrypt_blocks(const tea_ctx_t *ctx, const uint8_t *in, uint8_t *out, size_t nblocks);
+void tea_sse2_decrypt_blocks(const tea_ctx_t *ctx, const uint8_t *in, uint8_t *out, size_t nblocks);
+void tea_avx2_encrypt_blocks(const tea_ctx_t *ctx, const uint8_t *in, uint8_t *out, size_t nblocks);
+void tea_avx2_decrypt_blocks(const tea_ctx_t *ctx, const uint8_t *in, uint8_t *out, size_t nblocks);
+void tea_avx512_encrypt_blocks(const tea_ctx_t *ctx, const uint8_t *in, uint8_t *out, size_t nblocks);
+void tea_avx512_decrypt_blocks(const tea_ctx_t *ctx, const uint8_t *in, uint8_t *out, size_t nblocks);
+#endif
+
+#endif
@@ -0,0 +1,207 @@
+#define _POSIX_C_SOURCE 200809L
+#include "bench.h"
+#include "sccrypto.h"
+#include "field25519.h"
+#include "keypool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Message sizes for the ecc_encrypt / ecc_decrypt sweep
+static const size_t payload_sizes[] = { 16, 1024, 64 * 1024, 1024 * 1024 };
+
+// Pairs in the key pool for the pool-hit case: more than one run of
+// ecc_encrypt_pooled takes, so every call is served from the pool
+#define POOL_PAIRS (1u << 14)
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-n SAMPLES] [-f NAME] [-j | -o FILE.json] [-c FILE.csv]\n", prog);
+    fprintf(stderr, "  Times the field, scalar multiplication and message operations and\n");
+    fprintf(stderr, "  prints the median per operation; -f runs only names containing NAME,\n");
+    fprintf(stderr, "  -j writes JSON to stdout (table to stderr), -o / -c write JSON / CSV files\n");
+    exit(EXIT_FAILURE);
+}
+
+static FILE *open_output(FILE *prev, const char *fname) {
+    FILE *f = prev ? NULL : fopen(fname, "w");
+    if (!f) {
+        if (!prev) perror(fname);
+        exit(EXIT_FAILURE);
+    }
+    return f;
+}
+
+typedef struct {
+    gf a, b;
+} field_ctx_t;
+
+// Each result feeds the next call, so the iterations form one dependency
+// chain and measure latency
+static void run_mul(void *p, size_t iters) {
+    field_ctx_t *c = p;
+    for (size_t i = 0; i < iters; i++) field_multiply(c->a, c->a, c->b);
+}
+
+static void run_square(void *p, size_t iters) {
+    field_ctx_t *c = p;
+    for (size_t i = 0; i < iters; i++) field_square(c->a, c->a);
+}
+
+static void run_invert(void *p, size_t iters) {
+    field_ctx_t *c = p;
+    for (size_t i = 0; i < iters; i++) field_invert(c->a, c->a);
+}
+
+typedef struct {
+    uint8_t priv[FIELD_SIZE], pub[FIELD_SIZE], out[FIELD_SIZE];
+    const uint8_t *plaintext, *ciphertext;
+    size_t len, ct_len;
+} scalar_ctx_t;
+
+static void run_scalarmult(void *p, size_t iters) {
+    scalar_ctx_t *c = p;
+    for (size_t i = 0; i < iters; i++) curve25519_scalarmult(c->out, c->priv, c->pub);
+}
+
+static void run_scalarmult_base(void *p, size_t iters) {
+    scalar_ctx_t *c = p;
+    for (size_t i = 0; i < iters; i++) curve25519_compute_public(c->out, c->priv);
+}
+
+static void run_keygen(void *p, size_t iters) {
+    (void)p;
+    key_pair_t kp;
+    for (size_t i = 0; i < iters; i++) curve25519_generate_keypair(&kp);
+    memset(&kp, 0, sizeof kp);
+}
+
+static void run_encrypt(void *p, size_t iters) {
+    scalar_ctx_t *c = p;
+    for (size_t i = 0; i < iters; i++) {
+        uint8_t *ct;
+        size_t ct_len;
+        if (!ecc_encrypt(c->pub, c->plaintext, c->len, &ct, &ct_len)) {
+            fprintf(stderr, "ecc_encrypt failed\n");
+            exit(EXIT_FAILURE);
+        }
+        free(ct);
+    }
+}
+
+static void run_decrypt(void *p, size_t iters) {
+    scalar_ctx_t *c = p;
+    for (size_t i = 0; i < iters; i++) {
+        uint8_t *pt;
+        size_t pt_len;
+        if (!ecc_decrypt(c->priv, c->ciphertext, c->ct_len, &pt, &pt_len)) {
+            fprintf(stderr, "ecc_decrypt failed\n");
+            exit(EXIT_FAILURE);
+        }
+        free(pt);
+    }
+}
+
+// Waits for the refill thread to fill the key pool
+static void wait_pool_full(void) {
+    const struct timespec tick = { 0, 1000000 };
+    keypool_stats_t st;
+    for (keypool_stats(&st); st.available < st.capacity; keypool_stats(&st)) {
+        nanosleep(&tick, NULL);
+    }
+}
+
+int main(int argc, char **argv) {
+    bench_t b;
+    FILE *json = NULL, *csv = NULL;
+    const char *filter = NULL;
+    int samples = BENCH_SAMPLES, to_stdout = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) samples = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-f") && i + 1 < argc) filter = argv[++i];
+        else if (!strcmp(argv[i], "-j")) to_stdout = 1;
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) json = open_output(json, argv[++i]);
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc) csv = open_output(csv, argv[++i]);
+        else usage(argv[0]);
+    }
+    if (samples <= 0 || (to_stdout && json)) usage(argv[0]);
+
+    bench_init(&b, "ecc", to_stdout ? stderr : stdout, to_stdout ? stdout : json, csv);
+    b.samples = samples;
+    b.filter = filter;
+
+    field_ctx_t f;
+    uint8_t bytes[FIELD_SIZE];
+    curve25519_random_bytes(bytes, sizeof bytes);
+    field_unpack(f.a, bytes);
+    curve25519_random_bytes(bytes, sizeof bytes);
+    field_unpack(f.b, bytes);
+    bench_run(&b, "field_multiply", 0, run_mul, &f, NULL);
+    bench_run(&b, "field_square", 0, run_square, &f, NULL);
+    bench_run(&b, "field_invert", 0, run_invert, &f, NULL);
+
+    scalar_ctx_t s;
+    key_pair_t peer;
+    curve25519_generate_keypair(&peer);
+    curve25519_random_bytes(s.priv, FIELD_SIZE);
+    curve25519_clamp(s.priv);
+    memcpy(s.pub, peer.public_key, FIELD_SIZE);
+    bench_run(&b, "scalarmult", 0, run_scalarmult, &s, NULL);
+    bench_run(&b, "scalarmult_base", 0, run_scalarmult_base, &s, NULL);
+    bench_run(&b, "keygen", 0, run_keygen, NULL, NULL);
+
+    // Messages go to the peer key, and decrypt with its private key
+    size_t max_len = payload_sizes[sizeof payload_sizes / sizeof *payload_sizes - 1];
+    uint8_t *plaintext = malloc(max_len);
+    if (!plaintext) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return EXIT_FAILURE;
+    }
+    curve25519_random_bytes(plaintext, max_len);
+    memcpy(s.priv, peer.private_key, FIELD_SIZE);
+    memcpy(s.pub, peer.public_key, FIELD_SIZE);
+    s.plaintext = plaintext;
+    for (size_t i = 0; i < sizeof payload_sizes / sizeof *payload_sizes; i++) {
+        char name[64];
+        uint8_t *ct;
+        s.len = payload_sizes[i];
+        if (!ecc_encrypt(s.pub, plaintext, s.len, &ct, &s.ct_len)) {
+            fprintf(stderr, "ecc_encrypt failed\n");
+            return EXIT_FAILURE;
+        }
+        s.ciphertext = ct;
+        snprintf(name, sizeof name, "ecc_encrypt/%zu", s.len);
+        bench_run(&b, name, s.len, run_encrypt, &s, NULL);
+        snprintf(name, sizeof name, "ecc_decrypt/%zu", s.len);
+        bench_run(&b, name, s.len, run_decrypt, &s, NULL);
+        free(ct);
+    }
+
+    // ecc_encrypt with the ephemeral pair taken from a full key pool, the
+    // cost left on the request path when the pool keeps up
+    s.len = payload_sizes[0];
+    char pooled[64];
+    snprintf(pooled, sizeof pooled, "ecc_encrypt_pooled/%zu", s.len);
+    if ((!filter || strstr(pooled, filter)) && keypool_start(POOL_PAIRS, 0)) {
+        keypool_stats_t before, after;
+        wait_pool_full();
+        keypool_stats(&before);
+        bench_run(&b, pooled, s.len, run_encrypt, &s, NULL);
+        keypool_stats(&after);
+        keypool_stop();
+        if (b.table) {
+            fprintf(b.table, "  keypool: %llu hits, %llu misses\n",
+                    (unsigned long long)(after.hits - before.hits),
+                    (unsigned long long)(after.misses - before.misses));
+        }
+    }
+
+    bench_finish(&b);
+    free(plaintext);
+    memset(&peer, 0, sizeof peer);
+    memset(&s, 0, sizeof s);
+    if (json) fclose(json);
+    if (csv) fclose(csv);
+    return EXIT_SUCCESS;
+}
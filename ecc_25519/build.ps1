@@ -1,5 +1,5 @@
 # PowerShell Build Script for Curve25519 ECC Implementation
-# Usage: .\build.ps1 [clean|all|test]
+# Usage: .\build.ps1 [clean|all|test|bench]
 
 param(
     [string]$Target = "all"
@@ -7,12 +7,16 @@ param(
 
 $ErrorActionPreference = "Stop"
 
+# Every tool links ..\libsccrypto\libsccrypto.a; sccrypto.h needs the
+# headers of all three directories
+$Includes = @("-I.", "-I..\libsccrypto", "-I..\AES", "-I..\TEA")
+
 function Build-Object {
     param([string]$Source)
     
     $Object = $Source -replace "\.c$", ".o"
     Write-Host "Compiling $Source..." -ForegroundColor Green
-    gcc -Wall -Wextra -O2 -c $Source -o $Object
+    gcc -Wall -Wextra -O2 @Includes -c $Source -o $Object
     if ($LASTEXITCODE -ne 0) {
         throw "Failed to compile $Source"
     }
@@ -30,26 +34,60 @@ function Build-Executable {
 
 function Clean-Build {
     Write-Host "Cleaning build artifacts..." -ForegroundColor Yellow
-    Remove-Item -Force -ErrorAction SilentlyContinue "*.o", "*.exe"
+    Remove-Item -Force -ErrorAction SilentlyContinue "*.o", "*.exe", "ge25519_base_table.h"
     Write-Host "Clean complete." -ForegroundColor Green
 }
 
+function Build-Library {
+    # libsccrypto builds from this directory's sources and the other two
+    Push-Location "..\libsccrypto"
+    try {
+        & .\build.ps1 lib
+    } finally {
+        Pop-Location
+    }
+    if ($LASTEXITCODE -ne 0) {
+        throw "Failed to build libsccrypto"
+    }
+}
+
 function Build-All {
     Write-Host "Building Curve25519 ECC Implementation..." -ForegroundColor Cyan
     
+    # Generate the fixed-base comb table (for the library) with a host program
+    Build-Object "field25519.c"
+    Build-Object "ge25519.c"
+    Build-Object "ge25519_gen.c"
+    Build-Executable "ge25519_gen" @("ge25519_gen.o", "ge25519.o", "field25519.o")
+    Write-Host "Generating ge25519_base_table.h..." -ForegroundColor Green
+    .\ge25519_gen.exe | Out-File -Encoding ascii "ge25519_base_table.h"
+    if ($LASTEXITCODE -ne 0) {
+        throw "Failed to generate ge25519_base_table.h"
+    }
+    
     # Compile source files
-    Build-Object "curve25519.c"
     Build-Object "common.c"
     Build-Object "ecc_main.c"
     Build-Object "keygen.c"
+    Build-Object "keyring_tool.c"
+    Build-Object "ecc_sign.c"
+    Build-Object "bench_ecc.c"
     
-    # Link executables
-    Build-Executable "ecc_main" @("curve25519.o", "common.o", "ecc_main.o")
-    Build-Executable "keygen" @("curve25519.o", "common.o", "keygen.o")
+    # Link executables against libsccrypto (Curve25519 core, kernel dispatch)
+    Build-Library
+    $Lib = @("..\libsccrypto\libsccrypto.a", "-pthread")
+    Build-Executable "ecc_main" (@("common.o", "ecc_main.o") + $Lib)
+    Build-Executable "keygen" (@("common.o", "keygen.o") + $Lib)
+    Build-Executable "keyring" (@("common.o", "keyring_tool.o") + $Lib)
+    Build-Executable "ecc_sign" (@("common.o", "ecc_sign.o") + $Lib)
+    Build-Executable "bench_ecc" (@("bench_ecc.o") + $Lib)
     
     Write-Host "`nBuild complete! Generated executables:" -ForegroundColor Green
     Write-Host "  - ecc_main.exe    (encrypt/decrypt files)" -ForegroundColor White
     Write-Host "  - keygen.exe      (generate key pairs)" -ForegroundColor White
+    Write-Host "  - keyring.exe     (build and query keyrings)" -ForegroundColor White
+    Write-Host "  - ecc_sign.exe    (Ed25519 sign / verify / batch verify)" -ForegroundColor White
+    Write-Host "  - bench_ecc.exe   (field / scalar multiplication / message benchmarks)" -ForegroundColor White
 }
 
 function Run-Tests {
@@ -59,6 +97,16 @@ function Run-Tests {
     Write-Host "  .\keygen.exe test" -ForegroundColor Gray
     Write-Host "  .\ecc_main.exe -e -i input.txt -k test -o output.enc" -ForegroundColor Gray
     Write-Host "  .\ecc_main.exe -d -i output.enc -k test -o decrypted.txt" -ForegroundColor Gray
+    Write-Host "  (add -z to the encrypt command to compress first; decrypt detects it)" -ForegroundColor Gray
+}
+
+function Run-Bench {
+    Build-All
+    Write-Host "`nRunning benchmarks (results in bench_ecc.json / bench_ecc.csv)..." -ForegroundColor Cyan
+    .\bench_ecc.exe -o bench_ecc.json -c bench_ecc.csv
+    if ($LASTEXITCODE -ne 0) {
+        throw "bench_ecc failed"
+    }
 }
 
 function Show-Usage {
@@ -68,6 +116,7 @@ function Show-Usage {
     Write-Host "  all     - Build all executables (default)" -ForegroundColor White
     Write-Host "  clean   - Clean build artifacts" -ForegroundColor White
     Write-Host "  test    - Show manual testing instructions" -ForegroundColor White
+    Write-Host "  bench   - Build and run bench_ecc" -ForegroundColor White
     Write-Host "  help    - Show this help message" -ForegroundColor White
     Write-Host "`nExamples:" -ForegroundColor Yellow
     Write-Host "  .\build.ps1                # Build everything" -ForegroundColor White
@@ -81,6 +130,7 @@ try {
         "all" { Build-All }
         "clean" { Clean-Build }
         "test" { Run-Tests }
+        "bench" { Run-Bench }
         "help" { Show-Usage }
         default { 
             Write-Host "Unknown target: $Target" -ForegroundColor Red
@@ -0,0 +1,262 @@
+#include "chacha20.h"
+#include "sccrypto.h"
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CHACHA_HAVE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+static uint32_t load_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+#define QUARTERROUND(a, b, c, d)                    \
+    a += b; d ^= a; d = ROTL32(d, 16);              \
+    c += d; b ^= c; b = ROTL32(b, 12);              \
+    a += b; d ^= a; d = ROTL32(d, 8);               \
+    c += d; b ^= c; b = ROTL32(b, 7);
+
+// Reference kernel, one block at a time
+static void chacha20_scalar_blocks(uint32_t *state, const uint8_t *in, uint8_t *out, size_t nblocks) {
+    for (; nblocks > 0; nblocks--, in += CHACHA20_BLOCK_SIZE, out += CHACHA20_BLOCK_SIZE) {
+        uint32_t x[16];
+        memcpy(x, state, sizeof x);
+        for (int i = 0; i < 10; i++) {
+            QUARTERROUND(x[0], x[4], x[8],  x[12])
+            QUARTERROUND(x[1], x[5], x[9],  x[13])
+            QUARTERROUND(x[2], x[6], x[10], x[14])
+            QUARTERROUND(x[3], x[7], x[11], x[15])
+            QUARTERROUND(x[0], x[5], x[10], x[15])
+            QUARTERROUND(x[1], x[6], x[11], x[12])
+            QUARTERROUND(x[2], x[7], x[8],  x[13])
+            QUARTERROUND(x[3], x[4], x[9],  x[14])
+        }
+        for (int i = 0; i < 16; i++) {
+            uint32_t k = x[i] + state[i];
+            out[4 * i + 0] = (uint8_t)(in[4 * i + 0] ^ k);
+            out[4 * i + 1] = (uint8_t)(in[4 * i + 1] ^ (k >> 8));
+            out[4 * i + 2] = (uint8_t)(in[4 * i + 2] ^ (k >> 16));
+            out[4 * i + 3] = (uint8_t)(in[4 * i + 3] ^ (k >> 24));
+        }
+        state[12]++;
+    }
+}
+
+#ifdef CHACHA_HAVE_X86_SIMD
+// The vector kernels keep the state as four row vectors, one block per
+// 128-bit lane, so the column and diagonal rounds are the same lane-local
+// operations at every width; between the two halves of a double round the
+// rows are rotated with shuffle_epi32 to line the diagonals up. Each
+// iteration runs two groups of LANES blocks to hide the round latency.
+// Only the final store differs per width: the rows of each lane are
+// regrouped into whole blocks.
+
+#define CHACHA_DIAG(P, b, c, d)                                     \
+    b = P##_shuffle_epi32(b, _MM_SHUFFLE(0, 3, 2, 1));              \
+    c = P##_shuffle_epi32(c, _MM_SHUFFLE(1, 0, 3, 2));              \
+    d = P##_shuffle_epi32(d, _MM_SHUFFLE(2, 1, 0, 3));
+#define CHACHA_UNDIAG(P, b, c, d)                                   \
+    b = P##_shuffle_epi32(b, _MM_SHUFFLE(2, 1, 0, 3));              \
+    c = P##_shuffle_epi32(c, _MM_SHUFFLE(1, 0, 3, 2));              \
+    d = P##_shuffle_epi32(d, _MM_SHUFFLE(0, 3, 2, 1));
+
+#define CHACHA_HALF(P, S, ROTL, a, b, c, d)                          \
+    a = P##_add_epi32(a, b); d = P##_xor_##S(d, a); d = ROTL(d, 16); \
+    c = P##_add_epi32(c, d); b = P##_xor_##S(b, c); b = ROTL(b, 12); \
+    a = P##_add_epi32(a, b); d = P##_xor_##S(d, a); d = ROTL(d, 8);  \
+    c = P##_add_epi32(c, d); b = P##_xor_##S(b, c); b = ROTL(b, 7);
+
+#define SSE2_ROTL(v, n) _mm_or_si128(_mm_slli_epi32(v, n), _mm_srli_epi32(v, 32 - (n)))
+#define AVX2_ROTL(v, n)                                                                  \
+    ((n) == 16 ? _mm256_shuffle_epi8(v, _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10,   \
+                     5, 4, 7, 6, 1, 0, 3, 2, 13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6,   \
+                     1, 0, 3, 2)) :                                                      \
+     (n) == 8 ? _mm256_shuffle_epi8(v, _mm256_set_epi8(14, 13, 12, 15, 10, 9, 8, 11,    \
+                     6, 5, 4, 7, 2, 1, 0, 3, 14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7,   \
+                     2, 1, 0, 3)) :                                                      \
+     _mm256_or_si256(_mm256_slli_epi32(v, n), _mm256_srli_epi32(v, 32 - (n))))
+#define AVX512_ROTL(v, n) _mm512_rol_epi32(v, n)
+
+// XOR the keystream rows x0..x3 of one group into LANES blocks
+static inline __attribute__((target("sse2")))
+void sse2_xor_rows(const uint8_t *in, uint8_t *out, __m128i x0, __m128i x1, __m128i x2, __m128i x3) {
+    const __m128i *i = (const __m128i *)in;
+    __m128i *o = (__m128i *)out;
+    _mm_storeu_si128(o + 0, _mm_xor_si128(_mm_loadu_si128(i + 0), x0));
+    _mm_storeu_si128(o + 1, _mm_xor_si128(_mm_loadu_si128(i + 1), x1));
+    _mm_storeu_si128(o + 2, _mm_xor_si128(_mm_loadu_si128(i + 2), x2));
+    _mm_storeu_si128(o + 3, _mm_xor_si128(_mm_loadu_si128(i + 3), x3));
+}
+
+static inline __attribute__((target("avx2")))
+void avx2_xor_rows(const uint8_t *in, uint8_t *out, __m256i x0, __m256i x1, __m256i x2, __m256i x3) {
+    const __m256i *i = (const __m256i *)in;
+    __m256i *o = (__m256i *)out;
+    _mm256_storeu_si256(o + 0, _mm256_xor_si256(_mm256_loadu_si256(i + 0), _mm256_permute2x128_si256(x0, x1, 0x20)));
+    _mm256_storeu_si256(o + 1, _mm256_xor_si256(_mm256_loadu_si256(i + 1), _mm256_permute2x128_si256(x2, x3, 0x20)));
+    _mm256_storeu_si256(o + 2, _mm256_xor_si256(_mm256_loadu_si256(i + 2), _mm256_permute2x128_si256(x0, x1, 0x31)));
+    _mm256_storeu_si256(o + 3, _mm256_xor_si256(_mm256_loadu_si256(i + 3), _mm256_permute2x128_si256(x2, x3, 0x31)));
+}
+
+// 4x4 transpose of 128-bit lanes
+static inline __attribute__((target("avx512f")))
+void avx512_xor_rows(const uint8_t *in, uint8_t *out, __m512i x0, __m512i x1, __m512i x2, __m512i x3) {
+    __m512i t0 = _mm512_shuffle_i32x4(x0, x1, _MM_SHUFFLE(1, 0, 1, 0));
+    __m512i t1 = _mm512_shuffle_i32x4(x2, x3, _MM_SHUFFLE(1, 0, 1, 0));
+    __m512i t2 = _mm512_shuffle_i32x4(x0, x1, _MM_SHUFFLE(3, 2, 3, 2));
+    __m512i t3 = _mm512_shuffle_i32x4(x2, x3, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m512i *i = (const __m512i *)in;
+    __m512i *o = (__m512i *)out;
+    _mm512_storeu_si512(o + 0, _mm512_xor_si512(_mm512_loadu_si512(i + 0), _mm512_shuffle_i32x4(t0, t1, _MM_SHUFFLE(2, 0, 2, 0))));
+    _mm512_storeu_si512(o + 1, _mm512_xor_si512(_mm512_loadu_si512(i + 1), _mm512_shuffle_i32x4(t0, t1, _MM_SHUFFLE(3, 1, 3, 1))));
+    _mm512_storeu_si512(o + 2, _mm512_xor_si512(_mm512_loadu_si512(i + 2), _mm512_shuffle_i32x4(t2, t3, _MM_SHUFFLE(2, 0, 2, 0))));
+    _mm512_storeu_si512(o + 3, _mm512_xor_si512(_mm512_loadu_si512(i + 3), _mm512_shuffle_i32x4(t2, t3, _MM_SHUFFLE(3, 1, 3, 1))));
+}
+
+// Per-lane counter offsets 0, 1, 2, 3 in the first word of row 3
+static const uint32_t chacha_lane_ctr[16] = { 0, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0 };
+
+#define CHACHA_SIMD_KERNEL(NAME, TARGET, VEC, P, S, LANES, BCAST, ROTL)                   \
+__attribute__((target(TARGET)))                                                          \
+static void chacha20_##NAME##_blocks(uint32_t *state, const uint8_t *in, uint8_t *out,   \
+                                     size_t nblocks)                                     \
+{                                                                                        \
+    uint32_t step[16] = {0};                                                             \
+    for (int l = 0; l < LANES; l++) step[4 * l] = LANES;                                 \
+    const VEC s0 = BCAST(state), s1 = BCAST(state + 4), s2 = BCAST(state + 8);           \
+    const VEC inc = P##_loadu_##S((const VEC *)step);                                    \
+    VEC s3 = P##_add_epi32(BCAST(state + 12), P##_loadu_##S((const VEC *)chacha_lane_ctr)); \
+    size_t i = 0;                                                                        \
+    for (; i + 2 * LANES <= nblocks; i += 2 * LANES) {                                   \
+        VEC a0 = s0, a1 = s1, a2 = s2, a3 = s3;                                          \
+        VEC b0 = s0, b1 = s1, b2 = s2, b3 = P##_add_epi32(s3, inc);                      \
+        for (int r = 0; r < 10; r++) {                                                   \
+            CHACHA_HALF(P, S, ROTL, a0, a1, a2, a3)                                      \
+            CHACHA_HALF(P, S, ROTL, b0, b1, b2, b3)                                      \
+            CHACHA_DIAG(P, a1, a2, a3)                                                   \
+            CHACHA_DIAG(P, b1, b2, b3)                                                   \
+            CHACHA_HALF(P, S, ROTL, a0, a1, a2, a3)                                      \
+            CHACHA_HALF(P, S, ROTL, b0, b1, b2, b3)                                      \
+            CHACHA_UNDIAG(P, a1, a2, a3)                                                 \
+            CHACHA_UNDIAG(P, b1, b2, b3)                                                 \
+        }                                                                                \
+        NAME##_xor_rows(in, out, P##_add_epi32(a0, s0), P##_add_epi32(a1, s1),           \
+                        P##_add_epi32(a2, s2), P##_add_epi32(a3, s3));                   \
+        s3 = P##_add_epi32(s3, inc);                                                     \
+        NAME##_xor_rows(in + LANES * CHACHA20_BLOCK_SIZE, out + LANES * CHACHA20_BLOCK_SIZE, \
+                        P##_add_epi32(b0, s0), P##_add_epi32(b1, s1),                    \
+                        P##_add_epi32(b2, s2), P##_add_epi32(b3, s3));                   \
+        s3 = P##_add_epi32(s3, inc);                                                     \
+        in += 2 * LANES * CHACHA20_BLOCK_SIZE;                                           \
+        out += 2 * LANES * CHACHA20_BLOCK_SIZE;                                          \
+    }                                                                                    \
+    state[12] += (uint32_t)i;                                                            \
+    chacha20_scalar_blocks(state, in, out, nblocks - i);                                 \
+}
+
+#define SSE2_BCAST(p)   _mm_loadu_si128((const __m128i *)(p))
+#define AVX2_BCAST(p)   _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(p)))
+#define AVX512_BCAST(p) _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *)(p)))
+
+CHACHA_SIMD_KERNEL(sse2,   "sse2",    __m128i, _mm,    si128, 1, SSE2_BCAST,   SSE2_ROTL)
+CHACHA_SIMD_KERNEL(avx2,   "avx2",    __m256i, _mm256, si256, 2, AVX2_BCAST,   AVX2_ROTL)
+CHACHA_SIMD_KERNEL(avx512, "avx512f", __m512i, _mm512, si512, 4, AVX512_BCAST, AVX512_ROTL)
+#endif
+
+// Kernels in order of preference; the first usable one is picked
+typedef struct {
+    const char *name;
+    chacha20_blocks_fn blocks;
+} chacha20_backend_t;
+
+static const chacha20_backend_t chacha20_backends[] = {
+#ifdef CHACHA_HAVE_X86_SIMD
+    { "avx512", chacha20_avx512_blocks },
+    { "avx2",   chacha20_avx2_blocks },
+    { "sse2",   chacha20_sse2_blocks },
+#endif
+    { "scalar", chacha20_scalar_blocks },
+};
+
+static int chacha20_backend_supported(const char *name) {
+#ifdef CHACHA_HAVE_X86_SIMD
+    if (!strcmp(name, "avx512")) return __builtin_cpu_supports("avx512f");
+    if (!strcmp(name, "avx2"))   return __builtin_cpu_supports("avx2");
+    if (!strcmp(name, "sse2"))   return __builtin_cpu_supports("sse2");
+#endif
+    return !strcmp(name, "scalar");
+}
+
+// Kernel chacha20_init binds first, NULL to take the fastest one
+static const char *chacha20_default_backend;
+
+int chacha20_set_default_backend(const char *name) {
+    if (!name) {
+        chacha20_default_backend = NULL;
+        return 0;
+    }
+    for (size_t i = 0; i < sizeof chacha20_backends / sizeof chacha20_backends[0]; i++) {
+        if (strcmp(chacha20_backends[i].name, name) != 0) continue;
+        if (!chacha20_backend_supported(name)) return -1;
+        chacha20_default_backend = chacha20_backends[i].name;
+        return 0;
+    }
+    return -1;
+}
+
+void chacha20_init(chacha20_ctx_t *ctx, const uint8_t *key, const uint8_t *nonce, uint32_t counter) {
+    sccrypto_init();
+    // "expand 32-byte k"
+    ctx->state[0] = 0x61707865;
+    ctx->state[1] = 0x3320646e;
+    ctx->state[2] = 0x79622d32;
+    ctx->state[3] = 0x6b206574;
+    for (int i = 0; i < 8; i++) ctx->state[4 + i] = load_le32(key + 4 * i);
+    ctx->state[12] = counter;
+    for (int i = 0; i < 3; i++) ctx->state[13 + i] = load_le32(nonce + 4 * i);
+    ctx->ks_used = CHACHA20_BLOCK_SIZE;
+
+    if (chacha20_default_backend && chacha20_set_backend(ctx, chacha20_default_backend) == 0) {
+        return;
+    }
+    for (size_t i = 0; i < sizeof chacha20_backends / sizeof chacha20_backends[0]; i++) {
+        if (chacha20_set_backend(ctx, chacha20_backends[i].name) == 0) {
+            break;
+        }
+    }
+}
+
+int chacha20_set_backend(chacha20_ctx_t *ctx, const char *name) {
+    for (size_t i = 0; i < sizeof chacha20_backends / sizeof chacha20_backends[0]; i++) {
+        if (strcmp(chacha20_backends[i].name, name) != 0) continue;
+        if (!chacha20_backend_supported(name)) return -1;
+        ctx->blocks = chacha20_backends[i].blocks;
+        ctx->backend = chacha20_backends[i].name;
+        return 0;
+    }
+    return -1;
+}
+
+void chacha20_xor(chacha20_ctx_t *ctx, const uint8_t *in, uint8_t *out, size_t len) {
+    // finish a block started by an earlier call
+    while (len > 0 && ctx->ks_used < CHACHA20_BLOCK_SIZE) {
+        *out++ = *in++ ^ ctx->ks[ctx->ks_used++];
+        len--;
+    }
+    size_t nblocks = len / CHACHA20_BLOCK_SIZE;
+    if (nblocks) {
+        ctx->blocks(ctx->state, in, out, nblocks);
+        in += nblocks * CHACHA20_BLOCK_SIZE;
+        out += nblocks * CHACHA20_BLOCK_SIZE;
+        len -= nblocks * CHACHA20_BLOCK_SIZE;
+    }
+    if (len) {
+        memset(ctx->ks, 0, sizeof ctx->ks);
+        chacha20_scalar_blocks(ctx->state, ctx->ks, ctx->ks, 1);
+        for (size_t i = 0; i < len; i++) out[i] = in[i] ^ ctx->ks[i];
+        ctx->ks_used = len;
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef CHACHA20_H
+#define CHACHA20_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ChaCha20 (RFC 8439: 256-bit key, 96-bit nonce, 32-bit block counter)
+#define CHACHA20_KEY_SIZE   32
+#define CHACHA20_NONCE_SIZE 12
+#define CHACHA20_BLOCK_SIZE 64
+
+// XORs nblocks whole blocks of keystream into in -> out and advances the
+// block counter in state[12]
+typedef void (*chacha20_blocks_fn)(uint32_t *state, const uint8_t *in, uint8_t *out, size_t nblocks);
+
+typedef struct {
+    uint32_t state[16];
+    uint8_t ks[CHACHA20_BLOCK_SIZE];   // keystream left over from a partial block
+    size_t ks_used;                    // bytes of ks already consumed
+    chacha20_blocks_fn blocks;
+    const char *backend;               // "avx512", "avx2", "sse2" or "scalar"
+} chacha20_ctx_t;
+
+// Binds the default kernel, else the fastest one the CPU supports
+void chacha20_init(chacha20_ctx_t *ctx, const uint8_t *key, const uint8_t *nonce, uint32_t counter);
+// Forces a kernel by name; -1 if unknown or not supported by this CPU
+int  chacha20_set_backend(chacha20_ctx_t *ctx, const char *name);
+// Kernel for every later chacha20_init (NULL: the fastest again); -1 like
+// set_backend. Not thread-safe against concurrent inits.
+int  chacha20_set_default_backend(const char *name);
+// Stream XOR; calls may split the data anywhere
+void chacha20_xor(chacha20_ctx_t *ctx, const uint8_t *in, uint8_t *out, size_t len);
+
+#endif /* CHACHA20_H */
@@ -0,0 +1,72 @@
+#include "chacha20poly1305.h"
+#include <string.h>
+
+// The cipher and the MAC walk the message in slices of this size, so the
+// MAC reads ciphertext that is still in L1/L2 instead of a second pass
+// over the whole buffer
+#define AEAD_SLICE (16u * 1024)
+
+// Block 0 of the keystream keys Poly1305; encryption starts at block 1
+static void aead_setup(chacha20_ctx_t *cc, poly1305_ctx_t *mac, const uint8_t *ad, size_t ad_len,
+                       const uint8_t *nonce, const uint8_t *key) {
+    uint8_t otk[CHACHA20_BLOCK_SIZE] = {0};
+    static const uint8_t zero[16] = {0};
+
+    chacha20_init(cc, key, nonce, 0);
+    chacha20_xor(cc, otk, otk, sizeof otk);
+    poly1305_init(mac, otk);
+    memset(otk, 0, sizeof otk);
+    poly1305_update(mac, ad, ad_len);
+    poly1305_update(mac, zero, (16 - ad_len % 16) % 16);
+}
+
+static void aead_tag(poly1305_ctx_t *mac, uint8_t *tag, size_t ad_len, size_t len) {
+    static const uint8_t zero[16] = {0};
+    uint8_t lens[16];
+
+    poly1305_update(mac, zero, (16 - len % 16) % 16);
+    for (int i = 0; i < 8; i++) {
+        lens[i] = (uint8_t)((uint64_t)ad_len >> (8 * i));
+        lens[8 + i] = (uint8_t)((uint64_t)len >> (8 * i));
+    }
+    poly1305_update(mac, lens, sizeof lens);
+    poly1305_final(mac, tag);
+}
+
+void aead_encrypt(uint8_t *ct, uint8_t *tag, const uint8_t *pt, size_t len,
+                  const uint8_t *ad, size_t ad_len, const uint8_t *nonce, const uint8_t *key) {
+    chacha20_ctx_t cc;
+    poly1305_ctx_t mac;
+
+    aead_setup(&cc, &mac, ad, ad_len, nonce, key);
+    for (size_t off = 0; off < len; off += AEAD_SLICE) {
+        size_t n = len - off < AEAD_SLICE ? len - off : AEAD_SLICE;
+        chacha20_xor(&cc, pt + off, ct + off, n);
+        poly1305_update(&mac, ct + off, n);
+    }
+    aead_tag(&mac, tag, ad_len, len);
+    memset(&cc, 0, sizeof cc);
+}
+
+int aead_decrypt(uint8_t *pt, const uint8_t *ct, size_t len, const uint8_t *tag,
+                 const uint8_t *ad, size_t ad_len, const uint8_t *nonce, const uint8_t *key) {
+    chacha20_ctx_t cc;
+    poly1305_ctx_t mac;
+    uint8_t expect[AEAD_TAG_SIZE], diff = 0;
+
+    aead_setup(&cc, &mac, ad, ad_len, nonce, key);
+    for (size_t off = 0; off < len; off += AEAD_SLICE) {
+        size_t n = len - off < AEAD_SLICE ? len - off : AEAD_SLICE;
+        poly1305_update(&mac, ct + off, n);
+        chacha20_xor(&cc, ct + off, pt + off, n);
+    }
+    aead_tag(&mac, expect, ad_len, len);
+    memset(&cc, 0, sizeof cc);
+
+    for (int i = 0; i < AEAD_TAG_SIZE; i++) diff |= (uint8_t)(expect[i] ^ tag[i]);
+    if (diff) {
+        memset(pt, 0, len);
+        return -1;
+    }
+    return 0;
+}
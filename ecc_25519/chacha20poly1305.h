@@ -0,0 +1,20 @@
+#ifndef CHACHA20POLY1305_H
+#define CHACHA20POLY1305_H
+
+#include "chacha20.h"
+#include "poly1305.h"
+
+// ChaCha20-Poly1305 AEAD (RFC 8439). The ciphertext has the length of the
+// plaintext; the 16-byte tag covers the associated data and ciphertext.
+#define AEAD_KEY_SIZE   CHACHA20_KEY_SIZE
+#define AEAD_NONCE_SIZE CHACHA20_NONCE_SIZE
+#define AEAD_TAG_SIZE   POLY1305_TAG_SIZE
+
+void aead_encrypt(uint8_t *ct, uint8_t *tag, const uint8_t *pt, size_t len,
+                  const uint8_t *ad, size_t ad_len, const uint8_t *nonce, const uint8_t *key);
+
+// Returns 0 if the tag verifies; otherwise -1 and pt is zeroed
+int aead_decrypt(uint8_t *pt, const uint8_t *ct, size_t len, const uint8_t *tag,
+                 const uint8_t *ad, size_t ad_len, const uint8_t *nonce, const uint8_t *key);
+
+#endif /* CHACHA20POLY1305_H */
@@ -2,22 +2,48 @@
 
 static void usage(const char *prog)
 {
-    fprintf(stderr, "Usage: %s (-e|-d) -i <input> -k <key> -o <output>\n", prog);
+    fprintf(stderr, "Usage: %s (-e|-d) [-z] -i <input> -k <key> -o <output>\n", prog);
+    fprintf(stderr, "       %s -e [-z] -i <input> -k <key> -r <key> [-r <key> ...] -o <output>\n", prog);
+    fprintf(stderr, "       %s -e -s [-t <threads>] -i <input> -k <key> -o <output>\n", prog);
+    fprintf(stderr, "       %s (-e [-S]|-d) [-z] [-t <threads>] -l <list> -k <key>\n", prog);
+    fprintf(stderr, "       %s -d --legacy -i <input> -k <key> -o <output>\n", prog);
+    fprintf(stderr, "  -R <keyring> (encrypt): -k and -r give key ids in the keyring\n");
+    fprintf(stderr, "  --legacy (decrypt): also read the old unauthenticated format\n");
+    fprintf(stderr, "  --stats: per-stage time and throughput on stderr; --trace FILE: Chrome trace\n");
     exit(EXIT_FAILURE);
 }
 
 void parse_cli(int argc, char **argv, cli_args_t *a)
 {
-    if (argc < 8) usage(argv[0]);
+    if (argc < 6) usage(argv[0]);
     for (int i = 1; i < argc; i++) {
         if (!strcmp(argv[i], "-e")) a->mode = MODE_ENCRYPT;
         else if (!strcmp(argv[i], "-d")) a->mode = MODE_DECRYPT;
         else if (!strcmp(argv[i], "-i")) a->in_fname = argv[++i];
         else if (!strcmp(argv[i], "-k")) a->key_fname = argv[++i];
         else if (!strcmp(argv[i], "-o")) a->out_fname = argv[++i];
+        else if (!strcmp(argv[i], "-z")) a->compress = 1;
+        else if (!strcmp(argv[i], "-l")) a->list_fname = argv[++i];
+        else if (!strcmp(argv[i], "-S")) a->session = 1;
+        else if (!strcmp(argv[i], "-s")) a->stream = 1;
+        else if (!strcmp(argv[i], "--legacy")) a->legacy = 1;
+        else if (!strcmp(argv[i], "-R") && i + 1 < argc) a->keyring_fname = argv[++i];
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) a->threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc && a->n_recipients < CLI_MAX_RECIPIENTS)
+            a->recipients[a->n_recipients++] = argv[++i];
         else usage(argv[0]);
     }
-    if (!a->in_fname || !a->key_fname || !a->out_fname)
+    if (!a->key_fname || (!a->list_fname && (!a->in_fname || !a->out_fname)))
+        usage(argv[0]);
+    if (a->n_recipients && (a->mode != MODE_ENCRYPT || a->list_fname))
+        usage(argv[0]);
+    if (a->session && (a->mode != MODE_ENCRYPT || !a->list_fname))
+        usage(argv[0]);
+    if (a->keyring_fname && a->mode != MODE_ENCRYPT)
+        usage(argv[0]);
+    if (a->legacy && (a->mode != MODE_DECRYPT || a->list_fname))
+        usage(argv[0]);
+    if (a->stream && (a->mode != MODE_ENCRYPT || a->list_fname || a->n_recipients || a->compress))
         usage(argv[0]);
 }
 
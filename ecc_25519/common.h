@@ -8,11 +8,22 @@
 
 typedef enum { MODE_ENCRYPT, MODE_DECRYPT } crypto_mode_t;
 
+#define CLI_MAX_RECIPIENTS 256
+
 typedef struct {
     crypto_mode_t mode;
     const char *in_fname;
     const char *key_fname;
     const char *out_fname;
+    int compress;          /* -z: LZ stage in front of the cipher */
+    const char *list_fname; /* -l: batch list of "input output" lines */
+    int threads;           /* -t: worker threads, 0 = one per CPU */
+    const char *recipients[CLI_MAX_RECIPIENTS]; /* -r: more public keys (encrypt) */
+    int n_recipients;
+    int session;           /* -S: encrypt the -l list in one ECDH session */
+    const char *keyring_fname; /* -R: -k/-r name key ids in this keyring */
+    int stream;            /* -s: chunked streaming format (encrypt) */
+    int legacy;            /* --legacy: accept the unauthenticated old format (decrypt) */
 } cli_args_t;
 
 void parse_cli(int argc, char **argv, cli_args_t *args);
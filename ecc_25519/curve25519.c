@@ -1,4 +1,13 @@
+#define _POSIX_C_SOURCE 200809L
 #include "curve25519.h"
+#include "field25519.h"
+#include "ge25519.h"
+#include "x25519_avx2.h"
+#include "keypool.h"
+#include "sha512.h"
+#include "chacha20poly1305.h"
+#include "sccrypto.h"
+#include <pthread.h>
 #include <string.h>
 #include <time.h>
 #include <stdint.h>
@@ -6,128 +15,34 @@
 
 #ifdef _WIN32
 #include <windows.h>
+#define RtlGenRandom SystemFunction036
+BOOLEAN NTAPI RtlGenRandom(PVOID buffer, ULONG length);
 #else
 #include <unistd.h>
 #include <sys/types.h>
 #endif
 
-typedef int64_t gf[16];
+#define ECC_BATCH_CHUNK 256   // points per shared inversion
+#define ECC_MAX_THREADS 64
 
-// Constants
-static const gf gf0 = {0};
-static const gf gf1 = {1};
-static const gf _121665 = {0xDB41,1};
-static const uint8_t _9[32] = {9};
-
-// Basic operations
-static void field_copy(gf r, const gf a) {
-    int i;
-    for(i = 0; i < 16; i++) r[i] = a[i];
-}
-
-static void field_carry(gf o) {
-    int i;
-    int64_t c;
-    for(i = 0; i < 16; i++) {
-        o[i] += (1LL << 16);
-        c = o[i] >> 16;
-        o[(i+1)*(i<15)] += c - 1 + 37*(c-1)*(i==15);
-        o[i] -= c << 16;
-    }
-}
-
-static void conditional_swap(gf p, gf q, int b) {
-    int64_t t, i, c = ~(b-1);
-    for(i = 0; i < 16; i++) {
-        t = c & (p[i] ^ q[i]);
-        p[i] ^= t;
-        q[i] ^= t;
-    }
-}
-
-static void field_pack(uint8_t *o, const gf n) {
-    int i, j, b;
-    gf m, t;
-    for(i = 0; i < 16; i++) t[i] = n[i];
-    field_carry(t);
-    field_carry(t);
-    field_carry(t);
-    for(j = 0; j < 2; j++) {
-        m[0] = t[0] - 0xffed;
-        for(i = 1; i < 15; i++) {
-            m[i] = t[i] - 0xffff - ((m[i-1] >> 16) & 1);
-            m[i-1] &= 0xffff;
-        }
-        m[15] = t[15] - 0x7fff - ((m[14] >> 16) & 1);
-        b = (m[15] >> 16) & 1;
-        m[14] &= 0xffff;
-        conditional_swap(t, m, 1-b);
-    }
-    for(i = 0; i < 16; i++) {
-        o[2*i] = t[i] & 0xff;
-        o[2*i+1] = t[i] >> 8;
-    }
-}
-
-static void field_unpack(gf o, const uint8_t *n) {
-    int i;
-    for(i = 0; i < 16; i++) o[i] = n[2*i] + ((int64_t)n[2*i+1] << 8);
-    o[15] &= 0x7fff;
-}
-
-static void field_add(gf o, const gf a, const gf b) {
-    int i;
-    for(i = 0; i < 16; i++) o[i] = a[i] + b[i];
-}
-
-static void field_subtract(gf o, const gf a, const gf b) {
-    int i;
-    for(i = 0; i < 16; i++) o[i] = a[i] - b[i];
-}
-
-static void field_multiply(gf o, const gf a, const gf b) {
-    int64_t i, j, t[31];
-    for(i = 0; i < 31; i++) t[i] = 0;
-    for(i = 0; i < 16; i++) for(j = 0; j < 16; j++) t[i+j] += a[i] * b[j];
-    for(i = 0; i < 15; i++) t[i] += 38 * t[i+16];
-    for(i = 0; i < 16; i++) o[i] = t[i];
-    field_carry(o);
-    field_carry(o);
-}
-
-static void field_square(gf o, const gf a) {
-    field_multiply(o, a, a);
-}
-
-static void field_invert(gf o, const gf i) {
-    gf c;
-    int a;
-    for(a = 0; a < 16; a++) c[a] = i[a];
-    for(a = 253; a >= 0; a--) {
-        field_square(c, c);
-        if(a != 2 && a != 4) field_multiply(c, c, i);
-    }
-    for(a = 0; a < 16; a++) o[a] = c[a];
-}
-
-int crypto_scalarmult(uint8_t *q, const uint8_t *n, const uint8_t *p) {
+// Montgomery ladder over the u-coordinate (RFC 7748), field code in
+// field25519.c. Leaves the projective result n * p = x2 / z2.
+static void x25519_ladder(gf x2, gf z2, const uint8_t *n, const uint8_t *p) {
     uint8_t z[32];
-    int64_t x[80], r, i;
-    gf a, b, c, d, e, f;
+    int64_t r, i;
+    gf x, a, b, c, d, e, f;
     
     for(i = 0; i < 31; i++) z[i] = n[i];
     z[31] = (n[31] & 127) | 64;
     z[0] &= 248;
     field_unpack(x, p);
-    for(i = 0; i < 16; i++) {
-        b[i] = x[i];
-        d[i] = a[i] = c[i] = 0;
-    }
+    field_copy(b, x);
+    for(i = 0; i < 5; i++) d[i] = a[i] = c[i] = 0;
     a[0] = d[0] = 1;
     for(i = 254; i >= 0; --i) {
         r = (z[i >> 3] >> (i & 7)) & 1;
-        conditional_swap(a, b, r);
-        conditional_swap(c, d, r);
+        field_cswap(a, b, r);
+        field_cswap(c, d, r);
         field_add(e, a, c);
         field_subtract(a, a, c);
         field_add(c, b, d);
@@ -140,29 +55,268 @@ int crypto_scalarmult(uint8_t *q, const uint8_t *n, const uint8_t *p) {
         field_subtract(a, a, c);
         field_square(b, a);
         field_subtract(c, d, f);
-        field_multiply(a, c, _121665);
+        field_mul_small(a, c, 121665);
         field_add(a, a, d);
         field_multiply(c, c, a);
         field_multiply(a, d, f);
         field_multiply(d, b, x);
         field_square(b, e);
-        conditional_swap(a, b, r);
-        conditional_swap(c, d, r);
-    }
-    for(i = 0; i < 16; i++) {
-        x[i+16] = a[i];
-        x[i+32] = c[i];
-        x[i+48] = b[i];
-        x[i+64] = d[i];
-    }
-    field_invert(x+32, x+32);
-    field_multiply(x+16, x+16, x+32);
-    field_pack(q, x+16);
+        field_cswap(a, b, r);
+        field_cswap(c, d, r);
+    }
+    field_copy(x2, a);
+    field_copy(z2, c);
+    memset(z, 0, sizeof z);
+}
+
+int crypto_scalarmult(uint8_t *q, const uint8_t *n, const uint8_t *p) {
+    gf x2, z2;
+    x25519_ladder(x2, z2, n, p);
+    field_invert(z2, z2);
+    field_multiply(x2, x2, z2);
+    field_pack(q, x2);
     return 0;
 }
 
+// Fixed-base path: the generator's u = 9 is the Montgomery image of the
+// Ed25519 base point, so n * 9 can use the precomputed Edwards comb table
+// and convert the result back to u = (Z + Y) / (Z - Y). Gives the same
+// bytes as the ladder.
+static void x25519_base_projective(gf num, gf den, const uint8_t *n) {
+    uint8_t z[32];
+    ge_p3 A;
+    
+    memcpy(z, n, 32);
+    z[31] = (n[31] & 127) | 64;
+    z[0] &= 248;
+    ge_scalarmult_base(&A, z);
+    field_add(num, A.Z, A.Y);
+    field_subtract(den, A.Z, A.Y);
+    memset(z, 0, sizeof z);
+}
+
 int crypto_scalarmult_base(uint8_t *q, const uint8_t *n) {
-    return crypto_scalarmult(q, n, _9);
+    gf num, den;
+    x25519_base_projective(num, den, n);
+    field_invert(den, den);
+    field_multiply(num, num, den);
+    field_pack(q, num);
+    return 0;
+}
+
+// ---------- per-recipient tables ------------------------------------------
+// A Montgomery u with an Edwards image is mapped to y = (u - 1) / (u + 1);
+// either sign of x works because u = (1 + y) / (1 - y) does not depend on
+// it. Points on the twist (and u = -1) have no image and keep the ladder.
+// The clamped scalar is used as an integer, not reduced mod the group
+// order, so small-order components come out as with the ladder.
+struct recipient_table {
+    uint8_t public_key[FIELD_SIZE];
+    int usable;                     // 0: table not built, use the ladder
+    ge_precomp table[32][8];
+};
+
+static struct {
+    recipient_table_t *entries[ECC_RECIPIENT_CACHE];
+    int count;
+    pthread_mutex_t lock;
+} recipient_cache = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static void recipient_build(recipient_table_t *t, const uint8_t *public_key) {
+    static const gf one = {1};
+    uint8_t s[FIELD_SIZE];
+    gf u, y, den;
+    ge_p3 P;
+    
+    memcpy(t->public_key, public_key, FIELD_SIZE);
+    t->usable = 0;
+    field_unpack(u, public_key);
+    field_add(den, u, one);
+    if (field_is_zero(den)) return;
+    field_subtract(y, u, one);
+    field_invert(den, den);
+    field_multiply(y, y, den);
+    field_pack(s, y);
+    if (ge_frombytes(&P, s) != 0) return;
+    ge_table_build(t->table, &P);
+    t->usable = 1;
+}
+
+// Cached table for public_key or NULL, without building one
+static const recipient_table_t *recipient_find(const uint8_t *public_key) {
+    const recipient_table_t *t = NULL;
+    pthread_mutex_lock(&recipient_cache.lock);
+    for (int i = 0; i < recipient_cache.count && !t; i++) {
+        if (memcmp(recipient_cache.entries[i]->public_key, public_key, FIELD_SIZE) == 0) {
+            t = recipient_cache.entries[i];
+        }
+    }
+    pthread_mutex_unlock(&recipient_cache.lock);
+    return t;
+}
+
+const recipient_table_t *curve25519_recipient_table(const uint8_t *public_key) {
+    const recipient_table_t *found = recipient_find(public_key);
+    if (found) return found;
+    
+    // built outside the lock; if another thread won the race, keep its table
+    recipient_table_t *t = malloc(sizeof *t);
+    if (t == NULL) return NULL;
+    recipient_build(t, public_key);
+    
+    pthread_mutex_lock(&recipient_cache.lock);
+    for (int i = 0; i < recipient_cache.count; i++) {
+        if (memcmp(recipient_cache.entries[i]->public_key, public_key, FIELD_SIZE) == 0) {
+            found = recipient_cache.entries[i];
+        }
+    }
+    if (!found && recipient_cache.count < ECC_RECIPIENT_CACHE) {
+        recipient_cache.entries[recipient_cache.count++] = t;
+        found = t;
+        t = NULL;
+    }
+    pthread_mutex_unlock(&recipient_cache.lock);
+    free(t);
+    return found;
+}
+
+void curve25519_recipient_cache_clear(void) {
+    pthread_mutex_lock(&recipient_cache.lock);
+    for (int i = 0; i < recipient_cache.count; i++) {
+        free(recipient_cache.entries[i]);
+        recipient_cache.entries[i] = NULL;
+    }
+    recipient_cache.count = 0;
+    pthread_mutex_unlock(&recipient_cache.lock);
+}
+
+static void x25519_table_projective(gf num, gf den, const recipient_table_t *t, const uint8_t *n) {
+    uint8_t z[32];
+    ge_p3 A;
+    
+    if (!t->usable) {
+        x25519_ladder(num, den, n, t->public_key);
+        return;
+    }
+    memcpy(z, n, 32);
+    z[31] = (n[31] & 127) | 64;
+    z[0] &= 248;
+    ge_scalarmult_table(&A, t->table, z);
+    field_add(num, A.Z, A.Y);
+    field_subtract(den, A.Z, A.Y);
+    memset(z, 0, sizeof z);
+}
+
+void curve25519_shared_secret_table(uint8_t *shared, const uint8_t *private_key,
+                                    const recipient_table_t *table) {
+    gf num, den;
+    x25519_table_projective(num, den, table, private_key);
+    field_invert(den, den);
+    field_multiply(num, num, den);
+    field_pack(shared, num);
+}
+
+// ---------- batch scalar multiplication ------------------------------------
+// Work is handed out in chunks of ECC_BATCH_CHUNK entries. Each chunk runs
+// its ladders (or fixed-base multiplications) to projective form and then
+// shares a single inversion among them. On AVX2 machines variable-base
+// ladders run four at a time in x25519_avx2.c.
+typedef struct {
+    uint8_t (*out)[FIELD_SIZE];
+    const uint8_t (*scalars)[FIELD_SIZE];
+    const uint8_t (*points)[FIELD_SIZE];   // NULL: the base point, or table
+    const recipient_table_t *table;        // same point for every entry
+    size_t n, next;
+    pthread_mutex_t lock;
+} batch_job_t;
+
+static void batch_chunk(batch_job_t *job, size_t lo, size_t hi) {
+    gf num[ECC_BATCH_CHUNK], den[ECC_BATCH_CHUNK], scratch[ECC_BATCH_CHUNK];
+    size_t cnt = hi - lo, i = 0;
+    
+    if (job->points && cnt >= 4 && x25519_avx2_available()) {
+        for (; i + 4 <= cnt; i += 4) {
+            const uint8_t *n[4], *p[4];
+            gf x2[4], z2[4];
+            for (int l = 0; l < 4; l++) {
+                n[l] = job->scalars[lo + i + l];
+                p[l] = job->points[lo + i + l];
+            }
+            x25519_ladder4(x2, z2, n, p);
+            for (int l = 0; l < 4; l++) {
+                field_copy(num[i + l], x2[l]);
+                field_copy(den[i + l], z2[l]);
+            }
+        }
+    }
+    for (; i < cnt; i++) {
+        if (job->table) {
+            x25519_table_projective(num[i], den[i], job->table, job->scalars[lo + i]);
+        } else if (job->points) {
+            x25519_ladder(num[i], den[i], job->scalars[lo + i], job->points[lo + i]);
+        } else {
+            x25519_base_projective(num[i], den[i], job->scalars[lo + i]);
+        }
+    }
+    field_batch_invert(den, cnt, scratch);
+    for (i = 0; i < cnt; i++) {
+        field_multiply(num[i], num[i], den[i]);
+        field_pack(job->out[lo + i], num[i]);
+    }
+}
+
+static void *batch_worker(void *arg) {
+    batch_job_t *job = arg;
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        size_t lo = job->next;
+        job->next += ECC_BATCH_CHUNK;
+        pthread_mutex_unlock(&job->lock);
+        if (lo >= job->n) return NULL;
+        batch_chunk(job, lo, lo + ECC_BATCH_CHUNK < job->n ? lo + ECC_BATCH_CHUNK : job->n);
+    }
+}
+
+static void batch_run(batch_job_t *job, int nthreads) {
+    sccrypto_init();
+    size_t nchunks = (job->n + ECC_BATCH_CHUNK - 1) / ECC_BATCH_CHUNK;
+    if (nthreads <= 0) {
+        nthreads = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+        nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    }
+    if (nthreads > ECC_MAX_THREADS) nthreads = ECC_MAX_THREADS;
+    if ((size_t)nthreads > nchunks) nthreads = (int)nchunks;
+    
+    pthread_t tid[ECC_MAX_THREADS];
+    int started = 0;
+    pthread_mutex_init(&job->lock, NULL);
+    for (; started < nthreads - 1; ++started)
+        if (pthread_create(&tid[started], NULL, batch_worker, job) != 0) break;
+    batch_worker(job);                         // the caller works too
+    for (int t = 0; t < started; ++t) pthread_join(tid[t], NULL);
+    pthread_mutex_destroy(&job->lock);
+}
+
+void curve25519_scalarmult_batch(uint8_t (*out)[FIELD_SIZE], const uint8_t (*scalars)[FIELD_SIZE],
+                                 const uint8_t (*points)[FIELD_SIZE], size_t n, int nthreads) {
+    batch_job_t job = { .out = out, .scalars = scalars, .points = points, .n = n };
+    batch_run(&job, nthreads);
+}
+
+void curve25519_compute_public_batch(uint8_t (*public_keys)[FIELD_SIZE],
+                                     const uint8_t (*private_keys)[FIELD_SIZE],
+                                     size_t n, int nthreads) {
+    batch_job_t job = { .out = public_keys, .scalars = private_keys, .n = n };
+    batch_run(&job, nthreads);
+}
+
+// All scalars against one recipient's table
+static void scalarmult_table_batch(uint8_t (*out)[FIELD_SIZE], const uint8_t (*scalars)[FIELD_SIZE],
+                                   const recipient_table_t *table, size_t n, int nthreads) {
+    batch_job_t job = { .out = out, .scalars = scalars, .table = table, .n = n };
+    batch_run(&job, nthreads);
 }
 
 // Our wrapper functions
@@ -178,26 +332,70 @@ void curve25519_shared_secret(uint8_t *shared, const uint8_t *private_key, const
     crypto_scalarmult(shared, private_key, public_key);
 }
 
-// Random number generation for key generation
-static void get_random_bytes(uint8_t *buffer, size_t size) {
-    srand((unsigned int)time(NULL));
-    for (size_t i = 0; i < size; i++) {
-        buffer[i] = (uint8_t)(rand() & 0xFF);
+// Random number generation for key generation, from the OS CSPRNG
+void curve25519_random_bytes(uint8_t *buffer, size_t size) {
+#ifdef _WIN32
+    if (!RtlGenRandom(buffer, (ULONG)size)) {
+        fprintf(stderr, "Error: RtlGenRandom failed\n");
+        exit(EXIT_FAILURE);
+    }
+#else
+    FILE *f = fopen("/dev/urandom", "rb");
+    if (!f || fread(buffer, 1, size, f) != size) {
+        perror("/dev/urandom");
+        exit(EXIT_FAILURE);
     }
+    fclose(f);
+#endif
+}
+
+void curve25519_clamp(uint8_t *private_key) {
+    private_key[0] &= 248;
+    private_key[31] &= 127;
+    private_key[31] |= 64;
 }
 
 void curve25519_generate_keypair(key_pair_t *keypair) {
-    get_random_bytes(keypair->private_key, FIELD_SIZE);
+    curve25519_random_bytes(keypair->private_key, FIELD_SIZE);
     
     // Clamp the private key
-    keypair->private_key[0] &= 248;
-    keypair->private_key[31] &= 127;
-    keypair->private_key[31] |= 64;
+    curve25519_clamp(keypair->private_key);
     
     curve25519_compute_public(keypair->public_key, keypair->private_key);
 }
 
-// Simple XOR-based encryption using a key derived from shared secret
+// ---------- hybrid encryption ----------------------------------------------
+// Format: "SCE1" | ephemeral public key | ChaCha20-Poly1305(body) | tag.
+// The AEAD key and nonce come from HKDF-SHA512 over the shared secret,
+// salted with both public keys; the magic and the ephemeral key are the
+// associated data. Files from before the AEAD format (ephemeral key then
+// the XOR stream below) carry no magic and no tag; ecc_decrypt refuses
+// them, and only ecc_decrypt_legacy (ecc_main -d --legacy) reads them.
+// One whose ephemeral key happens to start with a magic (a 2^-32 chance)
+// is read as that format and fails authentication.
+//
+// Multi-recipient format ("SCM1"): the body is sealed once under a random
+// data key, and the header carries one wrapped copy of that key per
+// recipient:
+//   "SCM1" | u32 count | ephemeral public key | count * slot | body | tag
+//   slot = key id | AEAD(data key) | tag
+// A single ephemeral scalar serves every slot, so wrapping is one batch
+// scalar multiplication. The key id is the start of SHA-512(public key);
+// a reader hashes its own public key and only tries matching slots. The
+// body's associated data is the whole header.
+//
+// Session format ("SCS1"): one ephemeral key per (run, recipient), so a
+// batch of files costs a single key agreement:
+//   "SCS1" | session ephemeral public key | u64 file index | body | tag
+// The session key comes from HKDF over the shared secret; each file's
+// AEAD key and nonce come from HKDF over the session key, salted with the
+// file's header, so indices must not repeat within a session.
+static const uint8_t ecc_kdf_info[] = "sccrypto ecc chacha20-poly1305";
+static const uint8_t ecc_wrap_info[] = "sccrypto ecc multi-recipient wrap";
+static const uint8_t ecc_session_info[] = "sccrypto ecc session";
+static const uint8_t ecc_file_info[] = "sccrypto ecc session file";
+
+// Legacy body cipher: the shared secret itself, rotated every 32 bytes
 static void stream_xor(uint8_t *c, const uint8_t *m, size_t len, const uint8_t *k) {
     uint8_t keystream[FIELD_SIZE];
     memcpy(keystream, k, FIELD_SIZE);
@@ -215,58 +413,465 @@ static void stream_xor(uint8_t *c, const uint8_t *m, size_t len, const uint8_t *
     }
 }
 
+// AEAD key and nonce for one message (or one key slot), or the session
+// key when out_len is FIELD_SIZE. Returns 0 for an all-zero shared secret,
+// i.e. a low-order ephemeral or recipient key.
+static int ecc_derive(uint8_t *out, size_t out_len, const uint8_t *shared, const uint8_t *ephemeral_pub,
+                      const uint8_t *recipient_pub, const uint8_t *info, size_t info_len) {
+    uint8_t salt[2 * FIELD_SIZE], acc = 0;
+    for (int i = 0; i < FIELD_SIZE; i++) acc |= shared[i];
+    if (acc == 0) return 0;
+    memcpy(salt, ephemeral_pub, FIELD_SIZE);
+    memcpy(salt + FIELD_SIZE, recipient_pub, FIELD_SIZE);
+    hkdf_sha512(out, out_len, salt, sizeof salt, shared, FIELD_SIZE, info, info_len);
+    return 1;
+}
+
+// Writes the whole SCE1 message for len bytes of plaintext into out
+static int ecc_seal(uint8_t *out, const uint8_t *ephemeral_pub, const uint8_t *shared,
+                    const uint8_t *recipient_pub, const uint8_t *plaintext, size_t len) {
+    uint8_t kn[AEAD_KEY_SIZE + AEAD_NONCE_SIZE];
+    if (!ecc_derive(kn, sizeof kn, shared, ephemeral_pub, recipient_pub,
+                    ecc_kdf_info, sizeof ecc_kdf_info - 1)) {
+        return 0;
+    }
+    memcpy(out, ECC_MAGIC, ECC_MAGIC_SIZE);
+    memcpy(out + ECC_MAGIC_SIZE, ephemeral_pub, FIELD_SIZE);
+    aead_encrypt(out + ECC_HEADER_SIZE, out + ECC_HEADER_SIZE + len, plaintext, len,
+                 out, ECC_HEADER_SIZE, kn + AEAD_KEY_SIZE, kn);
+    memset(kn, 0, sizeof kn);
+    return 1;
+}
+
+static int ecc_is_sealed(const uint8_t *ciphertext, size_t ciphertext_len) {
+    return ciphertext_len >= ECC_OVERHEAD && memcmp(ciphertext, ECC_MAGIC, ECC_MAGIC_SIZE) == 0;
+}
+
+void ecc_key_id(uint8_t *id, const uint8_t *public_key) {
+    uint8_t digest[SHA512_DIGEST_SIZE];
+    sha512(digest, public_key, FIELD_SIZE);
+    memcpy(id, digest, ECC_KEY_ID_SIZE);
+}
+
+// Header size of an SCM1 message, or 0 if it is not one (or truncated)
+static size_t ecc_multi_header(const uint8_t *ciphertext, size_t ciphertext_len) {
+    if (ciphertext_len < ECC_MULTI_HEADER_SIZE(0) + AEAD_TAG_SIZE ||
+        memcmp(ciphertext, ECC_MULTI_MAGIC, ECC_MAGIC_SIZE) != 0) {
+        return 0;
+    }
+    uint32_t count = 0;
+    for (int i = 3; i >= 0; i--) count = (count << 8) | ciphertext[ECC_MAGIC_SIZE + i];
+    if (count == 0 || count > ECC_MAX_RECIPIENTS) return 0;
+    size_t header = ECC_MULTI_HEADER_SIZE((size_t)count);
+    return ciphertext_len >= header + AEAD_TAG_SIZE ? header : 0;
+}
+
+static int ecc_is_session(const uint8_t *ciphertext, size_t ciphertext_len) {
+    return ciphertext_len >= ECC_SESSION_OVERHEAD &&
+           memcmp(ciphertext, ECC_SESSION_MAGIC, ECC_MAGIC_SIZE) == 0;
+}
+
+// Per-file AEAD key and nonce of a session message, from its header
+static void ecc_session_file_key(uint8_t *key_nonce, const uint8_t *session_key, const uint8_t *header) {
+    hkdf_sha512(key_nonce, AEAD_KEY_SIZE + AEAD_NONCE_SIZE, header, ECC_SESSION_HEADER_SIZE,
+                session_key, FIELD_SIZE, ecc_file_info, sizeof ecc_file_info - 1);
+}
+
+// Ephemeral public key of any format
+static const uint8_t *ecc_ephemeral(const uint8_t *ciphertext, size_t ciphertext_len) {
+    if (ecc_multi_header(ciphertext, ciphertext_len)) return ciphertext + ECC_MAGIC_SIZE + 4;
+    if (ecc_is_session(ciphertext, ciphertext_len)) return ciphertext + ECC_MAGIC_SIZE;
+    return ecc_is_sealed(ciphertext, ciphertext_len) ? ciphertext + ECC_MAGIC_SIZE : ciphertext;
+}
+
+// Finds the recipient's slot, unwraps the data key and opens the body
+static int ecc_open_multi(const uint8_t *ciphertext, size_t ciphertext_len, size_t header,
+                          const uint8_t *shared, const uint8_t *recipient_pub,
+                          uint8_t **plaintext, size_t *plaintext_len) {
+    static const uint8_t zero_nonce[AEAD_NONCE_SIZE] = {0};
+    const uint8_t *ephemeral_pub = ciphertext + ECC_MAGIC_SIZE + 4;
+    uint8_t id[ECC_KEY_ID_SIZE], kn[AEAD_KEY_SIZE + AEAD_NONCE_SIZE], data_key[FIELD_SIZE];
+    int found = 0;
+    
+    if (!ecc_derive(kn, sizeof kn, shared, ephemeral_pub, recipient_pub,
+                    ecc_wrap_info, sizeof ecc_wrap_info - 1)) {
+        return 0;
+    }
+    ecc_key_id(id, recipient_pub);
+    for (size_t off = ECC_MULTI_HEADER_SIZE(0); off < header && !found; off += ECC_SLOT_SIZE) {
+        const uint8_t *slot = ciphertext + off;
+        if (memcmp(slot, id, ECC_KEY_ID_SIZE) != 0) continue;
+        found = aead_decrypt(data_key, slot + ECC_KEY_ID_SIZE, FIELD_SIZE,
+                             slot + ECC_KEY_ID_SIZE + FIELD_SIZE, ciphertext,
+                             ECC_MULTI_HEADER_SIZE(0), kn + AEAD_KEY_SIZE, kn) == 0;
+    }
+    memset(kn, 0, sizeof kn);
+    if (!found) return 0;
+    
+    *plaintext_len = ciphertext_len - header - AEAD_TAG_SIZE;
+    *plaintext = malloc(*plaintext_len + 1);
+    int ok = *plaintext != NULL &&
+             aead_decrypt(*plaintext, ciphertext + header, *plaintext_len,
+                          ciphertext + header + *plaintext_len, ciphertext, header,
+                          zero_nonce, data_key) == 0;
+    memset(data_key, 0, sizeof data_key);
+    if (!ok) {
+        free(*plaintext);
+        *plaintext = NULL;
+    }
+    return ok;
+}
+
+// Opens one SCS1 message; the session key is rederived per message, which
+// is only a few hashes next to the shared secret the caller computed
+static int ecc_open_session(const uint8_t *ciphertext, size_t ciphertext_len, const uint8_t *shared,
+                            const uint8_t *recipient_pub, uint8_t **plaintext, size_t *plaintext_len) {
+    uint8_t session_key[FIELD_SIZE], kn[AEAD_KEY_SIZE + AEAD_NONCE_SIZE];
+    if (!ecc_derive(session_key, sizeof session_key, shared, ciphertext + ECC_MAGIC_SIZE, recipient_pub,
+                    ecc_session_info, sizeof ecc_session_info - 1)) {
+        return 0;
+    }
+    ecc_session_file_key(kn, session_key, ciphertext);
+    memset(session_key, 0, sizeof session_key);
+    
+    *plaintext_len = ciphertext_len - ECC_SESSION_OVERHEAD;
+    *plaintext = malloc(*plaintext_len + 1);
+    int ok = *plaintext != NULL &&
+             aead_decrypt(*plaintext, ciphertext + ECC_SESSION_HEADER_SIZE, *plaintext_len,
+                          ciphertext + ECC_SESSION_HEADER_SIZE + *plaintext_len,
+                          ciphertext, ECC_SESSION_HEADER_SIZE, kn + AEAD_KEY_SIZE, kn) == 0;
+    memset(kn, 0, sizeof kn);
+    if (!ok) {
+        free(*plaintext);
+        *plaintext = NULL;
+    }
+    return ok;
+}
+
+// Decrypts any format into a new buffer; shared is the secret for the
+// message's ephemeral key. Input without a known magic is refused unless
+// legacy is set, when it is taken as the unauthenticated legacy format.
+static int ecc_open(const uint8_t *ciphertext, size_t ciphertext_len, const uint8_t *shared,
+                    const uint8_t *recipient_pub, uint8_t **plaintext, size_t *plaintext_len,
+                    int legacy) {
+    size_t header = ecc_multi_header(ciphertext, ciphertext_len);
+    if (header) {
+        return ecc_open_multi(ciphertext, ciphertext_len, header, shared, recipient_pub,
+                              plaintext, plaintext_len);
+    }
+    if (ecc_is_session(ciphertext, ciphertext_len)) {
+        return ecc_open_session(ciphertext, ciphertext_len, shared, recipient_pub,
+                                plaintext, plaintext_len);
+    }
+    if (!ecc_is_sealed(ciphertext, ciphertext_len)) {
+        if (!legacy) return 0;
+        *plaintext_len = ciphertext_len - FIELD_SIZE;
+        *plaintext = malloc(*plaintext_len + 1);
+        if (*plaintext == NULL) return 0;
+        stream_xor(*plaintext, ciphertext + FIELD_SIZE, *plaintext_len, shared);
+        return 1;
+    }
+    
+    uint8_t kn[AEAD_KEY_SIZE + AEAD_NONCE_SIZE];
+    if (!ecc_derive(kn, sizeof kn, shared, ciphertext + ECC_MAGIC_SIZE, recipient_pub,
+                    ecc_kdf_info, sizeof ecc_kdf_info - 1)) {
+        return 0;
+    }
+    *plaintext_len = ciphertext_len - ECC_OVERHEAD;
+    *plaintext = malloc(*plaintext_len + 1);
+    int ok = *plaintext != NULL &&
+             aead_decrypt(*plaintext, ciphertext + ECC_HEADER_SIZE, *plaintext_len,
+                          ciphertext + ECC_HEADER_SIZE + *plaintext_len,
+                          ciphertext, ECC_HEADER_SIZE, kn + AEAD_KEY_SIZE, kn) == 0;
+    memset(kn, 0, sizeof kn);
+    if (!ok) {
+        free(*plaintext);
+        *plaintext = NULL;
+    }
+    return ok;
+}
+
 int ecc_encrypt(const uint8_t *public_key, const uint8_t *plaintext, 
                 size_t plaintext_len, uint8_t **ciphertext, size_t *ciphertext_len) {
     
-    // Generate ephemeral key pair
+    // Ephemeral key pair, from the pool when keypool_start has been called
     key_pair_t ephemeral;
-    curve25519_generate_keypair(&ephemeral);
+    keypool_take(&ephemeral);
     
     // Compute shared secret
     uint8_t shared_secret[FIELD_SIZE];
-    curve25519_shared_secret(shared_secret, ephemeral.private_key, public_key);
+    const recipient_table_t *table = recipient_find(public_key);
+    if (table) {
+        curve25519_shared_secret_table(shared_secret, ephemeral.private_key, table);
+    } else {
+        curve25519_shared_secret(shared_secret, ephemeral.private_key, public_key);
+    }
     
-    // Allocate ciphertext: ephemeral public key + encrypted data
-    *ciphertext_len = FIELD_SIZE + plaintext_len;
+    // Allocate ciphertext: header + encrypted data + tag
+    *ciphertext_len = ECC_OVERHEAD + plaintext_len;
     *ciphertext = malloc(*ciphertext_len);
-    if (*ciphertext == NULL) {
-        return 0; // Return 0 for failure
+    int ok = *ciphertext != NULL &&
+             ecc_seal(*ciphertext, ephemeral.public_key, shared_secret, public_key,
+                      plaintext, plaintext_len);
+    if (!ok) {
+        free(*ciphertext);
+        *ciphertext = NULL;
     }
     
-    // Store ephemeral public key at the beginning
-    memcpy(*ciphertext, ephemeral.public_key, FIELD_SIZE);
+    // The ephemeral pair is single-use
+    memset(&ephemeral, 0, sizeof ephemeral);
+    memset(shared_secret, 0, sizeof shared_secret);
+    return ok; // 1 for success, 0 for failure
+}
+
+static int ecc_decrypt_any(const uint8_t *private_key, const uint8_t *ciphertext,
+                           size_t ciphertext_len, uint8_t **plaintext, size_t *plaintext_len,
+                           int legacy) {
+    if (ciphertext_len < FIELD_SIZE) {
+        return 0; // Return 0 for failure
+    }
     
-    // Encrypt the plaintext using XOR with shared secret
-    stream_xor(*ciphertext + FIELD_SIZE, plaintext, plaintext_len, shared_secret);
+    // Compute shared secret with the ephemeral public key
+    uint8_t shared_secret[FIELD_SIZE], public_key[FIELD_SIZE];
+    curve25519_shared_secret(shared_secret, private_key, ecc_ephemeral(ciphertext, ciphertext_len));
+    curve25519_compute_public(public_key, private_key);
     
-    return 1; // Return 1 for success
+    int ok = ecc_open(ciphertext, ciphertext_len, shared_secret, public_key,
+                      plaintext, plaintext_len, legacy);
+    memset(shared_secret, 0, sizeof shared_secret);
+    return ok;
 }
 
 int ecc_decrypt(const uint8_t *private_key, const uint8_t *ciphertext,
                 size_t ciphertext_len, uint8_t **plaintext, size_t *plaintext_len) {
+    return ecc_decrypt_any(private_key, ciphertext, ciphertext_len, plaintext, plaintext_len, 0);
+}
+
+int ecc_decrypt_legacy(const uint8_t *private_key, const uint8_t *ciphertext,
+                       size_t ciphertext_len, uint8_t **plaintext, size_t *plaintext_len) {
+    return ecc_decrypt_any(private_key, ciphertext, ciphertext_len, plaintext, plaintext_len, 1);
+}
+
+int ecc_encrypt_multi(const uint8_t (*public_keys)[FIELD_SIZE], size_t n_recipients,
+                      const uint8_t *plaintext, size_t plaintext_len,
+                      uint8_t **ciphertext, size_t *ciphertext_len, int nthreads) {
+    static const uint8_t zero_nonce[AEAD_NONCE_SIZE] = {0};
+    if (n_recipients == 0 || n_recipients > ECC_MAX_RECIPIENTS) {
+        return 0;
+    }
+    size_t header = ECC_MULTI_HEADER_SIZE(n_recipients);
+    uint8_t (*keys)[FIELD_SIZE] = malloc(2 * n_recipients * FIELD_SIZE);
+    *ciphertext_len = header + plaintext_len + AEAD_TAG_SIZE;
+    *ciphertext = malloc(*ciphertext_len);
+    if (keys == NULL || *ciphertext == NULL) {
+        free(keys);
+        free(*ciphertext);
+        *ciphertext = NULL;
+        return 0;
+    }
+    uint8_t (*scalars)[FIELD_SIZE] = keys, (*shared)[FIELD_SIZE] = keys + n_recipients;
+    uint8_t *out = *ciphertext, data_key[FIELD_SIZE];
+    key_pair_t ephemeral;
     
-    if (ciphertext_len < FIELD_SIZE) {
-        return 0; // Return 0 for failure
+    keypool_take(&ephemeral);
+    curve25519_random_bytes(data_key, sizeof data_key);
+    for (size_t i = 0; i < n_recipients; i++) {
+        memcpy(scalars[i], ephemeral.private_key, FIELD_SIZE);
     }
+    curve25519_scalarmult_batch(shared, (const uint8_t (*)[FIELD_SIZE])scalars, public_keys,
+                                n_recipients, nthreads);
     
-    // Extract ephemeral public key
-    const uint8_t *ephemeral_public_key = ciphertext;
+    memcpy(out, ECC_MULTI_MAGIC, ECC_MAGIC_SIZE);
+    for (int i = 0; i < 4; i++) out[ECC_MAGIC_SIZE + i] = (uint8_t)(n_recipients >> (8 * i));
+    memcpy(out + ECC_MAGIC_SIZE + 4, ephemeral.public_key, FIELD_SIZE);
+    int ok = 1;
+    for (size_t i = 0; i < n_recipients && ok; i++) {
+        uint8_t kn[AEAD_KEY_SIZE + AEAD_NONCE_SIZE];
+        uint8_t *slot = out + ECC_MULTI_HEADER_SIZE(i);
+        ok = ecc_derive(kn, sizeof kn, shared[i], ephemeral.public_key, public_keys[i],
+                        ecc_wrap_info, sizeof ecc_wrap_info - 1);
+        if (!ok) break;
+        ecc_key_id(slot, public_keys[i]);
+        aead_encrypt(slot + ECC_KEY_ID_SIZE, slot + ECC_KEY_ID_SIZE + FIELD_SIZE, data_key, FIELD_SIZE,
+                     out, ECC_MULTI_HEADER_SIZE(0), kn + AEAD_KEY_SIZE, kn);
+        memset(kn, 0, sizeof kn);
+    }
+    if (ok) {
+        aead_encrypt(out + header, out + header + plaintext_len, plaintext, plaintext_len,
+                     out, header, zero_nonce, data_key);
+    } else {
+        free(*ciphertext);
+        *ciphertext = NULL;
+    }
     
-    // Compute shared secret
+    memset(&ephemeral, 0, sizeof ephemeral);
+    memset(data_key, 0, sizeof data_key);
+    memset(keys, 0, 2 * n_recipients * FIELD_SIZE);
+    free(keys);
+    return ok;
+}
+
+int ecc_session_begin(ecc_session_t *session, const uint8_t *public_key) {
+    key_pair_t ephemeral;
     uint8_t shared_secret[FIELD_SIZE];
-    curve25519_shared_secret(shared_secret, private_key, ephemeral_public_key);
+    const recipient_table_t *table = recipient_find(public_key);
     
-    // Allocate plaintext
-    *plaintext_len = ciphertext_len - FIELD_SIZE;
-    *plaintext = malloc(*plaintext_len);
-    if (*plaintext == NULL) {
-        return 0; // Return 0 for failure
+    keypool_take(&ephemeral);
+    if (table) {
+        curve25519_shared_secret_table(shared_secret, ephemeral.private_key, table);
+    } else {
+        curve25519_shared_secret(shared_secret, ephemeral.private_key, public_key);
     }
+    memcpy(session->ephemeral_pub, ephemeral.public_key, FIELD_SIZE);
+    session->next_index = 0;
+    int ok = ecc_derive(session->session_key, FIELD_SIZE, shared_secret, ephemeral.public_key,
+                        public_key, ecc_session_info, sizeof ecc_session_info - 1);
     
-    // Decrypt the ciphertext using XOR with shared secret
-    stream_xor(*plaintext, ciphertext + FIELD_SIZE, *plaintext_len, shared_secret);
+    memset(&ephemeral, 0, sizeof ephemeral);
+    memset(shared_secret, 0, sizeof shared_secret);
+    if (!ok) {
+        ecc_session_end(session);
+    }
+    return ok;
+}
+
+int ecc_session_encrypt(ecc_session_t *session, const uint8_t *plaintext, size_t plaintext_len,
+                        uint8_t **ciphertext, size_t *ciphertext_len) {
+    if (session->next_index == UINT64_MAX) {
+        return 0;
+    }
+    *ciphertext_len = ECC_SESSION_OVERHEAD + plaintext_len;
+    *ciphertext = malloc(*ciphertext_len);
+    if (*ciphertext == NULL) {
+        return 0;
+    }
     
-    return 1; // Return 1 for success
+    uint8_t *out = *ciphertext, kn[AEAD_KEY_SIZE + AEAD_NONCE_SIZE];
+    uint64_t index = session->next_index++;
+    memcpy(out, ECC_SESSION_MAGIC, ECC_MAGIC_SIZE);
+    memcpy(out + ECC_MAGIC_SIZE, session->ephemeral_pub, FIELD_SIZE);
+    for (int i = 0; i < 8; i++) out[ECC_HEADER_SIZE + i] = (uint8_t)(index >> (8 * i));
+    ecc_session_file_key(kn, session->session_key, out);
+    aead_encrypt(out + ECC_SESSION_HEADER_SIZE, out + ECC_SESSION_HEADER_SIZE + plaintext_len,
+                 plaintext, plaintext_len, out, ECC_SESSION_HEADER_SIZE, kn + AEAD_KEY_SIZE, kn);
+    memset(kn, 0, sizeof kn);
+    return 1;
+}
+
+void ecc_session_end(ecc_session_t *session) {
+    memset(session, 0, sizeof *session);
+    session->next_index = UINT64_MAX;
+}
+
+// Batch forms for many messages under one key: the ephemeral public keys
+// and the shared secrets each go through one batch scalar multiplication
+int ecc_encrypt_batch(const uint8_t *public_key, size_t n,
+                      const uint8_t *const *plaintexts, const size_t *plaintext_lens,
+                      uint8_t **ciphertexts, size_t *ciphertext_lens, int nthreads) {
+    uint8_t (*keys)[FIELD_SIZE] = malloc(4 * n * FIELD_SIZE + 1);
+    if (keys == NULL) {
+        return 0;
+    }
+    uint8_t (*priv)[FIELD_SIZE] = keys, (*pub)[FIELD_SIZE] = keys + n;
+    uint8_t (*points)[FIELD_SIZE] = keys + 2 * n, (*shared)[FIELD_SIZE] = keys + 3 * n;
+    
+    // Ephemeral pairs from the key pool while it has some; the rest are
+    // generated here in one batch
+    size_t pooled = keypool_take_batch(priv, pub, n);
+    if (pooled < n) {
+        curve25519_random_bytes(&priv[pooled][0], (n - pooled) * FIELD_SIZE);
+        for (size_t i = pooled; i < n; i++) {
+            curve25519_clamp(priv[i]);
+        }
+        curve25519_compute_public_batch(pub + pooled, (const uint8_t (*)[FIELD_SIZE])(priv + pooled),
+                                        n - pooled, nthreads);
+    }
+    for (size_t i = 0; i < n; i++) {
+        memcpy(points[i], public_key, FIELD_SIZE);
+    }
+    const recipient_table_t *table = n >= ECC_TABLE_MIN_BATCH ? curve25519_recipient_table(public_key)
+                                                              : recipient_find(public_key);
+    if (table) {
+        scalarmult_table_batch(shared, (const uint8_t (*)[FIELD_SIZE])priv, table, n, nthreads);
+    } else {
+        curve25519_scalarmult_batch(shared, (const uint8_t (*)[FIELD_SIZE])priv,
+                                    (const uint8_t (*)[FIELD_SIZE])points, n, nthreads);
+    }
+    
+    int ok = 1;
+    for (size_t i = 0; i < n; i++) {
+        ciphertext_lens[i] = ECC_OVERHEAD + plaintext_lens[i];
+        ciphertexts[i] = ok ? malloc(ciphertext_lens[i]) : NULL;
+        if (ciphertexts[i] == NULL ||
+            !ecc_seal(ciphertexts[i], pub[i], shared[i], public_key, plaintexts[i], plaintext_lens[i])) {
+            ok = 0;
+        }
+    }
+    if (!ok) {
+        for (size_t i = 0; i < n; i++) {
+            free(ciphertexts[i]);
+            ciphertexts[i] = NULL;
+        }
+    }
+    memset(keys, 0, 4 * n * FIELD_SIZE);
+    free(keys);
+    return ok;
+}
+
+int ecc_decrypt_batch(const uint8_t *private_key, size_t n,
+                      const uint8_t *const *ciphertexts, const size_t *ciphertext_lens,
+                      uint8_t **plaintexts, size_t *plaintext_lens, int nthreads) {
+    for (size_t i = 0; i < n; i++) {
+        if (ciphertext_lens[i] < FIELD_SIZE) {
+            return 0;
+        }
+    }
+    uint8_t (*keys)[FIELD_SIZE] = malloc(3 * n * FIELD_SIZE + 1);
+    size_t *slot = malloc(n * sizeof *slot + 1);
+    if (keys == NULL || slot == NULL) {
+        free(keys);
+        free(slot);
+        return 0;
+    }
+    uint8_t (*scalars)[FIELD_SIZE] = keys, (*points)[FIELD_SIZE] = keys + n;
+    uint8_t (*shared)[FIELD_SIZE] = keys + 2 * n;
+    uint8_t public_key[FIELD_SIZE];
+    size_t unique = 0;
+    
+    // Messages of one session share their ephemeral key, so each distinct
+    // key is multiplied once
+    for (size_t i = 0; i < n; i++) {
+        const uint8_t *eph = ecc_ephemeral(ciphertexts[i], ciphertext_lens[i]);
+        size_t j = 0;
+        while (j < unique && memcmp(points[j], eph, FIELD_SIZE) != 0) j++;
+        if (j == unique) {
+            memcpy(scalars[unique], private_key, FIELD_SIZE);
+            memcpy(points[unique++], eph, FIELD_SIZE);
+        }
+        slot[i] = j;
+    }
+    curve25519_scalarmult_batch(shared, (const uint8_t (*)[FIELD_SIZE])scalars,
+                                (const uint8_t (*)[FIELD_SIZE])points, unique, nthreads);
+    curve25519_compute_public(public_key, private_key);
+    
+    int ok = 1;
+    for (size_t i = 0; i < n; i++) {
+        plaintexts[i] = NULL;
+        if (ok && !ecc_open(ciphertexts[i], ciphertext_lens[i], shared[slot[i]], public_key,
+                            &plaintexts[i], &plaintext_lens[i], 0)) {
+            ok = 0;
+        }
+    }
+    if (!ok) {
+        for (size_t i = 0; i < n; i++) {
+            free(plaintexts[i]);
+            plaintexts[i] = NULL;
+        }
+    }
+    memset(keys, 0, 3 * n * FIELD_SIZE);
+    free(keys);
+    free(slot);
+    return ok;
 }
 
 // Key file handling functions
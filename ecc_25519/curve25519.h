@@ -18,6 +18,61 @@ void curve25519_generate_keypair(key_pair_t *keypair);
 void curve25519_compute_public(uint8_t *public_key, const uint8_t *private_key);
 void curve25519_shared_secret(uint8_t *shared, const uint8_t *private_key, const uint8_t *public_key);
 void curve25519_scalarmult(uint8_t *q, const uint8_t *n, const uint8_t *p);
+void curve25519_random_bytes(uint8_t *buffer, size_t size);
+void curve25519_clamp(uint8_t *private_key);
+
+// Batch X25519: out[i] = scalars[i] * points[i] for i < n. The inversion
+// that ends every ladder is shared across chunks of entries (Montgomery's
+// trick) and the chunks are spread over nthreads threads (<= 0: one per
+// CPU). Output is byte-identical to curve25519_scalarmult.
+void curve25519_scalarmult_batch(uint8_t (*out)[FIELD_SIZE], const uint8_t (*scalars)[FIELD_SIZE],
+                                 const uint8_t (*points)[FIELD_SIZE], size_t n, int nthreads);
+// Same for public keys, using the fixed-base path
+void curve25519_compute_public_batch(uint8_t (*public_keys)[FIELD_SIZE],
+                                     const uint8_t (*private_keys)[FIELD_SIZE],
+                                     size_t n, int nthreads);
+
+// Per-recipient tables for repeated encryption to the same public key.
+// curve25519_recipient_table returns the cached table for public_key,
+// building it on first use: the key's point is mapped to Edwards form and
+// its multiples stored in the constant-time comb layout of the fixed-base
+// path, so later shared secrets with it cost about half a ladder. Tables
+// stay cached (and the pointer valid) until curve25519_recipient_cache_clear.
+// NULL means the cache is full or out of memory; use the plain functions.
+#define ECC_RECIPIENT_CACHE 64   // recipients kept at once
+#define ECC_TABLE_MIN_BATCH 8    // batch size that pays for building a table
+
+typedef struct recipient_table recipient_table_t;
+
+const recipient_table_t *curve25519_recipient_table(const uint8_t *public_key);
+void curve25519_shared_secret_table(uint8_t *shared, const uint8_t *private_key,
+                                    const recipient_table_t *table);
+void curve25519_recipient_cache_clear(void);
+
+// Hybrid encryption format: ECC_MAGIC | ephemeral public key | body | tag,
+// the body encrypted with ChaCha20-Poly1305 under an HKDF-SHA512 key
+#define ECC_MAGIC       "SCE1"
+#define ECC_MAGIC_SIZE  4
+#define ECC_HEADER_SIZE (ECC_MAGIC_SIZE + FIELD_SIZE)
+#define ECC_OVERHEAD    (ECC_HEADER_SIZE + 16)   // + Poly1305 tag
+
+// Multi-recipient format: ECC_MULTI_MAGIC | u32 count | ephemeral public
+// key | count key slots | body | tag, one slot per recipient
+#define ECC_MULTI_MAGIC    "SCM1"
+#define ECC_MAX_RECIPIENTS 4096
+#define ECC_KEY_ID_SIZE    8
+#define ECC_SLOT_SIZE      (ECC_KEY_ID_SIZE + FIELD_SIZE + 16)   // id | wrapped key | tag
+#define ECC_MULTI_HEADER_SIZE(n) (ECC_MAGIC_SIZE + 4 + FIELD_SIZE + (n) * ECC_SLOT_SIZE)
+
+// Key id of a public key: the first ECC_KEY_ID_SIZE bytes of its SHA-512
+// (used by the multi-recipient slots and the keyring index)
+void ecc_key_id(uint8_t *id, const uint8_t *public_key);
+
+// Session format: ECC_SESSION_MAGIC | session ephemeral public key |
+// u64 file index | body | tag, see ecc_session_begin
+#define ECC_SESSION_MAGIC        "SCS1"
+#define ECC_SESSION_HEADER_SIZE  (ECC_HEADER_SIZE + 8)
+#define ECC_SESSION_OVERHEAD     (ECC_SESSION_HEADER_SIZE + 16)
 
 // Encryption and decryption functions
 int ecc_encrypt(const uint8_t *public_key, const uint8_t *plaintext, 
@@ -26,6 +81,51 @@ int ecc_encrypt(const uint8_t *public_key, const uint8_t *plaintext,
 int ecc_decrypt(const uint8_t *private_key, const uint8_t *ciphertext,
                 size_t ciphertext_len, uint8_t **plaintext, size_t *plaintext_len);
 
+// ecc_decrypt refuses input without a known magic. This form takes such
+// input as the legacy format (ephemeral public key | body XORed with the
+// shared secret), which has no authentication: any bytes "decrypt", so it
+// is only for files known to predate the AEAD format.
+int ecc_decrypt_legacy(const uint8_t *private_key, const uint8_t *ciphertext,
+                       size_t ciphertext_len, uint8_t **plaintext, size_t *plaintext_len);
+
+// One ciphertext readable by each of n_recipients public keys: the body is
+// encrypted once under a random data key, which is wrapped per recipient
+// through the batch scalar multiplication. ecc_decrypt (and the batch
+// form) recognise the format and use the slot for their own key.
+int ecc_encrypt_multi(const uint8_t (*public_keys)[FIELD_SIZE], size_t n_recipients,
+                      const uint8_t *plaintext, size_t plaintext_len,
+                      uint8_t **ciphertext, size_t *ciphertext_len, int nthreads);
+
+// Sessions: many messages to one recipient for the cost of one key
+// agreement. ecc_session_begin does the ECDH with a fresh ephemeral key
+// and keeps only an HKDF session key; each ecc_session_encrypt derives
+// that message's AEAD key and nonce from the session key and the message
+// index, which is written next to the ephemeral key in its header. The
+// messages are ordinary inputs to ecc_decrypt, and ecc_decrypt_batch does
+// one shared secret per distinct ephemeral key. A session is not
+// thread-safe; ecc_session_end wipes it. Return 1 on success, 0 on failure.
+typedef struct {
+    uint8_t ephemeral_pub[FIELD_SIZE];
+    uint8_t session_key[FIELD_SIZE];
+    uint64_t next_index;
+} ecc_session_t;
+
+int ecc_session_begin(ecc_session_t *session, const uint8_t *public_key);
+int ecc_session_encrypt(ecc_session_t *session, const uint8_t *plaintext, size_t plaintext_len,
+                        uint8_t **ciphertext, size_t *ciphertext_len);
+void ecc_session_end(ecc_session_t *session);
+
+// Batch forms: n messages to / from a single key in one pass over the
+// batch scalar multiplication. Return 1 on success, 0 on failure.
+// ecc_encrypt uses the recipient's table if one is cached; ecc_encrypt_batch
+// also builds and caches it once n reaches ECC_TABLE_MIN_BATCH.
+int ecc_encrypt_batch(const uint8_t *public_key, size_t n,
+                      const uint8_t *const *plaintexts, const size_t *plaintext_lens,
+                      uint8_t **ciphertexts, size_t *ciphertext_lens, int nthreads);
+int ecc_decrypt_batch(const uint8_t *private_key, size_t n,
+                      const uint8_t *const *ciphertexts, const size_t *ciphertext_lens,
+                      uint8_t **plaintexts, size_t *plaintext_lens, int nthreads);
+
 // Key file handling functions
 int read_key(const char *filename, uint8_t *key, crypto_mode_t mode);
 void generate_and_save_keypair(const char *filename);
@@ -1,38 +1,363 @@
 #include "common.h"
-#include "curve25519.h"
+#include "sccrypto.h"
+#include "compress.h"
+#include "keyring.h"
+#include "ecc_stream.h"
+#include "keypool.h"
+#include "perfcnt.h"
+
+#define ECC_LIST_BATCH 256   // files handled per batch call
+#define ECC_LIST_POOL  (2 * ECC_LIST_BATCH)   // ephemeral pairs kept ready
+#define ECC_LIST_PATH  4096
+
+// --stats / --trace / SCCRYPTO_PERF stage report, printed at exit after
+// the kernels libsccrypto bound
+static perf_profile_t prof;
+static int pool_started;
+
+static void report_profile(void) {
+    if (prof.stats) {
+        sccrypto_report(stderr);
+        if (pool_started) {
+            keypool_stats_t st;
+            keypool_stats(&st);
+            fprintf(stderr, "keypool: %llu hits, %llu misses\n",
+                    (unsigned long long)st.hits, (unsigned long long)st.misses);
+        }
+    }
+    perf_profile_finish(&prof, stderr);
+}
+
+typedef struct {
+    char *in_fname;
+    char *out_fname;
+} list_entry_t;
+
+static char *copy_string(const char *s) {
+    size_t len = strlen(s) + 1;
+    char *d = malloc(len);
+    if (!d) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return memcpy(d, s, len);
+}
+
+// Reads the -l list: one "input output" pair per line; blank lines and
+// lines starting with '#' are skipped
+static list_entry_t *read_list(const char *fname, size_t *count) {
+    FILE *f = fopen(fname, "r");
+    if (!f) {
+        perror(fname);
+        exit(EXIT_FAILURE);
+    }
+    
+    size_t n = 0, cap = 64;
+    list_entry_t *v = malloc(cap * sizeof *v);
+    char line[2 * ECC_LIST_PATH + 16], in[ECC_LIST_PATH], out[ECC_LIST_PATH];
+    unsigned lineno = 0;
+    while (v && fgets(line, sizeof line, f)) {
+        ++lineno;
+        char first[2];
+        if (sscanf(line, "%1s", first) != 1 || first[0] == '#') continue;
+        if (sscanf(line, "%4095s %4095s", in, out) != 2) {
+            fprintf(stderr, "%s:%u: expected \"input output\"\n", fname, lineno);
+            exit(EXIT_FAILURE);
+        }
+        if (n == cap) {
+            cap *= 2;
+            v = realloc(v, cap * sizeof *v);
+            if (!v) break;
+        }
+        v[n].in_fname = copy_string(in);
+        v[n].out_fname = copy_string(out);
+        ++n;
+    }
+    if (!v) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    fclose(f);
+    *count = n;
+    return v;
+}
+
+// Public key by file name, or with -R by key id in the keyring, which is
+// mapped once however many keys are looked up
+static int load_public_key(const keyring_t *ring, const char *name, uint8_t *key) {
+    if (!ring) {
+        return read_key(name, key, MODE_ENCRYPT);
+    }
+    uint8_t id[ECC_KEY_ID_SIZE];
+    const keyring_entry_t *e = keyring_parse_id(id, name) ? keyring_find_id(ring, id) : NULL;
+    if (!e) {
+        fprintf(stderr, "%s: no such key id in the keyring\n", name);
+        return 0;
+    }
+    memcpy(key, e->public_key, FIELD_SIZE);
+    return 1;
+}
+
+// Session encryption of a batch: no key agreement per file
+static int session_encrypt_batch(ecc_session_t *session, size_t n,
+                                 const uint8_t *const *plaintexts, const size_t *plaintext_lens,
+                                 uint8_t **ciphertexts, size_t *ciphertext_lens) {
+    for (size_t i = 0; i < n; i++) {
+        if (!ecc_session_encrypt(session, plaintexts[i], plaintext_lens[i],
+                                 &ciphertexts[i], &ciphertext_lens[i])) {
+            while (i--) free(ciphertexts[i]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Batch mode: every file in the list is encrypted to (or decrypted with)
+// the one -k key, ECC_LIST_BATCH files per batch scalar multiplication.
+// With -S the whole list is encrypted in one session instead.
+static int run_list(const cli_args_t *args, const keyring_t *ring) {
+    uint8_t key[FIELD_SIZE];
+    int have_key = args->mode == MODE_ENCRYPT ? load_public_key(ring, args->key_fname, key)
+                                              : read_key(args->key_fname, key, args->mode);
+    if (!have_key) {
+        fprintf(stderr, "Failed to read valid %s key\n",
+                args->mode == MODE_ENCRYPT ? "public" : "private");
+        return EXIT_FAILURE;
+    }
+    ecc_session_t session;
+    if (args->session && !ecc_session_begin(&session, key)) {
+        fprintf(stderr, "Invalid public key\n");
+        return EXIT_FAILURE;
+    }
+    // The key pool generates the ephemeral pairs of the next batch while
+    // this one is read, sealed and written
+    if (args->mode == MODE_ENCRYPT && !args->session) {
+        pool_started = keypool_start(ECC_LIST_POOL, args->threads);
+    }
+    
+    size_t count;
+    list_entry_t *list = read_list(args->list_fname, &count);
+    uint8_t *in[ECC_LIST_BATCH], *out[ECC_LIST_BATCH];
+    size_t in_len[ECC_LIST_BATCH], out_len[ECC_LIST_BATCH];
+    
+    for (size_t first = 0; first < count; first += ECC_LIST_BATCH) {
+        size_t n = count - first < ECC_LIST_BATCH ? count - first : ECC_LIST_BATCH;
+        size_t batch_bytes = 0;
+        for (size_t i = 0; i < n; i++) {
+            perf_profile_begin(&prof, "read");
+            in[i] = read_file(list[first + i].in_fname, &in_len[i]);
+            perf_profile_end(&prof, in_len[i]);
+            if (args->mode == MODE_ENCRYPT &&
+                compress_needed(in[i], in_len[i], args->compress)) {
+                size_t packed_len;
+                perf_profile_begin(&prof, "compress");
+                uint8_t *packed = compress_chunks(in[i], in_len[i], &packed_len);
+                perf_profile_end(&prof, in_len[i]);
+                if (!packed) {
+                    fprintf(stderr, "%s: compression failed\n", list[first + i].in_fname);
+                    return EXIT_FAILURE;
+                }
+                free(in[i]);
+                in[i] = packed;
+                in_len[i] = packed_len;
+            }
+            batch_bytes += in_len[i];
+        }
+        
+        // The recipient table built by the first encryption batch stays in
+        // the cache, so later batches (even short ones) reuse it
+        perf_profile_begin(&prof, args->mode == MODE_ENCRYPT ? "encrypt" : "decrypt");
+        int ok = args->session
+               ? session_encrypt_batch(&session, n, (const uint8_t *const *)in, in_len, out, out_len)
+               : args->mode == MODE_ENCRYPT
+               ? ecc_encrypt_batch(key, n, (const uint8_t *const *)in, in_len, out, out_len, args->threads)
+               : ecc_decrypt_batch(key, n, (const uint8_t *const *)in, in_len, out, out_len, args->threads);
+        perf_profile_end(&prof, batch_bytes);
+        if (!ok) {
+            fprintf(stderr, "%s failed for the batch starting at %s\n",
+                    args->mode == MODE_ENCRYPT ? "Encryption" : "Decryption",
+                    list[first].in_fname);
+            return EXIT_FAILURE;
+        }
+        
+        for (size_t i = 0; i < n; i++) {
+            if (args->mode == MODE_DECRYPT && compress_is_container(out[i], out_len[i])) {
+                size_t unpacked_len;
+                perf_profile_begin(&prof, "decompress");
+                uint8_t *unpacked = decompress_chunks(out[i], out_len[i], &unpacked_len);
+                perf_profile_end(&prof, out_len[i]);
+                if (!unpacked) {
+                    fprintf(stderr, "%s: bad compressed stream (corrupt file?)\n",
+                            list[first + i].in_fname);
+                    return EXIT_FAILURE;
+                }
+                free(out[i]);
+                out[i] = unpacked;
+                out_len[i] = unpacked_len;
+            }
+            perf_profile_begin(&prof, "write");
+            write_file(list[first + i].out_fname, out[i], out_len[i]);
+            perf_profile_end(&prof, out_len[i]);
+            free(in[i]);
+            free(out[i]);
+        }
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        free(list[i].in_fname);
+        free(list[i].out_fname);
+    }
+    free(list);
+    if (args->session) {
+        ecc_session_end(&session);
+    }
+    keypool_stop();
+    curve25519_recipient_cache_clear();
+    memset(key, 0, sizeof key);
+    printf("%zu files %s successfully\n", count,
+           args->mode == MODE_ENCRYPT ? "encrypted" : "decrypted");
+    return EXIT_SUCCESS;
+}
+
+// -s and streamed decryption: the file goes through in chunks and is
+// never held in memory; a partial output is removed on failure
+static int run_stream(const cli_args_t *args, const uint8_t *key) {
+    FILE *in = fopen(args->in_fname, "rb");
+    if (!in) {
+        perror(args->in_fname);
+        return EXIT_FAILURE;
+    }
+    FILE *out = fopen(args->out_fname, "wb");
+    if (!out) {
+        perror(args->out_fname);
+        fclose(in);
+        return EXIT_FAILURE;
+    }
+    // One stage for the whole run; the trace shows its batch reads and
+    // writes and the chunks sealed or opened on each thread
+    perf_profile_begin(&prof, "stream");
+    int ok = args->mode == MODE_ENCRYPT ? ecc_stream_encrypt(in, out, key, args->threads)
+                                        : ecc_stream_decrypt(in, out, key, args->threads);
+    long pos = ftell(in);
+    perf_profile_end(&prof, pos > 0 ? (size_t)pos : 0);
+    fclose(in);
+    if (fclose(out) != 0) ok = 0;
+    if (!ok) {
+        fprintf(stderr, "%s failed\n", args->mode == MODE_ENCRYPT ? "Encryption" : "Decryption");
+        remove(args->out_fname);
+        return EXIT_FAILURE;
+    }
+    printf("File %s successfully\n", args->mode == MODE_ENCRYPT ? "encrypted" : "decrypted");
+    return EXIT_SUCCESS;
+}
+
+// Whether the input starts with the streaming magic
+static int input_is_stream(const char *fname) {
+    uint8_t magic[ECC_MAGIC_SIZE];
+    FILE *f = fopen(fname, "rb");
+    if (!f) {
+        return 0;   // read_file reports the error
+    }
+    int stream = fread(magic, 1, sizeof magic, f) == sizeof magic && ecc_is_stream(magic, sizeof magic);
+    fclose(f);
+    return stream;
+}
 
 int main(int argc, char **argv) {
     cli_args_t args = {0};
+    perf_profile_init(&prof, &argc, argv);
     parse_cli(argc, argv, &args);
+    atexit(report_profile);
+    
+    keyring_t *ring = NULL;
+    if (args.keyring_fname && !(ring = keyring_open(args.keyring_fname))) {
+        perror(args.keyring_fname);
+        return EXIT_FAILURE;
+    }
+    if (args.list_fname) {
+        int status = run_list(&args, ring);
+        keyring_close(ring);
+        return status;
+    }
     
     if (args.mode == MODE_ENCRYPT) {
         // Reading the public key for encryption
         uint8_t public_key[FIELD_SIZE];
-        if (!read_key(args.key_fname, public_key, MODE_ENCRYPT)) {
+        if (!load_public_key(ring, args.key_fname, public_key)) {
             fprintf(stderr, "Failed to read valid public key\n");
             return EXIT_FAILURE;
         }
+        if (args.stream) {
+            keyring_close(ring);
+            return run_stream(&args, public_key);
+        }
         
         // Reading the input file
         size_t plaintext_len;
+        perf_profile_begin(&prof, "read");
         uint8_t *plaintext = read_file(args.in_fname, &plaintext_len);
+        perf_profile_end(&prof, plaintext_len);
+        
+        // Optional LZ stage in front of the cipher
+        if (compress_needed(plaintext, plaintext_len, args.compress)) {
+            size_t packed_len;
+            perf_profile_begin(&prof, "compress");
+            uint8_t *packed = compress_chunks(plaintext, plaintext_len, &packed_len);
+            perf_profile_end(&prof, plaintext_len);
+            if (!packed) {
+                fprintf(stderr, "Compression failed\n");
+                free(plaintext);
+                return EXIT_FAILURE;
+            }
+            free(plaintext);
+            plaintext = packed;
+            plaintext_len = packed_len;
+        }
         
         // Encrypting the input
         uint8_t *ciphertext;
         size_t ciphertext_len;
         
-        if (!ecc_encrypt(public_key, plaintext, plaintext_len, &ciphertext, &ciphertext_len)) {
+        // With -r the file is encrypted once for -k and every -r key
+        int ok;
+        if (args.n_recipients) {
+            uint8_t (*keys)[FIELD_SIZE] = malloc((size_t)(args.n_recipients + 1) * FIELD_SIZE);
+            if (!keys) {
+                fprintf(stderr, "Memory allocation failed\n");
+                return EXIT_FAILURE;
+            }
+            memcpy(keys[0], public_key, FIELD_SIZE);
+            for (int i = 0; i < args.n_recipients; i++) {
+                if (!load_public_key(ring, args.recipients[i], keys[i + 1])) {
+                    fprintf(stderr, "Failed to read valid public key %s\n", args.recipients[i]);
+                    return EXIT_FAILURE;
+                }
+            }
+            perf_profile_begin(&prof, "encrypt");
+            ok = ecc_encrypt_multi((const uint8_t (*)[FIELD_SIZE])keys, (size_t)args.n_recipients + 1,
+                                   plaintext, plaintext_len, &ciphertext, &ciphertext_len, args.threads);
+            perf_profile_end(&prof, plaintext_len);
+            free(keys);
+        } else {
+            perf_profile_begin(&prof, "encrypt");
+            ok = ecc_encrypt(public_key, plaintext, plaintext_len, &ciphertext, &ciphertext_len);
+            perf_profile_end(&prof, plaintext_len);
+        }
+        if (!ok) {
             fprintf(stderr, "Encryption failed\n");
             free(plaintext);
             return EXIT_FAILURE;
         }
         
         // Writing the output file
+        perf_profile_begin(&prof, "write");
         write_file(args.out_fname, ciphertext, ciphertext_len);
+        perf_profile_end(&prof, ciphertext_len);
         
         // Cleanup
         free(plaintext);
         free(ciphertext);
+        keyring_close(ring);
         
         printf("File encrypted successfully\n");
     } else { // MODE_DECRYPT
@@ -42,23 +367,55 @@ int main(int argc, char **argv) {
             fprintf(stderr, "Failed to read valid private key\n");
             return EXIT_FAILURE;
         }
+        if (input_is_stream(args.in_fname)) {
+            int status = run_stream(&args, private_key);
+            memset(private_key, 0, sizeof private_key);
+            return status;
+        }
         
         // Reading the encrypted file
         size_t ciphertext_len;
+        perf_profile_begin(&prof, "read");
         uint8_t *ciphertext = read_file(args.in_fname, &ciphertext_len);
+        perf_profile_end(&prof, ciphertext_len);
         
         // Decrypting the input
         uint8_t *plaintext;
         size_t plaintext_len;
         
-        if (!ecc_decrypt(private_key, ciphertext, ciphertext_len, &plaintext, &plaintext_len)) {
+        perf_profile_begin(&prof, "decrypt");
+        int ok = args.legacy ? ecc_decrypt_legacy(private_key, ciphertext, ciphertext_len,
+                                                  &plaintext, &plaintext_len)
+                             : ecc_decrypt(private_key, ciphertext, ciphertext_len,
+                                           &plaintext, &plaintext_len);
+        perf_profile_end(&prof, ciphertext_len);
+        if (!ok) {
             fprintf(stderr, "Decryption failed\n");
             free(ciphertext);
             return EXIT_FAILURE;
         }
         
+        // Undoing the LZ stage if the file was encrypted with -z
+        if (compress_is_container(plaintext, plaintext_len)) {
+            size_t unpacked_len;
+            perf_profile_begin(&prof, "decompress");
+            uint8_t *unpacked = decompress_chunks(plaintext, plaintext_len, &unpacked_len);
+            perf_profile_end(&prof, plaintext_len);
+            if (!unpacked) {
+                fprintf(stderr, "Bad compressed stream (corrupt file?)\n");
+                free(ciphertext);
+                free(plaintext);
+                return EXIT_FAILURE;
+            }
+            free(plaintext);
+            plaintext = unpacked;
+            plaintext_len = unpacked_len;
+        }
+        
         // Writing the output file
+        perf_profile_begin(&prof, "write");
         write_file(args.out_fname, plaintext, plaintext_len);
+        perf_profile_end(&prof, plaintext_len);
         
         // Cleanup
         free(ciphertext);
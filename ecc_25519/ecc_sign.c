@@ -0,0 +1,237 @@
+#define _POSIX_C_SOURCE 200809L
+#include "common.h"
+#include "ed25519.h"
+#include "keyring.h"
+#include <dirent.h>
+#include <sys/stat.h>
+
+// Detached signatures: <file>.sig holds the signer's key id (as in
+// keyrings) followed by the Ed25519 signature over the file's bytes
+#define SIG_FILE_SIZE (ECC_KEY_ID_SIZE + ED25519_SIGNATURE_SIZE)
+#define SIG_SUFFIX    ".sig"
+#define DIR_BATCH     1024   // files read and verified at a time with -V
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s -g <name>                                 new key: <name>.sec, <name>.spk\n", prog);
+    fprintf(stderr, "       %s -s -k <name.sec> -i <file> [-o <sig>]     sign (default <file>.sig)\n", prog);
+    fprintf(stderr, "       %s -v (-k <key.spk>|-R <ring>) -i <file> [-o <sig>]   verify\n", prog);
+    fprintf(stderr, "       %s -V (-k <key.spk>|-R <ring>) -D <dir> [-t <threads>]\n", prog);
+    fprintf(stderr, "  -V batch-verifies every <file> in <dir> that has a <file>.sig; with -R the\n");
+    fprintf(stderr, "  signer is looked up in the keyring by the key id stored in the signature\n");
+    exit(EXIT_FAILURE);
+}
+
+static uint8_t *read_exact(const char *fname, size_t want) {
+    size_t len;
+    uint8_t *buf = read_file(fname, &len);
+    if (len != want) {
+        fprintf(stderr, "%s: expected %zu bytes, found %zu\n", fname, want, len);
+        exit(EXIT_FAILURE);
+    }
+    return buf;
+}
+
+static char *sig_name(const char *fname) {
+    char *s = malloc(strlen(fname) + sizeof SIG_SUFFIX);
+    if (!s) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return strcat(strcpy(s, fname), SIG_SUFFIX);
+}
+
+static int generate(const char *name) {
+    uint8_t seed[ED25519_SEED_SIZE], pk[ED25519_PUBLIC_KEY_SIZE];
+    char sec_name[256], spk_name[256];
+    snprintf(sec_name, sizeof sec_name, "%s.sec", name);
+    snprintf(spk_name, sizeof spk_name, "%s.spk", name);
+
+    curve25519_random_bytes(seed, sizeof seed);
+    ed25519_public_key(pk, seed);
+    write_file(sec_name, seed, sizeof seed);
+    write_file(spk_name, pk, sizeof pk);
+    memset(seed, 0, sizeof seed);
+    printf("Signing key written to: %s\n", sec_name);
+    printf("Verification key written to: %s\n", spk_name);
+    return EXIT_SUCCESS;
+}
+
+static int sign_file(const char *key_name, const char *fname, const char *out_name) {
+    uint8_t *seed = read_exact(key_name, ED25519_SEED_SIZE);
+    uint8_t pk[ED25519_PUBLIC_KEY_SIZE], sig[SIG_FILE_SIZE];
+    size_t len;
+    uint8_t *msg = read_file(fname, &len);
+
+    ed25519_public_key(pk, seed);
+    ecc_key_id(sig, pk);
+    ed25519_sign(sig + ECC_KEY_ID_SIZE, msg, len, seed, pk);
+    memset(seed, 0, ED25519_SEED_SIZE);
+    free(seed);
+    free(msg);
+
+    char *sig_fname = out_name ? NULL : sig_name(fname);
+    write_file(out_name ? out_name : sig_fname, sig, sizeof sig);
+    printf("Signature written to: %s\n", out_name ? out_name : sig_fname);
+    free(sig_fname);
+    return EXIT_SUCCESS;
+}
+
+// Verification key for a signature: -k directly, or the keyring entry
+// named by the signature's key id. NULL if the signer is unknown.
+static const uint8_t *signer_key(const uint8_t *sig, const uint8_t *key, const keyring_t *ring,
+                                 const char **label) {
+    *label = NULL;
+    if (!ring) return key;
+    const keyring_entry_t *e = keyring_find_id(ring, sig);
+    if (!e) return NULL;
+    *label = e->label;
+    return e->public_key;
+}
+
+static int verify_file(const uint8_t *key, const keyring_t *ring, const char *fname,
+                       const char *sig_fname) {
+    char *own = sig_fname ? NULL : sig_name(fname);
+    uint8_t *sig = read_exact(sig_fname ? sig_fname : own, SIG_FILE_SIZE);
+    size_t len;
+    uint8_t *msg = read_file(fname, &len);
+    const char *label;
+    const uint8_t *pk = signer_key(sig, key, ring, &label);
+
+    int ok = pk && ed25519_verify(sig + ECC_KEY_ID_SIZE, msg, len, pk);
+    if (ok && label) printf("%s: good signature by %.*s\n", fname, KEYRING_LABEL_SIZE, label);
+    else if (ok) printf("%s: good signature\n", fname);
+    else if (!pk) fprintf(stderr, "%s: signer not in keyring\n", fname);
+    else fprintf(stderr, "%s: BAD signature\n", fname);
+    free(own);
+    free(sig);
+    free(msg);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Verifies one group of files with ed25519_verify_batch; returns the
+// number of failures
+static size_t verify_group(const uint8_t *key, const keyring_t *ring, char **names, size_t n,
+                           int threads) {
+    uint8_t **sigs = malloc(n * sizeof *sigs), **msgs = malloc(n * sizeof *msgs);
+    const uint8_t **pks = malloc(n * sizeof *pks), **sig_bytes = malloc(n * sizeof *sig_bytes);
+    size_t *lens = malloc(n * sizeof *lens), failed = 0;
+    int *valid = malloc(n * sizeof *valid);
+    if (!sigs || !msgs || !pks || !sig_bytes || !lens || !valid) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // A malformed .sig or an unknown signer gets an all-zero key and
+    // signature, which never verifies, so the batch stays aligned with names
+    static const uint8_t no_key[ED25519_PUBLIC_KEY_SIZE] = {0};
+    for (size_t i = 0; i < n; i++) {
+        char *sig_fname = sig_name(names[i]);
+        size_t sig_len;
+        const char *label;
+        sigs[i] = read_file(sig_fname, &sig_len);
+        msgs[i] = read_file(names[i], &lens[i]);
+        free(sig_fname);
+        pks[i] = sig_len == SIG_FILE_SIZE ? signer_key(sigs[i], key, ring, &label) : NULL;
+        sig_bytes[i] = sig_len == SIG_FILE_SIZE ? sigs[i] + ECC_KEY_ID_SIZE : no_key;
+        if (!pks[i]) pks[i] = no_key;
+    }
+    ed25519_verify_batch(sig_bytes, (const uint8_t *const *)msgs, lens, pks, n, valid, threads);
+    for (size_t i = 0; i < n; i++) {
+        if (!valid[i]) {
+            fprintf(stderr, "%s: BAD signature\n", names[i]);
+            failed++;
+        }
+        free(sigs[i]);
+        free(msgs[i]);
+    }
+    free(sigs);
+    free(msgs);
+    free(pks);
+    free(sig_bytes);
+    free(lens);
+    free(valid);
+    return failed;
+}
+
+static int is_regular(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+static int verify_dir(const uint8_t *key, const keyring_t *ring, const char *dir, int threads) {
+    DIR *d = opendir(dir);
+    if (!d) {
+        perror(dir);
+        return EXIT_FAILURE;
+    }
+    char *names[DIR_BATCH];
+    size_t n = 0, total = 0, failed = 0, slen = strlen(SIG_SUFFIX);
+    struct dirent *ent;
+    for (;;) {
+        ent = readdir(d);
+        if (ent) {
+            size_t len = strlen(ent->d_name);
+            if (len <= slen || strcmp(ent->d_name + len - slen, SIG_SUFFIX) != 0) continue;
+            char *path = malloc(strlen(dir) + len + 2);
+            if (!path) {
+                fprintf(stderr, "Memory allocation failed\n");
+                return EXIT_FAILURE;
+            }
+            sprintf(path, "%s/%.*s", dir, (int)(len - slen), ent->d_name);
+            if (!is_regular(path)) {
+                fprintf(stderr, "%s: signature without a file\n", path);
+                failed++;
+                total++;
+                free(path);
+                continue;
+            }
+            names[n++] = path;
+        }
+        if (n == DIR_BATCH || (!ent && n)) {
+            failed += verify_group(key, ring, names, n, threads);
+            total += n;
+            while (n) free(names[--n]);
+        }
+        if (!ent) break;
+    }
+    closedir(d);
+    printf("%zu signatures checked, %zu good, %zu bad\n", total, total - failed, failed);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+    const char *key_name = NULL, *ring_name = NULL, *in = NULL, *out = NULL, *dir = NULL, *gen = NULL;
+    int threads = 0;
+    char op = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-g") && i + 1 < argc) { op = 'g'; gen = argv[++i]; }
+        else if (!strcmp(argv[i], "-s")) op = 's';
+        else if (!strcmp(argv[i], "-v")) op = 'v';
+        else if (!strcmp(argv[i], "-V")) op = 'V';
+        else if (!strcmp(argv[i], "-k") && i + 1 < argc) key_name = argv[++i];
+        else if (!strcmp(argv[i], "-R") && i + 1 < argc) ring_name = argv[++i];
+        else if (!strcmp(argv[i], "-i") && i + 1 < argc) in = argv[++i];
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) out = argv[++i];
+        else if (!strcmp(argv[i], "-D") && i + 1 < argc) dir = argv[++i];
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) threads = atoi(argv[++i]);
+        else usage(argv[0]);
+    }
+
+    if (op == 'g') return generate(gen);
+    if (op == 's' && key_name && in) return sign_file(key_name, in, out);
+    if ((op != 'v' || !in) && (op != 'V' || !dir)) usage(argv[0]);
+    if (!key_name == !ring_name) usage(argv[0]);
+
+    keyring_t *ring = NULL;
+    uint8_t *key = NULL;
+    if (ring_name && !(ring = keyring_open(ring_name))) {
+        perror(ring_name);
+        return EXIT_FAILURE;
+    }
+    if (key_name) key = read_exact(key_name, ED25519_PUBLIC_KEY_SIZE);
+    int status = op == 'v' ? verify_file(key, ring, in, out) : verify_dir(key, ring, dir, threads);
+    keyring_close(ring);
+    free(key);
+    return status;
+}
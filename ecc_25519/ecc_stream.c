@@ -0,0 +1,212 @@
+#define _POSIX_C_SOURCE 200809L
+#include "ecc_stream.h"
+#include "keypool.h"
+#include "sha512.h"
+#include "chacha20poly1305.h"
+#include "perfcnt.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define STREAM_MAX_THREADS 64
+
+static const uint8_t stream_info[] = "sccrypto ecc stream";
+
+typedef struct {
+    const uint8_t *key, *base_nonce, *header;
+    const uint8_t *in;
+    uint8_t *out;
+    size_t chunk;         // plaintext bytes of a full chunk
+    uint64_t first;       // stream index of the batch's first chunk
+    size_t n, last_len;   // chunks in the batch; length of the last if final
+    int final, decrypt, failed;
+    size_t next;
+    pthread_mutex_t lock;
+} stream_job_t;
+
+// AEAD key and base nonce from the shared secret, as for single messages
+static int stream_derive(uint8_t *key_nonce, const uint8_t *shared, const uint8_t *ephemeral_pub,
+                         const uint8_t *recipient_pub) {
+    uint8_t salt[2 * FIELD_SIZE], acc = 0;
+    for (int i = 0; i < FIELD_SIZE; i++) acc |= shared[i];
+    if (acc == 0) return 0;
+    memcpy(salt, ephemeral_pub, FIELD_SIZE);
+    memcpy(salt + FIELD_SIZE, recipient_pub, FIELD_SIZE);
+    hkdf_sha512(key_nonce, AEAD_KEY_SIZE + AEAD_NONCE_SIZE, salt, sizeof salt,
+                shared, FIELD_SIZE, stream_info, sizeof stream_info - 1);
+    return 1;
+}
+
+static void chunk_nonce(uint8_t *nonce, const uint8_t *base, uint64_t index, int final) {
+    memcpy(nonce, base, AEAD_NONCE_SIZE);
+    for (int i = 0; i < 8; i++) nonce[i] ^= (uint8_t)(index >> (8 * i));
+    if (final) nonce[AEAD_NONCE_SIZE - 1] ^= 1;
+}
+
+static void *stream_worker(void *arg) {
+    stream_job_t *job = arg;
+    size_t rec = job->chunk + AEAD_TAG_SIZE;
+    int trace = perf_trace_enabled();
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        size_t i = job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if (i >= job->n) return NULL;
+
+        int final = job->final && i == job->n - 1;
+        size_t len = final ? job->last_len : job->chunk;
+        uint8_t nonce[AEAD_NONCE_SIZE];
+        double t0 = trace ? perf_now_ns() : 0;
+        chunk_nonce(nonce, job->base_nonce, job->first + i, final);
+        if (!job->decrypt) {
+            uint8_t *ct = job->out + i * rec;
+            aead_encrypt(ct, ct + len, job->in + i * job->chunk, len,
+                         job->header, ECC_STREAM_HEADER_SIZE, nonce, job->key);
+        } else {
+            const uint8_t *ct = job->in + i * rec;
+            if (aead_decrypt(job->out + i * job->chunk, ct, len, ct + len,
+                             job->header, ECC_STREAM_HEADER_SIZE, nonce, job->key) != 0) {
+                pthread_mutex_lock(&job->lock);
+                job->failed = 1;
+                pthread_mutex_unlock(&job->lock);
+            }
+        }
+        if (trace) perf_trace_span(job->decrypt ? "open" : "seal", t0, perf_now_ns(), len);
+    }
+}
+
+static void stream_run(stream_job_t *job, int nthreads) {
+    if (nthreads <= 0) {
+        nthreads = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+        nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    }
+    if (nthreads > STREAM_MAX_THREADS) nthreads = STREAM_MAX_THREADS;
+    if ((size_t)nthreads > job->n) nthreads = (int)job->n;
+
+    pthread_t tid[STREAM_MAX_THREADS];
+    int started = 0;
+    job->next = 0;
+    for (; started < nthreads - 1; ++started)
+        if (pthread_create(&tid[started], NULL, stream_worker, job) != 0) break;
+    stream_worker(job);                        // the caller works too
+    for (int t = 0; t < started; ++t) pthread_join(tid[t], NULL);
+}
+
+int ecc_is_stream(const uint8_t *data, size_t len) {
+    return len >= ECC_MAGIC_SIZE && memcmp(data, ECC_STREAM_MAGIC, ECC_MAGIC_SIZE) == 0;
+}
+
+int ecc_stream_encrypt(FILE *in, FILE *out, const uint8_t *public_key, int nthreads) {
+    uint8_t header[ECC_STREAM_HEADER_SIZE], kn[AEAD_KEY_SIZE + AEAD_NONCE_SIZE];
+    uint8_t shared_secret[FIELD_SIZE];
+    key_pair_t ephemeral;
+
+    keypool_take(&ephemeral);
+    curve25519_shared_secret(shared_secret, ephemeral.private_key, public_key);
+    int ok = stream_derive(kn, shared_secret, ephemeral.public_key, public_key);
+    memcpy(header, ECC_STREAM_MAGIC, ECC_MAGIC_SIZE);
+    memcpy(header + ECC_MAGIC_SIZE, ephemeral.public_key, FIELD_SIZE);
+    for (int i = 0; i < 4; i++) header[ECC_HEADER_SIZE + i] = (uint8_t)(ECC_STREAM_CHUNK >> (8 * i));
+    memset(&ephemeral, 0, sizeof ephemeral);
+    memset(shared_secret, 0, sizeof shared_secret);
+
+    size_t batch = (size_t)ECC_STREAM_BATCH * ECC_STREAM_CHUNK;
+    uint8_t *in_buf = malloc(batch);
+    uint8_t *out_buf = malloc(batch + ECC_STREAM_BATCH * AEAD_TAG_SIZE);
+    stream_job_t job = { .key = kn, .base_nonce = kn + AEAD_KEY_SIZE, .header = header,
+                         .in = in_buf, .out = out_buf, .chunk = ECC_STREAM_CHUNK };
+    pthread_mutex_init(&job.lock, NULL);
+    ok = ok && in_buf && out_buf && fwrite(header, 1, sizeof header, out) == sizeof header;
+
+    int trace = perf_trace_enabled();
+    // A short read ends the stream; when the input is a whole number of
+    // batches, the last read is empty and yields just the empty final chunk
+    while (ok && !job.final) {
+        double t0 = trace ? perf_now_ns() : 0;
+        size_t got = fread(in_buf, 1, batch, in);
+        if (ferror(in)) {
+            ok = 0;
+            break;
+        }
+        if (trace) perf_trace_span("read", t0, perf_now_ns(), got);
+        job.final = got < batch;
+        job.n = got / ECC_STREAM_CHUNK + (size_t)job.final;
+        job.last_len = got % ECC_STREAM_CHUNK;
+        stream_run(&job, nthreads);
+        size_t produced = got + job.n * AEAD_TAG_SIZE;
+        t0 = trace ? perf_now_ns() : 0;
+        ok = fwrite(out_buf, 1, produced, out) == produced;
+        if (trace) perf_trace_span("write", t0, perf_now_ns(), produced);
+        job.first += job.n;
+    }
+
+    pthread_mutex_destroy(&job.lock);
+    memset(kn, 0, sizeof kn);
+    if (in_buf) memset(in_buf, 0, batch);
+    free(in_buf);
+    free(out_buf);
+    return ok;
+}
+
+int ecc_stream_decrypt(FILE *in, FILE *out, const uint8_t *private_key, int nthreads) {
+    uint8_t header[ECC_STREAM_HEADER_SIZE], kn[AEAD_KEY_SIZE + AEAD_NONCE_SIZE];
+    uint8_t shared_secret[FIELD_SIZE], public_key[FIELD_SIZE];
+
+    if (fread(header, 1, sizeof header, in) != sizeof header ||
+        !ecc_is_stream(header, sizeof header)) {
+        return 0;
+    }
+    uint32_t chunk = 0;
+    for (int i = 3; i >= 0; i--) chunk = (chunk << 8) | header[ECC_HEADER_SIZE + i];
+    if (chunk == 0 || chunk > ECC_STREAM_MAX_CHUNK) {
+        return 0;
+    }
+    curve25519_shared_secret(shared_secret, private_key, header + ECC_MAGIC_SIZE);
+    curve25519_compute_public(public_key, private_key);
+    int ok = stream_derive(kn, shared_secret, header + ECC_MAGIC_SIZE, public_key);
+    memset(shared_secret, 0, sizeof shared_secret);
+
+    size_t rec = (size_t)chunk + AEAD_TAG_SIZE, batch = ECC_STREAM_BATCH * rec;
+    uint8_t *in_buf = malloc(batch);
+    uint8_t *out_buf = malloc((size_t)ECC_STREAM_BATCH * chunk);
+    stream_job_t job = { .key = kn, .base_nonce = kn + AEAD_KEY_SIZE, .header = header,
+                         .in = in_buf, .out = out_buf, .chunk = chunk, .decrypt = 1 };
+    pthread_mutex_init(&job.lock, NULL);
+    ok = ok && in_buf && out_buf;
+
+    int trace = perf_trace_enabled();
+    // Only the final chunk is short, so a stream that stops at a full
+    // chunk has lost its end
+    while (ok && !job.final) {
+        double t0 = trace ? perf_now_ns() : 0;
+        size_t got = fread(in_buf, 1, batch, in);
+        if (ferror(in)) {
+            ok = 0;
+            break;
+        }
+        if (trace) perf_trace_span("read", t0, perf_now_ns(), got);
+        job.final = got < batch;
+        job.n = got / rec + (size_t)job.final;
+        if (job.final && got % rec < AEAD_TAG_SIZE) {
+            ok = 0;
+            break;
+        }
+        job.last_len = got % rec - (job.final ? AEAD_TAG_SIZE : 0);
+        stream_run(&job, nthreads);
+        size_t produced = got - job.n * AEAD_TAG_SIZE;
+        t0 = trace ? perf_now_ns() : 0;
+        ok = !job.failed && fwrite(out_buf, 1, produced, out) == produced;
+        if (trace) perf_trace_span("write", t0, perf_now_ns(), produced);
+        job.first += job.n;
+    }
+
+    pthread_mutex_destroy(&job.lock);
+    memset(kn, 0, sizeof kn);
+    if (out_buf) memset(out_buf, 0, (size_t)ECC_STREAM_BATCH * chunk);
+    free(in_buf);
+    free(out_buf);
+    return ok;
+}
@@ -0,0 +1,34 @@
+#ifndef ECC_STREAM_H
+#define ECC_STREAM_H
+
+#include "curve25519.h"
+#include <stdio.h>
+
+// Streaming hybrid encryption for files of any size in bounded memory:
+//   "SCC1" | ephemeral public key | u32 chunk size | chunks
+// Every chunk but the last holds exactly chunk size bytes of plaintext as
+// ciphertext | tag; the last one is shorter (possibly empty), so a stream
+// always ends in a short chunk. Chunk i is sealed with ChaCha20-Poly1305
+// under one HKDF key; its nonce is the HKDF base nonce with i xored into
+// the first eight bytes and, for the last chunk, a final flag into the
+// twelfth, so chunks cannot be reordered, dropped or cut off at a chunk
+// boundary. The header is every chunk's associated data.
+//
+// Chunks are read ECC_STREAM_BATCH at a time and sealed or opened in
+// parallel over nthreads threads (<= 0: one per CPU); memory use is about
+// two batches whatever the file size.
+#define ECC_STREAM_MAGIC       "SCC1"
+#define ECC_STREAM_HEADER_SIZE (ECC_MAGIC_SIZE + FIELD_SIZE + 4)
+#define ECC_STREAM_CHUNK       (64 * 1024)    // plaintext bytes per chunk
+#define ECC_STREAM_MAX_CHUNK   (16u << 20)    // largest accepted on decrypt
+#define ECC_STREAM_BATCH       64             // chunks per read
+
+// Return 1 on success, 0 on failure. On a decryption failure, out already
+// holds the chunks that verified before it, and the caller should discard it.
+int ecc_stream_encrypt(FILE *in, FILE *out, const uint8_t *public_key, int nthreads);
+int ecc_stream_decrypt(FILE *in, FILE *out, const uint8_t *private_key, int nthreads);
+
+// 1 if the buffer starts with the stream magic
+int ecc_is_stream(const uint8_t *data, size_t len);
+
+#endif /* ECC_STREAM_H */
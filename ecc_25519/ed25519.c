@@ -0,0 +1,385 @@
+#define _POSIX_C_SOURCE 200809L
+#include "ed25519.h"
+#include "ge25519.h"
+#include "sha512.h"
+#include "curve25519.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define ED25519_MAX_THREADS 64
+
+// ---------- scalars mod L ---------------------------------------------------
+// L = 2^252 + 27742317777372353535851937790883648493, little-endian bytes
+static const int64_t L[32] = {
+    0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x10
+};
+
+// r = x mod L, where x is 64 radix-2^8 digits that may exceed a byte (sums
+// of products). The top digits are folded down using 2^252 = -(L - 2^252).
+static void sc_modl(uint8_t *r, int64_t x[64]) {
+    int64_t carry;
+    int i, j;
+    for (i = 63; i >= 32; i--) {
+        carry = 0;
+        for (j = i - 32; j < i - 12; j++) {
+            x[j] += carry - 16 * x[i] * L[j - (i - 32)];
+            carry = (x[j] + 128) >> 8;
+            x[j] -= carry * 256;
+        }
+        x[j] += carry;
+        x[i] = 0;
+    }
+    carry = 0;
+    for (j = 0; j < 32; j++) {
+        x[j] += carry - (x[31] >> 4) * L[j];
+        carry = x[j] >> 8;
+        x[j] &= 255;
+    }
+    for (j = 0; j < 32; j++) x[j] -= carry * L[j];
+    for (i = 0; i < 32; i++) {
+        x[i + 1] += x[i] >> 8;
+        r[i] = (uint8_t)(x[i] & 255);
+    }
+}
+
+// r = h mod L for a 64-byte hash
+static void sc_reduce(uint8_t *r, const uint8_t *h) {
+    int64_t x[64];
+    for (int i = 0; i < 64; i++) x[i] = h[i];
+    sc_modl(r, x);
+}
+
+// r = a * b + c mod L; r may alias c
+static void sc_muladd(uint8_t *r, const uint8_t *a, const uint8_t *b, const uint8_t *c) {
+    int64_t x[64] = {0};
+    for (int i = 0; i < 32; i++) x[i] = c[i];
+    for (int i = 0; i < 32; i++) {
+        for (int j = 0; j < 32; j++) x[i + j] += (int64_t)a[i] * b[j];
+    }
+    sc_modl(r, x);
+}
+
+// S < L, which rules out the malleable S + L forms of a signature
+static int sc_is_canonical(const uint8_t *s) {
+    for (int i = 31; i >= 0; i--) {
+        if (s[i] != L[i]) return s[i] < L[i];
+    }
+    return 0;
+}
+
+// ---------- points ------------------------------------------------------------
+static ge_p3 minus_base;                 // -B, for the verification equation
+static pthread_once_t minus_base_once = PTHREAD_ONCE_INIT;
+
+static void minus_base_init(void) {
+    static const uint8_t one[32] = {1};
+    ge_scalarmult_base(&minus_base, one);
+    field_negate(minus_base.X, minus_base.X);
+    field_negate(minus_base.T, minus_base.T);
+}
+
+// ge_frombytes, additionally rejecting y >= p so each point has exactly
+// one accepted encoding
+static int point_decode(ge_p3 *p, const uint8_t *s) {
+    int high = (s[31] & 0x7f) == 0x7f && s[0] >= 0xed;
+    for (int i = 1; i < 31 && high; i++) high = s[i] == 0xff;
+    return !high && ge_frombytes(p, s) == 0;
+}
+
+// Width-5 signed sliding window recoding: r[i] is 0 or odd in [-15, 15],
+// a = sum r[i] 2^i, for a < 2^255
+static void slide(int8_t *r, const uint8_t *a) {
+    for (int i = 0; i < 256; i++) r[i] = (int8_t)(1 & (a[i >> 3] >> (i & 7)));
+    for (int i = 0; i < 256; i++) {
+        if (!r[i]) continue;
+        for (int b = 1; b <= 6 && i + b < 256; b++) {
+            if (!r[i + b]) continue;
+            if (r[i] + (r[i + b] << b) <= 15) {
+                r[i] = (int8_t)(r[i] + (r[i + b] << b));
+                r[i + b] = 0;
+            } else if (r[i] - (r[i + b] << b) >= -15) {
+                r[i] = (int8_t)(r[i] - (r[i + b] << b));
+                for (int k = i + b; k < 256; k++) {
+                    if (!r[k]) {
+                        r[k] = 1;
+                        break;
+                    }
+                    r[k] = 0;
+                }
+            } else {
+                break;
+            }
+        }
+    }
+}
+
+// One term of a multi-scalar multiplication: the scalar's digits and the
+// odd multiples P, 3P, ..., 15P they select
+typedef struct {
+    ge_cached odd[8];
+    int8_t naf[256];
+} msm_term_t;
+
+static void msm_term(msm_term_t *t, const ge_p3 *p, const uint8_t *scalar) {
+    ge_p1p1 s;
+    ge_p3 p2, u;
+    slide(t->naf, scalar);
+    ge_p3_to_cached(&t->odd[0], p);
+    ge_p3_dbl(&s, p);
+    ge_p1p1_to_p3(&p2, &s);
+    for (int i = 1; i < 8; i++) {
+        ge_add(&s, &p2, &t->odd[i - 1]);
+        ge_p1p1_to_p3(&u, &s);
+        ge_p3_to_cached(&t->odd[i], &u);
+    }
+}
+
+// h = sum of the terms' scalar multiples (Straus): one shared chain of
+// doublings, and an addition wherever a term has a nonzero digit
+static void msm_vartime(ge_p3 *h, const msm_term_t *terms, size_t n) {
+    int top = 255;
+    while (top >= 0) {
+        size_t j = 0;
+        while (j < n && !terms[j].naf[top]) j++;
+        if (j < n) break;
+        top--;
+    }
+
+    ge_p2 r;
+    ge_p1p1 t;
+    ge_p3 u;
+    memset(&r, 0, sizeof r);
+    r.Y[0] = r.Z[0] = 1;
+    ge_p3_0(h);
+    for (int i = top; i >= 0; i--) {
+        ge_p2_dbl(&t, &r);
+        for (size_t j = 0; j < n; j++) {
+            int8_t d = terms[j].naf[i];
+            if (d > 0) {
+                ge_p1p1_to_p3(&u, &t);
+                ge_add(&t, &u, &terms[j].odd[d / 2]);
+            } else if (d < 0) {
+                ge_p1p1_to_p3(&u, &t);
+                ge_sub(&t, &u, &terms[j].odd[-d / 2]);
+            }
+        }
+        if (i == 0) ge_p1p1_to_p3(h, &t);
+        else ge_p1p1_to_p2(&r, &t);
+    }
+}
+
+// [8] h is the identity
+static int is_small_order(const ge_p3 *h) {
+    ge_p1p1 t;
+    ge_p2 r;
+    gf d;
+    ge_p3_to_p2(&r, h);
+    for (int i = 0; i < 3; i++) {
+        ge_p2_dbl(&t, &r);
+        ge_p1p1_to_p2(&r, &t);
+    }
+    field_subtract(d, r.Y, r.Z);
+    return field_is_zero(r.X) && field_is_zero(d);
+}
+
+// ---------- signing -----------------------------------------------------------
+static void expand_seed(uint8_t *h, const uint8_t *seed) {
+    sha512(h, seed, ED25519_SEED_SIZE);
+    h[0] &= 248;
+    h[31] &= 127;
+    h[31] |= 64;
+}
+
+void ed25519_public_key(uint8_t *public_key, const uint8_t *seed) {
+    uint8_t h[SHA512_DIGEST_SIZE];
+    ge_p3 A;
+    expand_seed(h, seed);
+    ge_scalarmult_base(&A, h);
+    ge_p3_tobytes(public_key, &A);
+    memset(h, 0, sizeof h);
+}
+
+void ed25519_sign(uint8_t *signature, const uint8_t *message, size_t len,
+                  const uint8_t *seed, const uint8_t *public_key) {
+    uint8_t h[SHA512_DIGEST_SIZE], d[SHA512_DIGEST_SIZE], r[32], k[32];
+    sha512_ctx_t ctx;
+    ge_p3 R;
+
+    expand_seed(h, seed);
+    sha512_init(&ctx);
+    sha512_update(&ctx, h + 32, 32);
+    sha512_update(&ctx, message, len);
+    sha512_final(&ctx, d);
+    sc_reduce(r, d);
+    ge_scalarmult_base(&R, r);
+    ge_p3_tobytes(signature, &R);
+
+    sha512_init(&ctx);
+    sha512_update(&ctx, signature, 32);
+    sha512_update(&ctx, public_key, ED25519_PUBLIC_KEY_SIZE);
+    sha512_update(&ctx, message, len);
+    sha512_final(&ctx, d);
+    sc_reduce(k, d);
+    sc_muladd(signature + 32, k, h, r);       // S = k a + r
+
+    memset(h, 0, sizeof h);
+    memset(d, 0, sizeof d);
+    memset(r, 0, sizeof r);
+    memset(&ctx, 0, sizeof ctx);
+}
+
+// ---------- verification ------------------------------------------------------
+// A signature with its points decoded and k = SHA-512(R || A || M) mod L
+typedef struct {
+    ge_p3 A, R;
+    uint8_t k[32];
+    const uint8_t *S, *public_key;
+} prepared_t;
+
+// Decoding a point costs a square root, so a public key already decoded
+// for one of the known entries is copied from there
+static int prepare(prepared_t *e, const uint8_t *signature, const uint8_t *message, size_t len,
+                   const uint8_t *public_key, const prepared_t *known, size_t n_known) {
+    uint8_t d[SHA512_DIGEST_SIZE];
+    sha512_ctx_t ctx;
+    size_t j = 0;
+    while (j < n_known && memcmp(known[j].public_key, public_key, ED25519_PUBLIC_KEY_SIZE) != 0) j++;
+    if (j < n_known) {
+        e->A = known[j].A;
+    } else if (!point_decode(&e->A, public_key)) {
+        return 0;
+    }
+    if (!sc_is_canonical(signature + 32) || !point_decode(&e->R, signature)) {
+        return 0;
+    }
+    sha512_init(&ctx);
+    sha512_update(&ctx, signature, 32);
+    sha512_update(&ctx, public_key, ED25519_PUBLIC_KEY_SIZE);
+    sha512_update(&ctx, message, len);
+    sha512_final(&ctx, d);
+    sc_reduce(e->k, d);
+    e->S = signature + 32;
+    e->public_key = public_key;
+    return 1;
+}
+
+// Checks [8]((sum z_i S_i) B - sum z_i R_i - sum (z_i k_i) A_i) = 0, with
+// z = 1 for a single signature and random 128-bit weights otherwise.
+// Signatures by the same key share one A term with the summed scalar, so
+// a batch from one signer is little more than its R terms. terms has
+// room for 2 n + 1 entries.
+static int verify_prepared(const prepared_t *e, size_t n, msm_term_t *terms) {
+    uint8_t ssum[32] = {0}, zk[ED25519_BATCH][32], weights[ED25519_BATCH][16];
+    static const uint8_t zero[32] = {0};
+    size_t key_of[ED25519_BATCH], nterms = 0;
+    ge_p3 h;
+
+    pthread_once(&minus_base_once, minus_base_init);
+    if (n > 1) curve25519_random_bytes(&weights[0][0], n * 16);
+    for (size_t i = 0; i < n; i++) {
+        uint8_t z[32] = {1};
+        if (n > 1) memcpy(z, weights[i], 16);
+        sc_muladd(ssum, z, e[i].S, ssum);
+        size_t j = 0;
+        while (j < i && memcmp(e[j].public_key, e[i].public_key, ED25519_PUBLIC_KEY_SIZE) != 0) j++;
+        key_of[i] = key_of[j];
+        if (j == i) key_of[i] = i;
+        sc_muladd(zk[key_of[i]], z, e[i].k, j == i ? zero : zk[key_of[i]]);
+        msm_term(&terms[nterms++], &e[i].R, z);
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (key_of[i] == i) msm_term(&terms[nterms++], &e[i].A, zk[i]);
+    }
+    msm_term(&terms[nterms++], &minus_base, ssum);
+    msm_vartime(&h, terms, nterms);
+    return is_small_order(&h);
+}
+
+int ed25519_verify(const uint8_t *signature, const uint8_t *message, size_t len,
+                   const uint8_t *public_key) {
+    prepared_t e;
+    msm_term_t terms[3];
+    return prepare(&e, signature, message, len, public_key, NULL, 0) && verify_prepared(&e, 1, terms);
+}
+
+// Batch verification, ED25519_BATCH signatures per work item
+typedef struct {
+    const uint8_t *const *signatures;
+    const uint8_t *const *messages;
+    const size_t *lens;
+    const uint8_t *const *public_keys;
+    int *valid;
+    size_t n, next;
+    int failed;
+    pthread_mutex_t lock;
+} verify_job_t;
+
+static void verify_chunk(verify_job_t *job, size_t lo, size_t hi, prepared_t *e, msm_term_t *terms) {
+    size_t idx[ED25519_BATCH], m = 0;
+    for (size_t i = lo; i < hi; i++) {
+        job->valid[i] = prepare(&e[m], job->signatures[i], job->messages[i], job->lens[i],
+                                job->public_keys[i], e, m);
+        if (job->valid[i]) idx[m++] = i;
+    }
+    if (m == 0 || verify_prepared(e, m, terms)) return;
+    // the combined check failed: find the culprits one by one
+    for (size_t j = 0; j < m; j++) {
+        job->valid[idx[j]] = verify_prepared(&e[j], 1, terms);
+    }
+}
+
+static void *verify_worker(void *arg) {
+    verify_job_t *job = arg;
+    prepared_t *e = malloc(ED25519_BATCH * sizeof *e);
+    msm_term_t *terms = malloc((2 * ED25519_BATCH + 1) * sizeof *terms);
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        size_t lo = job->next;
+        job->next += ED25519_BATCH;
+        if (!e || !terms) job->failed = 1;
+        pthread_mutex_unlock(&job->lock);
+        if (lo >= job->n || !e || !terms) break;
+        verify_chunk(job, lo, lo + ED25519_BATCH < job->n ? lo + ED25519_BATCH : job->n, e, terms);
+    }
+    free(e);
+    free(terms);
+    return NULL;
+}
+
+int ed25519_verify_batch(const uint8_t *const *signatures, const uint8_t *const *messages,
+                         const size_t *lens, const uint8_t *const *public_keys,
+                         size_t n, int *valid, int nthreads) {
+    int *own = valid ? NULL : malloc(n * sizeof *own + 1);
+    verify_job_t job = { .signatures = signatures, .messages = messages, .lens = lens,
+                         .public_keys = public_keys, .valid = valid ? valid : own, .n = n };
+    if (!job.valid) {
+        return 0;
+    }
+    memset(job.valid, 0, n * sizeof *job.valid);
+    size_t nchunks = (n + ED25519_BATCH - 1) / ED25519_BATCH;
+    if (nthreads <= 0) {
+        nthreads = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+        nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    }
+    if (nthreads > ED25519_MAX_THREADS) nthreads = ED25519_MAX_THREADS;
+    if ((size_t)nthreads > nchunks) nthreads = nchunks ? (int)nchunks : 1;
+
+    pthread_t tid[ED25519_MAX_THREADS];
+    int started = 0;
+    pthread_mutex_init(&job.lock, NULL);
+    for (; started < nthreads - 1; ++started)
+        if (pthread_create(&tid[started], NULL, verify_worker, &job) != 0) break;
+    verify_worker(&job);                       // the caller works too
+    for (int t = 0; t < started; ++t) pthread_join(tid[t], NULL);
+    pthread_mutex_destroy(&job.lock);
+
+    int all = !job.failed;
+    for (size_t i = 0; i < n && all; i++) all = job.valid[i];
+    free(own);
+    return all;
+}
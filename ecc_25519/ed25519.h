@@ -0,0 +1,37 @@
+#ifndef ED25519_H
+#define ED25519_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Ed25519 signatures (RFC 8032, pure variant) on the Edwards form of the
+// curve in ge25519.c. A secret key is a 32-byte random seed; signing uses
+// the constant-time fixed-base comb. Verification is variable time (all
+// its inputs are public) and cofactored, [8](S B - R - k A) = 0, so single
+// and batch verification accept exactly the same signatures.
+#define ED25519_SEED_SIZE       32
+#define ED25519_PUBLIC_KEY_SIZE 32
+#define ED25519_SIGNATURE_SIZE  64
+#define ED25519_BATCH           64   // signatures per multi-scalar multiplication
+
+void ed25519_public_key(uint8_t *public_key, const uint8_t *seed);
+void ed25519_sign(uint8_t *signature, const uint8_t *message, size_t len,
+                  const uint8_t *seed, const uint8_t *public_key);
+
+// 1 if the signature is valid, 0 otherwise
+int ed25519_verify(const uint8_t *signature, const uint8_t *message, size_t len,
+                   const uint8_t *public_key);
+
+// Batch verification: every ED25519_BATCH signatures are combined with
+// random 128-bit weights z_i into one check
+//   [8]((sum z_i S_i) B - sum z_i R_i - sum (z_i k_i) A_i) = 0
+// done as a single multi-scalar multiplication, so each signature costs a
+// fraction of a separate verification. A batch that fails is verified
+// entry by entry to find the bad signatures. Chunks are spread over
+// nthreads threads (<= 0: one per CPU). valid (may be NULL) receives 1/0
+// per signature; returns 1 if all n are valid.
+int ed25519_verify_batch(const uint8_t *const *signatures, const uint8_t *const *messages,
+                         const size_t *lens, const uint8_t *const *public_keys,
+                         size_t n, int *valid, int nthreads);
+
+#endif /* ED25519_H */
@@ -0,0 +1,241 @@
+#include "field25519.h"
+
+typedef unsigned __int128 uint128_t;
+
+// Carry the five 128-bit column sums into 51-bit limbs, folding the part
+// above 2^255 back into limb 0 as *19
+static void field_carry_wide(gf o, uint128_t t0, uint128_t t1, uint128_t t2,
+                             uint128_t t3, uint128_t t4) {
+    uint64_t r0, r1, r2, r3, r4;
+
+    r0 = (uint64_t)t0 & FIELD_MASK51; t1 += (uint64_t)(t0 >> 51);
+    r1 = (uint64_t)t1 & FIELD_MASK51; t2 += (uint64_t)(t1 >> 51);
+    r2 = (uint64_t)t2 & FIELD_MASK51; t3 += (uint64_t)(t2 >> 51);
+    r3 = (uint64_t)t3 & FIELD_MASK51; t4 += (uint64_t)(t3 >> 51);
+    r4 = (uint64_t)t4 & FIELD_MASK51;
+    t0 = (uint128_t)(uint64_t)(t4 >> 51) * 19 + r0;
+    r0 = (uint64_t)t0 & FIELD_MASK51;
+    r1 += (uint64_t)(t0 >> 51);
+
+    o[0] = r0; o[1] = r1; o[2] = r2; o[3] = r3; o[4] = r4;
+}
+
+// One carry pass over 64-bit limbs
+static void field_carry(gf o) {
+    uint64_t c;
+    c = o[0] >> 51; o[0] &= FIELD_MASK51; o[1] += c;
+    c = o[1] >> 51; o[1] &= FIELD_MASK51; o[2] += c;
+    c = o[2] >> 51; o[2] &= FIELD_MASK51; o[3] += c;
+    c = o[3] >> 51; o[3] &= FIELD_MASK51; o[4] += c;
+    c = o[4] >> 51; o[4] &= FIELD_MASK51; o[0] += 19 * c;
+}
+
+void field_subtract(gf o, const gf a, const gf b) {
+    // 4p in radix 2^51
+    o[0] = a[0] + UINT64_C(0x1FFFFFFFFFFFB4) - b[0];
+    o[1] = a[1] + UINT64_C(0x1FFFFFFFFFFFFC) - b[1];
+    o[2] = a[2] + UINT64_C(0x1FFFFFFFFFFFFC) - b[2];
+    o[3] = a[3] + UINT64_C(0x1FFFFFFFFFFFFC) - b[3];
+    o[4] = a[4] + UINT64_C(0x1FFFFFFFFFFFFC) - b[4];
+    field_carry(o);
+}
+
+void field_negate(gf o, const gf a) {
+    static const gf zero = {0};
+    field_subtract(o, zero, a);
+}
+
+// Schoolbook 5x5 product; limb i*j with i+j >= 5 wraps around with a
+// factor 19 since 2^255 = 19 (mod p)
+void field_multiply(gf o, const gf a, const gf b) {
+    const uint64_t a0 = a[0], a1 = a[1], a2 = a[2], a3 = a[3], a4 = a[4];
+    const uint64_t b0 = b[0], b1 = b[1], b2 = b[2], b3 = b[3], b4 = b[4];
+    const uint64_t b1_19 = 19 * b1, b2_19 = 19 * b2, b3_19 = 19 * b3, b4_19 = 19 * b4;
+
+    uint128_t t0 = (uint128_t)a0 * b0 + (uint128_t)a1 * b4_19 + (uint128_t)a2 * b3_19
+                 + (uint128_t)a3 * b2_19 + (uint128_t)a4 * b1_19;
+    uint128_t t1 = (uint128_t)a0 * b1 + (uint128_t)a1 * b0 + (uint128_t)a2 * b4_19
+                 + (uint128_t)a3 * b3_19 + (uint128_t)a4 * b2_19;
+    uint128_t t2 = (uint128_t)a0 * b2 + (uint128_t)a1 * b1 + (uint128_t)a2 * b0
+                 + (uint128_t)a3 * b4_19 + (uint128_t)a4 * b3_19;
+    uint128_t t3 = (uint128_t)a0 * b3 + (uint128_t)a1 * b2 + (uint128_t)a2 * b1
+                 + (uint128_t)a3 * b0 + (uint128_t)a4 * b4_19;
+    uint128_t t4 = (uint128_t)a0 * b4 + (uint128_t)a1 * b3 + (uint128_t)a2 * b2
+                 + (uint128_t)a3 * b1 + (uint128_t)a4 * b0;
+
+    field_carry_wide(o, t0, t1, t2, t3, t4);
+}
+
+// Squaring shares the symmetric cross terms: 15 products instead of 25
+void field_square(gf o, const gf a) {
+    const uint64_t a0 = a[0], a1 = a[1], a2 = a[2], a3 = a[3], a4 = a[4];
+    const uint64_t a0_2 = 2 * a0, a1_2 = 2 * a1;
+    const uint64_t a3_19 = 19 * a3, a4_19 = 19 * a4;
+    const uint64_t a3_38 = 38 * a3, a4_38 = 38 * a4;
+
+    uint128_t t0 = (uint128_t)a0 * a0 + (uint128_t)a1 * a4_38 + (uint128_t)a2 * a3_38;
+    uint128_t t1 = (uint128_t)a0_2 * a1 + (uint128_t)a2 * a4_38 + (uint128_t)a3 * a3_19;
+    uint128_t t2 = (uint128_t)a0_2 * a2 + (uint128_t)a1 * a1 + (uint128_t)a3 * a4_38;
+    uint128_t t3 = (uint128_t)a0_2 * a3 + (uint128_t)a1_2 * a2 + (uint128_t)a4 * a4_19;
+    uint128_t t4 = (uint128_t)a0_2 * a4 + (uint128_t)a1_2 * a3 + (uint128_t)a2 * a2;
+
+    field_carry_wide(o, t0, t1, t2, t3, t4);
+}
+
+// n successive squarings
+static void field_square_n(gf o, const gf a, int n) {
+    field_square(o, a);
+    while (--n > 0) field_square(o, o);
+}
+
+void field_mul_small(gf o, const gf a, uint32_t k) {
+    field_carry_wide(o, (uint128_t)a[0] * k, (uint128_t)a[1] * k, (uint128_t)a[2] * k,
+                     (uint128_t)a[3] * k, (uint128_t)a[4] * k);
+}
+
+// a^(p-2) by the usual addition chain: 254 squarings and 11 multiplications
+void field_invert(gf o, const gf a) {
+    gf z2, z9, z11, z2_5_0, z2_10_0, z2_20_0, z2_50_0, z2_100_0, t;
+
+    field_square(z2, a);                    // 2
+    field_square_n(t, z2, 2);               // 8
+    field_multiply(z9, t, a);               // 9
+    field_multiply(z11, z9, z2);            // 11
+    field_square(t, z11);                   // 22
+    field_multiply(z2_5_0, t, z9);          // 2^5 - 2^0
+    field_square_n(t, z2_5_0, 5);
+    field_multiply(z2_10_0, t, z2_5_0);     // 2^10 - 2^0
+    field_square_n(t, z2_10_0, 10);
+    field_multiply(z2_20_0, t, z2_10_0);    // 2^20 - 2^0
+    field_square_n(t, z2_20_0, 20);
+    field_multiply(t, t, z2_20_0);          // 2^40 - 2^0
+    field_square_n(t, t, 10);
+    field_multiply(z2_50_0, t, z2_10_0);    // 2^50 - 2^0
+    field_square_n(t, z2_50_0, 50);
+    field_multiply(z2_100_0, t, z2_50_0);   // 2^100 - 2^0
+    field_square_n(t, z2_100_0, 100);
+    field_multiply(t, t, z2_100_0);         // 2^200 - 2^0
+    field_square_n(t, t, 50);
+    field_multiply(t, t, z2_50_0);          // 2^250 - 2^0
+    field_square_n(t, t, 5);                // 2^255 - 2^5
+    field_multiply(o, t, z11);              // 2^255 - 21
+}
+
+// scratch[i] = a[0] * ... * a[i] with zeros counted as one; the inverse of
+// the full product is then peeled back one element at a time
+void field_batch_invert(gf *a, size_t n, gf *scratch) {
+    static const gf zero = {0}, one = {1};
+    gf acc, t, ai;
+
+    if (n == 0) return;
+    field_copy(acc, one);
+    for (size_t i = 0; i < n; i++) {
+        field_copy(t, a[i]);
+        field_cmov(t, one, field_is_zero(a[i]));
+        field_multiply(acc, acc, t);
+        field_copy(scratch[i], acc);
+    }
+    field_invert(acc, acc);
+    for (size_t i = n; i-- > 0; ) {
+        int is_zero = field_is_zero(a[i]);
+        if (i > 0) {
+            field_multiply(t, acc, scratch[i - 1]);
+        } else {
+            field_copy(t, acc);
+        }
+        field_copy(ai, a[i]);
+        field_cmov(ai, one, is_zero);
+        field_multiply(acc, acc, ai);
+        field_cmov(t, zero, is_zero);
+        field_copy(a[i], t);
+    }
+}
+
+// a^(2^252 - 3), the same chain as field_invert up to 2^250 - 1
+void field_pow22523(gf o, const gf a) {
+    gf z2, z9, z2_5_0, z2_10_0, z2_20_0, z2_50_0, z2_100_0, t;
+
+    field_square(z2, a);
+    field_square_n(t, z2, 2);
+    field_multiply(z9, t, a);
+    field_multiply(t, z9, z2);              // 11
+    field_square(t, t);
+    field_multiply(z2_5_0, t, z9);
+    field_square_n(t, z2_5_0, 5);
+    field_multiply(z2_10_0, t, z2_5_0);
+    field_square_n(t, z2_10_0, 10);
+    field_multiply(z2_20_0, t, z2_10_0);
+    field_square_n(t, z2_20_0, 20);
+    field_multiply(t, t, z2_20_0);
+    field_square_n(t, t, 10);
+    field_multiply(z2_50_0, t, z2_10_0);
+    field_square_n(t, z2_50_0, 50);
+    field_multiply(z2_100_0, t, z2_50_0);
+    field_square_n(t, z2_100_0, 100);
+    field_multiply(t, t, z2_100_0);
+    field_square_n(t, t, 50);
+    field_multiply(t, t, z2_50_0);          // 2^250 - 1
+    field_square_n(t, t, 2);                // 2^252 - 4
+    field_multiply(o, t, a);                // 2^252 - 3
+}
+
+int field_is_zero(const gf a) {
+    uint8_t s[32], acc = 0;
+    field_pack(s, a);
+    for (int i = 0; i < 32; i++) acc |= s[i];
+    return (int)(((unsigned)acc - 1) >> 8) & 1;
+}
+
+int field_is_negative(const gf a) {
+    uint8_t s[32];
+    field_pack(s, a);
+    return s[0] & 1;
+}
+
+void field_unpack(gf o, const uint8_t *n) {
+    uint64_t w[4];
+    for (int i = 0; i < 4; i++) {
+        w[i] = 0;
+        for (int j = 7; j >= 0; j--) w[i] = (w[i] << 8) | n[8 * i + j];
+    }
+    o[0] = w[0] & FIELD_MASK51;
+    o[1] = ((w[0] >> 51) | (w[1] << 13)) & FIELD_MASK51;
+    o[2] = ((w[1] >> 38) | (w[2] << 26)) & FIELD_MASK51;
+    o[3] = ((w[2] >> 25) | (w[3] << 39)) & FIELD_MASK51;
+    o[4] = (w[3] >> 12) & FIELD_MASK51;
+}
+
+void field_pack(uint8_t *o, const gf n) {
+    gf t;
+    uint64_t q;
+
+    // Three carry passes leave every limb below 2^51, i.e. t < 2^255
+    field_copy(t, n);
+    field_carry(t);
+    field_carry(t);
+    field_carry(t);
+
+    // q = 1 iff t >= p, i.e. t + 19 overflows 2^255; subtract p by adding
+    // 19 and dropping bit 255
+    q = (t[0] + 19) >> 51;
+    q = (t[1] + q) >> 51;
+    q = (t[2] + q) >> 51;
+    q = (t[3] + q) >> 51;
+    q = (t[4] + q) >> 51;
+    t[0] += 19 * q;
+    t[1] += t[0] >> 51; t[0] &= FIELD_MASK51;
+    t[2] += t[1] >> 51; t[1] &= FIELD_MASK51;
+    t[3] += t[2] >> 51; t[2] &= FIELD_MASK51;
+    t[4] += t[3] >> 51; t[3] &= FIELD_MASK51;
+    t[4] &= FIELD_MASK51;
+
+    const uint64_t w[4] = {
+        t[0] | (t[1] << 51),
+        (t[1] >> 13) | (t[2] << 38),
+        (t[2] >> 26) | (t[3] << 25),
+        (t[3] >> 39) | (t[4] << 12),
+    };
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 8; j++) o[8 * i + j] = (uint8_t)(w[i] >> (8 * j));
+    }
+}
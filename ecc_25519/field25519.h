@@ -0,0 +1,67 @@
+#ifndef FIELD25519_H
+#define FIELD25519_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if !defined(__SIZEOF_INT128__)
+#error "field25519 needs a compiler with unsigned __int128 (64-bit GCC or Clang)"
+#endif
+
+// Elements of GF(2^255 - 19) in radix 2^51: five 64-bit limbs, value
+// sum(o[i] * 2^(51*i)). Limbs are not kept fully reduced: multiply and
+// square return limbs just above 2^51 and accept inputs up to 2^54, which
+// leaves room for a few field_add results to be fed in directly.
+typedef uint64_t gf[5];
+
+#define FIELD_MASK51 ((UINT64_C(1) << 51) - 1)
+
+static inline void field_copy(gf r, const gf a) {
+    for (int i = 0; i < 5; i++) r[i] = a[i];
+}
+
+static inline void field_add(gf o, const gf a, const gf b) {
+    for (int i = 0; i < 5; i++) o[i] = a[i] + b[i];
+}
+
+// a - b computed as a + 4p - b so limbs never go negative (b < 2^53),
+// followed by one carry pass
+void field_subtract(gf o, const gf a, const gf b);
+
+// Constant-time swap of p and q when b is 1
+static inline void field_cswap(gf p, gf q, int b) {
+    uint64_t mask = (uint64_t)0 - (uint64_t)b;
+    for (int i = 0; i < 5; i++) {
+        uint64_t t = mask & (p[i] ^ q[i]);
+        p[i] ^= t;
+        q[i] ^= t;
+    }
+}
+
+// Constant-time r = a when b is 1
+static inline void field_cmov(gf r, const gf a, int b) {
+    uint64_t mask = (uint64_t)0 - (uint64_t)b;
+    for (int i = 0; i < 5; i++) r[i] ^= mask & (r[i] ^ a[i]);
+}
+
+void field_negate(gf o, const gf a);
+void field_multiply(gf o, const gf a, const gf b);
+void field_square(gf o, const gf a);
+void field_mul_small(gf o, const gf a, uint32_t k);
+void field_invert(gf o, const gf a);
+void field_pow22523(gf o, const gf a);   // a^((p-5)/8), for square roots
+
+// Inverts a[0..n) in place with one field_invert (Montgomery's trick);
+// zero elements stay zero, as with field_invert. scratch holds n elements.
+void field_batch_invert(gf *a, size_t n, gf *scratch);
+
+// Predicates on the canonical encoding: zero, and "negative" (odd)
+int field_is_zero(const gf a);
+int field_is_negative(const gf a);
+
+// Little-endian 32-byte encoding; unpack ignores bit 255, pack always
+// writes the canonical (fully reduced) value
+void field_unpack(gf o, const uint8_t *n);
+void field_pack(uint8_t *o, const gf n);
+
+#endif /* FIELD25519_H */
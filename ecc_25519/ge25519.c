@@ -0,0 +1,193 @@
+#include "ge25519.h"
+
+const gf ge_d = {
+    0x34dca135978a3, 0x1a8283b156ebd, 0x5e7a26001c029, 0x739c663a03cbb, 0x52036cee2b6ff
+};
+const gf ge_d2 = {
+    0x69b9426b2f159, 0x35050762add7a, 0x3cf44c0038052, 0x6738cc7407977, 0x2406d9dc56dff
+};
+static const gf ge_sqrtm1 = {
+    0x61b274a0ea0b0, 0x0d5a5fc8f189d, 0x7ef5e9cbd0c60, 0x78595a6804c9e, 0x2b8324804fc1d
+};
+
+void ge_p3_0(ge_p3 *h) {
+    for (int i = 0; i < 5; i++) h->X[i] = h->Y[i] = h->Z[i] = h->T[i] = 0;
+    h->Y[0] = h->Z[0] = 1;
+}
+
+void ge_p3_to_p2(ge_p2 *r, const ge_p3 *p) {
+    field_copy(r->X, p->X);
+    field_copy(r->Y, p->Y);
+    field_copy(r->Z, p->Z);
+}
+
+void ge_p3_to_cached(ge_cached *r, const ge_p3 *p) {
+    field_add(r->YplusX, p->Y, p->X);
+    field_subtract(r->YminusX, p->Y, p->X);
+    field_copy(r->Z, p->Z);
+    field_multiply(r->T2d, p->T, ge_d2);
+}
+
+void ge_p1p1_to_p2(ge_p2 *r, const ge_p1p1 *p) {
+    field_multiply(r->X, p->X, p->T);
+    field_multiply(r->Y, p->Y, p->Z);
+    field_multiply(r->Z, p->Z, p->T);
+}
+
+void ge_p1p1_to_p3(ge_p3 *r, const ge_p1p1 *p) {
+    field_multiply(r->X, p->X, p->T);
+    field_multiply(r->Y, p->Y, p->Z);
+    field_multiply(r->Z, p->Z, p->T);
+    field_multiply(r->T, p->X, p->Y);
+}
+
+// r = p + q (add-2008-hwcd-3)
+void ge_add(ge_p1p1 *r, const ge_p3 *p, const ge_cached *q) {
+    gf t0;
+    field_add(r->X, p->Y, p->X);
+    field_subtract(r->Y, p->Y, p->X);
+    field_multiply(r->Z, r->X, q->YplusX);
+    field_multiply(r->Y, r->Y, q->YminusX);
+    field_multiply(r->T, q->T2d, p->T);
+    field_multiply(r->X, p->Z, q->Z);
+    field_add(t0, r->X, r->X);
+    field_subtract(r->X, r->Z, r->Y);
+    field_add(r->Y, r->Z, r->Y);
+    field_add(r->Z, t0, r->T);
+    field_subtract(r->T, t0, r->T);
+}
+
+// r = p - q
+void ge_sub(ge_p1p1 *r, const ge_p3 *p, const ge_cached *q) {
+    gf t0;
+    field_add(r->X, p->Y, p->X);
+    field_subtract(r->Y, p->Y, p->X);
+    field_multiply(r->Z, r->X, q->YminusX);
+    field_multiply(r->Y, r->Y, q->YplusX);
+    field_multiply(r->T, q->T2d, p->T);
+    field_multiply(r->X, p->Z, q->Z);
+    field_add(t0, r->X, r->X);
+    field_subtract(r->X, r->Z, r->Y);
+    field_add(r->Y, r->Z, r->Y);
+    field_subtract(r->Z, t0, r->T);
+    field_add(r->T, t0, r->T);
+}
+
+// r = p + q for an affine q (madd-2008-hwcd-3)
+void ge_madd(ge_p1p1 *r, const ge_p3 *p, const ge_precomp *q) {
+    gf t0;
+    field_add(r->X, p->Y, p->X);
+    field_subtract(r->Y, p->Y, p->X);
+    field_multiply(r->Z, r->X, q->yplusx);
+    field_multiply(r->Y, r->Y, q->yminusx);
+    field_multiply(r->T, q->xy2d, p->T);
+    field_add(t0, p->Z, p->Z);
+    field_subtract(r->X, r->Z, r->Y);
+    field_add(r->Y, r->Z, r->Y);
+    field_add(r->Z, t0, r->T);
+    field_subtract(r->T, t0, r->T);
+}
+
+// r = p - q for an affine q
+void ge_msub(ge_p1p1 *r, const ge_p3 *p, const ge_precomp *q) {
+    gf t0;
+    field_add(r->X, p->Y, p->X);
+    field_subtract(r->Y, p->Y, p->X);
+    field_multiply(r->Z, r->X, q->yminusx);
+    field_multiply(r->Y, r->Y, q->yplusx);
+    field_multiply(r->T, q->xy2d, p->T);
+    field_add(t0, p->Z, p->Z);
+    field_subtract(r->X, r->Z, r->Y);
+    field_add(r->Y, r->Z, r->Y);
+    field_subtract(r->Z, t0, r->T);
+    field_add(r->T, t0, r->T);
+}
+
+// r = 2p (dbl-2008-hwcd)
+void ge_p2_dbl(ge_p1p1 *r, const ge_p2 *p) {
+    gf t0;
+    field_square(r->X, p->X);
+    field_square(r->Z, p->Y);
+    field_square(r->T, p->Z);
+    field_add(r->T, r->T, r->T);
+    field_add(r->Y, p->X, p->Y);
+    field_square(t0, r->Y);
+    field_add(r->Y, r->Z, r->X);
+    field_subtract(r->Z, r->Z, r->X);
+    field_subtract(r->X, t0, r->Y);
+    field_subtract(r->T, r->T, r->Z);
+}
+
+void ge_p3_dbl(ge_p1p1 *r, const ge_p3 *p) {
+    ge_p2 q;
+    ge_p3_to_p2(&q, p);
+    ge_p2_dbl(r, &q);
+}
+
+void ge_p3_to_precomp(ge_precomp *r, const ge_p3 *p) {
+    gf recip, x, y;
+    field_invert(recip, p->Z);
+    field_multiply(x, p->X, recip);
+    field_multiply(y, p->Y, recip);
+    field_add(r->yplusx, y, x);
+    field_subtract(r->yminusx, y, x);
+    field_multiply(r->xy2d, x, y);
+    field_multiply(r->xy2d, r->xy2d, ge_d2);
+}
+
+// x is recovered from y as sqrt(u/v) with u = y^2 - 1 and v = d y^2 + 1,
+// computed as u v^3 (u v^7)^((p-5)/8) and corrected by sqrt(-1) if needed
+int ge_frombytes(ge_p3 *h, const uint8_t *s) {
+    static const gf one = {1};
+    gf u, v, v3, vxx, check;
+
+    field_unpack(h->Y, s);
+    field_copy(h->Z, one);
+    field_square(u, h->Y);
+    field_multiply(v, u, ge_d);
+    field_subtract(u, u, h->Z);             // u = y^2 - 1
+    field_add(v, v, h->Z);                  // v = d y^2 + 1
+
+    field_square(v3, v);
+    field_multiply(v3, v3, v);              // v^3
+    field_square(h->X, v3);
+    field_multiply(h->X, h->X, v);
+    field_multiply(h->X, h->X, u);          // u v^7
+    field_pow22523(h->X, h->X);
+    field_multiply(h->X, h->X, v3);
+    field_multiply(h->X, h->X, u);          // u v^3 (u v^7)^((p-5)/8)
+
+    field_square(vxx, h->X);
+    field_multiply(vxx, vxx, v);
+    field_subtract(check, vxx, u);
+    if (!field_is_zero(check)) {
+        field_add(check, vxx, u);
+        if (!field_is_zero(check)) return -1;
+        field_multiply(h->X, h->X, ge_sqrtm1);
+    }
+
+    if (field_is_negative(h->X) != (s[31] >> 7)) {
+        if (field_is_zero(h->X)) return -1;   // -0 is not a valid encoding
+        field_negate(h->X, h->X);
+    }
+    field_multiply(h->T, h->X, h->Y);
+    return 0;
+}
+
+void ge_p3_tobytes(uint8_t *s, const ge_p3 *h) {
+    gf recip, x, y;
+    field_invert(recip, h->Z);
+    field_multiply(x, h->X, recip);
+    field_multiply(y, h->Y, recip);
+    field_pack(s, y);
+    s[31] ^= (uint8_t)(field_is_negative(x) << 7);
+}
+
+void ge_p3_to_montgomery(uint8_t *u, const ge_p3 *h) {
+    gf n, d;
+    field_add(n, h->Z, h->Y);
+    field_subtract(d, h->Z, h->Y);
+    field_invert(d, d);
+    field_multiply(n, n, d);
+    field_pack(u, n);
+}
@@ -0,0 +1,59 @@
+#ifndef GE25519_H
+#define GE25519_H
+
+#include "field25519.h"
+
+// Points on the twisted Edwards curve -x^2 + y^2 = 1 + d x^2 y^2 that is
+// birationally equivalent to Curve25519, in the representations of the
+// ref10 code:
+//   ge_p2:      projective (X:Y:Z), x = X/Z, y = Y/Z
+//   ge_p3:      extended (X:Y:Z:T) with T = XY/Z
+//   ge_p1p1:    completed ((X:Z),(Y:T)), the output of add and double
+//   ge_precomp: affine Niels form (y+x, y-x, 2dxy), used for table points
+//   ge_cached:  projective Niels form (Y+X, Y-X, Z, 2dT)
+typedef struct { gf X, Y, Z; } ge_p2;
+typedef struct { gf X, Y, Z, T; } ge_p3;
+typedef struct { gf X, Y, Z, T; } ge_p1p1;
+typedef struct { gf yplusx, yminusx, xy2d; } ge_precomp;
+typedef struct { gf YplusX, YminusX, Z, T2d; } ge_cached;
+
+extern const gf ge_d;     // d = -121665/121666
+extern const gf ge_d2;    // 2d
+
+void ge_p3_0(ge_p3 *h);
+void ge_p3_to_p2(ge_p2 *r, const ge_p3 *p);
+void ge_p3_to_cached(ge_cached *r, const ge_p3 *p);
+void ge_p1p1_to_p2(ge_p2 *r, const ge_p1p1 *p);
+void ge_p1p1_to_p3(ge_p3 *r, const ge_p1p1 *p);
+
+void ge_add(ge_p1p1 *r, const ge_p3 *p, const ge_cached *q);
+void ge_sub(ge_p1p1 *r, const ge_p3 *p, const ge_cached *q);
+void ge_madd(ge_p1p1 *r, const ge_p3 *p, const ge_precomp *q);
+void ge_msub(ge_p1p1 *r, const ge_p3 *p, const ge_precomp *q);
+void ge_p2_dbl(ge_p1p1 *r, const ge_p2 *p);
+void ge_p3_dbl(ge_p1p1 *r, const ge_p3 *p);
+
+// Affine Niels form of p (one inversion)
+void ge_p3_to_precomp(ge_precomp *r, const ge_p3 *p);
+
+// RFC 8032 point encoding; frombytes returns -1 for strings that are not
+// the encoding of a curve point
+int  ge_frombytes(ge_p3 *h, const uint8_t *s);
+void ge_p3_tobytes(uint8_t *s, const ge_p3 *h);
+
+// Montgomery u-coordinate u = (1 + y) / (1 - y) = (Z + Y) / (Z - Y)
+void ge_p3_to_montgomery(uint8_t *u, const ge_p3 *h);
+
+// h = a * B for the standard base point B, constant time, using the
+// precomputed table in ge25519_base.c. a is 32 little-endian bytes with
+// a[31] <= 127.
+void ge_scalarmult_base(ge_p3 *h, const uint8_t *a);
+
+// The same comb for an arbitrary point: ge_table_build fills table[i][j]
+// with (j + 1) * 256^i * p (about 250 doublings, 224 additions and one
+// inversion), and ge_scalarmult_table computes a * p from it in constant
+// time, with the same scalar restriction as above.
+void ge_table_build(ge_precomp table[32][8], const ge_p3 *p);
+void ge_scalarmult_table(ge_p3 *h, const ge_precomp table[32][8], const uint8_t *a);
+
+#endif /* GE25519_H */
@@ -0,0 +1,125 @@
+#include "ge25519.h"
+
+// ge25519_base[i][j] = (j + 1) * 256^i * B, written by ge25519_gen
+#include "ge25519_base_table.h"
+
+// 1 if b == c, without branches
+static int digit_equal(int8_t b, int8_t c) {
+    uint32_t x = (uint8_t)b ^ (uint8_t)c;
+    return (int)((x - 1) >> 31);
+}
+
+static int digit_negative(int8_t b) {
+    return (int)(((uint64_t)(int64_t)b) >> 63);
+}
+
+static void precomp_cmov(ge_precomp *t, const ge_precomp *u, int b) {
+    field_cmov(t->yplusx, u->yplusx, b);
+    field_cmov(t->yminusx, u->yminusx, b);
+    field_cmov(t->xy2d, u->xy2d, b);
+}
+
+// t = b * row[0] for a digit -8 <= b <= 8, reading all eight table
+// entries of the row so the access pattern does not depend on b
+static void select_row(ge_precomp *t, const ge_precomp row[8], int8_t b) {
+    ge_precomp minus;
+    int neg = digit_negative(b);
+    int8_t babs = (int8_t)(b - ((-neg) & b) * 2);
+
+    for (int i = 0; i < 5; i++) {
+        t->yplusx[i] = t->yminusx[i] = t->xy2d[i] = 0;
+    }
+    t->yplusx[0] = t->yminusx[0] = 1;
+    for (int j = 0; j < 8; j++) {
+        precomp_cmov(t, &row[j], digit_equal(babs, (int8_t)(j + 1)));
+    }
+    field_copy(minus.yplusx, t->yminusx);
+    field_copy(minus.yminusx, t->yplusx);
+    field_negate(minus.xy2d, t->xy2d);
+    precomp_cmov(t, &minus, neg);
+}
+
+// The scalar is recoded into 64 signed radix-16 digits e[i] in [-8, 8],
+// a = sum e[i] 16^i. Odd digits are accumulated first and multiplied by 16,
+// then the even digits are added, so one table row of 256^(i/2) multiples
+// serves both halves: 64 mixed additions and 4 doublings in total.
+void ge_scalarmult_table(ge_p3 *h, const ge_precomp table[32][8], const uint8_t *a) {
+    int8_t e[64], carry = 0;
+    ge_p1p1 r;
+    ge_p2 s;
+    ge_precomp t;
+
+    for (int i = 0; i < 32; i++) {
+        e[2 * i + 0] = (int8_t)(a[i] & 15);
+        e[2 * i + 1] = (int8_t)((a[i] >> 4) & 15);
+    }
+    for (int i = 0; i < 63; i++) {
+        e[i] = (int8_t)(e[i] + carry);
+        carry = (int8_t)((e[i] + 8) >> 4);
+        e[i] = (int8_t)(e[i] - carry * 16);
+    }
+    e[63] = (int8_t)(e[63] + carry);
+
+    ge_p3_0(h);
+    for (int i = 1; i < 64; i += 2) {
+        select_row(&t, table[i / 2], e[i]);
+        ge_madd(&r, h, &t);
+        ge_p1p1_to_p3(h, &r);
+    }
+
+    ge_p3_dbl(&r, h);
+    ge_p1p1_to_p2(&s, &r);
+    ge_p2_dbl(&r, &s);
+    ge_p1p1_to_p2(&s, &r);
+    ge_p2_dbl(&r, &s);
+    ge_p1p1_to_p2(&s, &r);
+    ge_p2_dbl(&r, &s);
+    ge_p1p1_to_p3(h, &r);
+
+    for (int i = 0; i < 64; i += 2) {
+        select_row(&t, table[i / 2], e[i]);
+        ge_madd(&r, h, &t);
+        ge_p1p1_to_p3(h, &r);
+    }
+
+    for (int i = 0; i < 64; i++) e[i] = 0;
+}
+
+void ge_scalarmult_base(ge_p3 *h, const uint8_t *a) {
+    ge_scalarmult_table(h, ge25519_base, a);
+}
+
+// Same rows as ge25519_gen, but the 256 points are made affine with one
+// shared inversion instead of one inversion each
+void ge_table_build(ge_precomp table[32][8], const ge_p3 *p) {
+    ge_p3 pts[256], row = *p;
+    gf z[256], scratch[256];
+    ge_p1p1 r;
+    ge_cached c;
+
+    for (int i = 0; i < 32; i++) {
+        ge_p3_to_cached(&c, &row);
+        pts[8 * i] = row;
+        for (int j = 1; j < 8; j++) {
+            ge_add(&r, &pts[8 * i + j - 1], &c);
+            ge_p1p1_to_p3(&pts[8 * i + j], &r);
+        }
+        for (int k = 0; k < 8; k++) {
+            ge_p3_dbl(&r, &row);
+            ge_p1p1_to_p3(&row, &r);
+        }
+    }
+
+    for (int k = 0; k < 256; k++) field_copy(z[k], pts[k].Z);
+    field_batch_invert(z, 256, scratch);
+    for (int k = 0; k < 256; k++) {
+        ge_precomp *t = &table[k / 8][k % 8];
+        gf x, y;
+        field_multiply(x, pts[k].X, z[k]);
+        field_multiply(y, pts[k].Y, z[k]);
+        field_add(t->yplusx, y, x);
+        field_subtract(t->yminusx, y, x);
+        field_multiply(t->xy2d, x, y);
+        field_multiply(t->xy2d, t->xy2d, ge_d2);
+    }
+}
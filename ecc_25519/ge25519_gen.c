@@ -0,0 +1,64 @@
+// Build-time generator for ge25519_base_table.h: prints the fixed-base
+// comb table used by ge_scalarmult_base, i.e. (j + 1) * 256^i * B for
+// i = 0..31 and j = 0..7 in affine Niels form with fully reduced limbs.
+#include "ge25519.h"
+#include <stdio.h>
+
+// Standard encoding of the Ed25519 base point, y = 4/5 with x even
+static const uint8_t base_point[32] = {
+    0x58, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66,
+    0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66,
+    0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66,
+    0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66,
+};
+
+static void print_gf(const gf a) {
+    uint8_t s[32];
+    gf t;
+    field_pack(s, a);
+    field_unpack(t, s);
+    printf("{ 0x%013llx, 0x%013llx, 0x%013llx, 0x%013llx, 0x%013llx }",
+           (unsigned long long)t[0], (unsigned long long)t[1], (unsigned long long)t[2],
+           (unsigned long long)t[3], (unsigned long long)t[4]);
+}
+
+int main(void) {
+    ge_p3 row, p;
+    ge_p1p1 r;
+    ge_cached c;
+
+    if (ge_frombytes(&row, base_point) != 0) {
+        fprintf(stderr, "ge25519_gen: cannot decode the base point\n");
+        return 1;
+    }
+
+    printf("/* Generated by ge25519_gen at build time, do not edit */\n");
+    printf("static const ge_precomp ge25519_base[32][8] = {\n");
+    for (int i = 0; i < 32; i++) {
+        printf("  { /* 256^%d * B */\n", i);
+        p = row;
+        ge_p3_to_cached(&c, &row);
+        for (int j = 0; j < 8; j++) {
+            ge_precomp pre;
+            ge_p3_to_precomp(&pre, &p);
+            printf("    { ");
+            print_gf(pre.yplusx);
+            printf(",\n      ");
+            print_gf(pre.yminusx);
+            printf(",\n      ");
+            print_gf(pre.xy2d);
+            printf(" },\n");
+            ge_add(&r, &p, &c);
+            ge_p1p1_to_p3(&p, &r);
+        }
+        printf("  },\n");
+
+        // next row: 256 * row, eight doublings
+        for (int k = 0; k < 8; k++) {
+            ge_p3_dbl(&r, &row);
+            ge_p1p1_to_p3(&row, &r);
+        }
+    }
+    printf("};\n");
+    return 0;
+}
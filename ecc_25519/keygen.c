@@ -1,25 +1,82 @@
 #include "common.h"
-#include "curve25519.h"
+#include "sccrypto.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#define KEYGEN_BATCH 4096   // keypairs generated per batch call
+
 static void usage(const char *prog) {
-    fprintf(stderr, "Usage: %s <basename>\n", prog);
+    fprintf(stderr, "Usage: %s [-n COUNT] [-t THREADS] <basename>\n", prog);
     fprintf(stderr, "  This will generate <basename>.pub and <basename>.priv key files\n");
+    fprintf(stderr, "  With -n, COUNT keys are written back to back, 32 bytes each, so key i\n");
+    fprintf(stderr, "  is at offset 32*i in both files\n");
     exit(EXIT_FAILURE);
 }
 
+// Bulk mode: batches of random private keys go through the batched
+// fixed-base multiplication and are appended to the two packed files
+static int generate_bulk(const char *priv_name, const char *pub_name,
+                         unsigned long long count, int threads) {
+    uint8_t (*priv)[FIELD_SIZE] = malloc(KEYGEN_BATCH * FIELD_SIZE);
+    uint8_t (*pub)[FIELD_SIZE] = malloc(KEYGEN_BATCH * FIELD_SIZE);
+    FILE *f_priv = fopen(priv_name, "wb");
+    FILE *f_pub = fopen(pub_name, "wb");
+    if (!priv || !pub || !f_priv || !f_pub) {
+        perror("keygen");
+        return EXIT_FAILURE;
+    }
+
+    for (unsigned long long done = 0; done < count; ) {
+        size_t n = count - done < KEYGEN_BATCH ? (size_t)(count - done) : KEYGEN_BATCH;
+        curve25519_random_bytes(&priv[0][0], n * FIELD_SIZE);
+        for (size_t i = 0; i < n; i++) {
+            curve25519_clamp(priv[i]);
+        }
+        curve25519_compute_public_batch(pub, (const uint8_t (*)[FIELD_SIZE])priv, n, threads);
+        if (fwrite(priv, FIELD_SIZE, n, f_priv) != n || fwrite(pub, FIELD_SIZE, n, f_pub) != n) {
+            fprintf(stderr, "ERROR: Failed to write key files\n");
+            return EXIT_FAILURE;
+        }
+        done += n;
+    }
+    memset(priv, 0, KEYGEN_BATCH * FIELD_SIZE);
+    if (fclose(f_priv) != 0 || fclose(f_pub) != 0) {
+        fprintf(stderr, "ERROR: Failed to write key files\n");
+        return EXIT_FAILURE;
+    }
+    free(priv);
+    free(pub);
+
+    printf("%llu private keys written to: %s\n", count, priv_name);
+    printf("%llu public keys written to: %s\n", count, pub_name);
+    return 0;
+}
+
 int main(int argc, char **argv) {
-    if (argc != 2) {
+    unsigned long long count = 0;
+    int threads = 0;
+    const char *basename = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) count = strtoull(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (argv[i][0] != '-' && !basename) basename = argv[i];
+        else usage(argv[0]);
+    }
+    if (!basename) {
         usage(argv[0]);
     }
 
     // Create the filenames
     char priv_key_filename[256];
     char pub_key_filename[256];
-    snprintf(priv_key_filename, sizeof(priv_key_filename), "%s.priv", argv[1]);
-    snprintf(pub_key_filename, sizeof(pub_key_filename), "%s.pub", argv[1]);
+    snprintf(priv_key_filename, sizeof(priv_key_filename), "%s.priv", basename);
+    snprintf(pub_key_filename, sizeof(pub_key_filename), "%s.pub", basename);
+
+    if (count > 0) {
+        return generate_bulk(priv_key_filename, pub_key_filename, count, threads);
+    }
 
     // Generate the keypair
     key_pair_t keypair;
@@ -0,0 +1,143 @@
+#define _POSIX_C_SOURCE 200809L
+#include "keypool.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static struct {
+    key_pair_t *pairs;          // stack of ready pairs, pairs[0..available)
+    size_t capacity, available;
+    uint64_t hits, misses;
+    int nthreads, running, stopping;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+} pool = { .lock = PTHREAD_MUTEX_INITIALIZER, .wake = PTHREAD_COND_INITIALIZER };
+
+// Generates the missing pairs in one batch outside the lock, then moves
+// them into the pool and wipes the staging copy
+static void *refill_thread(void *arg) {
+    (void)arg;
+    uint8_t (*priv)[FIELD_SIZE] = malloc(pool.capacity * 2 * FIELD_SIZE);
+    if (priv == NULL) {
+        // keypool_take falls back to generating pairs inline
+        fprintf(stderr, "keypool: out of memory, key pairs are generated inline\n");
+        return NULL;
+    }
+    uint8_t (*pub)[FIELD_SIZE] = priv + pool.capacity;
+    
+    pthread_mutex_lock(&pool.lock);
+    while (!pool.stopping) {
+        if (2 * pool.available >= pool.capacity) {
+            pthread_cond_wait(&pool.wake, &pool.lock);
+            continue;
+        }
+        size_t n = pool.capacity - pool.available;
+        pthread_mutex_unlock(&pool.lock);
+        
+        curve25519_random_bytes(&priv[0][0], n * FIELD_SIZE);
+        for (size_t i = 0; i < n; i++) {
+            curve25519_clamp(priv[i]);
+        }
+        curve25519_compute_public_batch(pub, (const uint8_t (*)[FIELD_SIZE])priv, n, pool.nthreads);
+        
+        pthread_mutex_lock(&pool.lock);
+        for (size_t i = 0; i < n && pool.available < pool.capacity; i++) {
+            key_pair_t *slot = &pool.pairs[pool.available++];
+            memcpy(slot->private_key, priv[i], FIELD_SIZE);
+            memcpy(slot->public_key, pub[i], FIELD_SIZE);
+        }
+        memset(priv, 0, n * FIELD_SIZE);
+    }
+    pthread_mutex_unlock(&pool.lock);
+    free(priv);
+    return NULL;
+}
+
+int keypool_start(size_t capacity, int nthreads) {
+    if (capacity == 0) return 0;
+    pthread_mutex_lock(&pool.lock);
+    if (pool.running) {
+        pthread_mutex_unlock(&pool.lock);
+        return 0;
+    }
+    pool.pairs = calloc(capacity, sizeof *pool.pairs);
+    pool.capacity = capacity;
+    pool.available = 0;
+    pool.nthreads = nthreads;
+    pool.stopping = 0;
+    pool.running = pool.pairs != NULL &&
+                   pthread_create(&pool.thread, NULL, refill_thread, NULL) == 0;
+    if (!pool.running) {
+        free(pool.pairs);
+        pool.pairs = NULL;
+        pool.capacity = 0;
+    }
+    int ok = pool.running;
+    pthread_mutex_unlock(&pool.lock);
+    return ok;
+}
+
+void keypool_stop(void) {
+    pthread_mutex_lock(&pool.lock);
+    if (!pool.running) {
+        pthread_mutex_unlock(&pool.lock);
+        return;
+    }
+    pool.stopping = 1;
+    pthread_cond_signal(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+    pthread_join(pool.thread, NULL);
+    
+    pthread_mutex_lock(&pool.lock);
+    memset(pool.pairs, 0, pool.capacity * sizeof *pool.pairs);
+    free(pool.pairs);
+    pool.pairs = NULL;
+    pool.capacity = pool.available = 0;
+    pool.running = 0;
+    pthread_mutex_unlock(&pool.lock);
+}
+
+int keypool_take(key_pair_t *pair) {
+    pthread_mutex_lock(&pool.lock);
+    if (pool.available > 0) {
+        key_pair_t *slot = &pool.pairs[--pool.available];
+        *pair = *slot;
+        memset(slot, 0, sizeof *slot);
+        pool.hits++;
+        if (2 * pool.available < pool.capacity) pthread_cond_signal(&pool.wake);
+        pthread_mutex_unlock(&pool.lock);
+        return 1;
+    }
+    pool.misses++;
+    if (pool.running) pthread_cond_signal(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+    curve25519_generate_keypair(pair);
+    return 0;
+}
+
+size_t keypool_take_batch(uint8_t (*private_keys)[FIELD_SIZE],
+                          uint8_t (*public_keys)[FIELD_SIZE], size_t n) {
+    pthread_mutex_lock(&pool.lock);
+    size_t taken = n < pool.available ? n : pool.available;
+    for (size_t i = 0; i < taken; i++) {
+        key_pair_t *slot = &pool.pairs[--pool.available];
+        memcpy(private_keys[i], slot->private_key, FIELD_SIZE);
+        memcpy(public_keys[i], slot->public_key, FIELD_SIZE);
+        memset(slot, 0, sizeof *slot);
+    }
+    pool.hits += taken;
+    pool.misses += n - taken;
+    if (pool.running && 2 * pool.available < pool.capacity) pthread_cond_signal(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+    return taken;
+}
+
+void keypool_stats(keypool_stats_t *stats) {
+    pthread_mutex_lock(&pool.lock);
+    stats->hits = pool.hits;
+    stats->misses = pool.misses;
+    stats->available = pool.available;
+    stats->capacity = pool.capacity;
+    pthread_mutex_unlock(&pool.lock);
+}
@@ -0,0 +1,35 @@
+#ifndef KEYPOOL_H
+#define KEYPOOL_H
+
+#include "curve25519.h"
+
+// Pool of pre-generated ephemeral key pairs for ecc_encrypt. A background
+// thread keeps it topped up through curve25519_compute_public_batch, so the
+// fixed-base multiplication is off the request path. Every pair is handed
+// out once: the slot is wiped as it is taken, and the remaining pairs are
+// wiped when the pool stops. The pool is process-wide; while it is not
+// running, keypool_take simply generates a pair.
+typedef struct {
+    uint64_t hits;        // pairs served from the pool
+    uint64_t misses;      // pool empty (or stopped), generated inline
+    size_t available;     // pairs ready right now
+    size_t capacity;
+} keypool_stats_t;
+
+// Starts the refill thread with room for capacity pairs; refills start
+// when fewer than half remain and use nthreads threads (<= 0: one per
+// CPU). Returns 1 on success, 0 if the pool is running or on failure.
+int  keypool_start(size_t capacity, int nthreads);
+void keypool_stop(void);
+
+// Fills *pair; returns 1 for a pool hit, 0 if it was generated inline.
+// The caller wipes the pair after use.
+int  keypool_take(key_pair_t *pair);
+// Batch form for callers that generate their own pairs in one batch:
+// moves up to n pairs into the first slots of private_keys / public_keys
+// and returns how many; the rest count as misses, for the caller to fill.
+size_t keypool_take_batch(uint8_t (*private_keys)[FIELD_SIZE],
+                          uint8_t (*public_keys)[FIELD_SIZE], size_t n);
+void keypool_stats(keypool_stats_t *stats);
+
+#endif /* KEYPOOL_H */
@@ -0,0 +1,313 @@
+#define _POSIX_C_SOURCE 200809L
+#include "keyring.h"
+#include "byteorder.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct keyring {
+    uint8_t *map;
+    size_t map_len;
+    const keyring_entry_t *entries;
+    const uint8_t *index;
+    uint64_t count, slots;
+};
+
+// Smallest power of two that keeps n keys at most half the index
+static uint64_t index_slots(size_t n) {
+    uint64_t slots = 16;
+    while (slots < 2 * (uint64_t)n) slots *= 2;
+    return slots;
+}
+
+// Walks the probe sequence of key_id; with public_key set, an entry only
+// matches if the whole key does (two keys may share an id)
+static const keyring_entry_t *probe(const keyring_entry_t *entries, uint64_t count,
+                                    const uint8_t *index, uint64_t slots,
+                                    const uint8_t *key_id, const uint8_t *public_key) {
+    uint64_t s = get_u64(key_id) & (slots - 1);
+    for (uint64_t i = 0; i < slots; i++, s = (s + 1) & (slots - 1)) {
+        uint32_t v = get_u32(index + 4 * s);
+        if (v == 0) return NULL;
+        if (v > count) continue;
+        const keyring_entry_t *e = &entries[v - 1];
+        if (memcmp(e->key_id, key_id, ECC_KEY_ID_SIZE) == 0 &&
+            (!public_key || memcmp(e->public_key, public_key, FIELD_SIZE) == 0)) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+// ---------- reading ---------------------------------------------------------
+#ifdef _WIN32
+// No mmap here: the ring is read into memory once instead
+static uint8_t *map_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    uint8_t *buf = NULL;
+    long size = fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+    if (size >= 0 && fseek(f, 0, SEEK_SET) == 0 && (buf = malloc((size_t)size + 1)) != NULL &&
+        fread(buf, 1, (size_t)size, f) != (size_t)size) {
+        free(buf);
+        buf = NULL;
+        errno = EIO;
+    }
+    fclose(f);
+    *len = (size_t)size;
+    return buf;
+}
+
+static void unmap_file(uint8_t *map, size_t len) {
+    (void)len;
+    free(map);
+}
+#else
+static uint8_t *map_file(const char *path, size_t *len) {
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0) return NULL;
+    if (fstat(fd, &st) != 0 || st.st_size < KEYRING_HEADER_SIZE) {
+        close(fd);
+        errno = EINVAL;
+        return NULL;
+    }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+    *len = (size_t)st.st_size;
+    return map;
+}
+
+static void unmap_file(uint8_t *map, size_t len) {
+    munmap(map, len);
+}
+#endif
+
+keyring_t *keyring_open(const char *path) {
+    keyring_t *ring = calloc(1, sizeof *ring);
+    if (!ring) return NULL;
+    ring->map = map_file(path, &ring->map_len);
+    if (!ring->map) {
+        free(ring);
+        return NULL;
+    }
+
+    const uint8_t *h = ring->map;
+    int ok = ring->map_len >= KEYRING_HEADER_SIZE && memcmp(h, KEYRING_MAGIC, 4) == 0 &&
+             get_u32(h + 4) == KEYRING_VERSION;
+    if (ok) {
+        ring->count = get_u64(h + 8);
+        ring->slots = get_u64(h + 16);
+        // the size check also bounds count and slots, so nothing overflows
+        ok = ring->count <= KEYRING_MAX_KEYS && ring->slots <= 4 * (uint64_t)KEYRING_MAX_KEYS &&
+             ring->slots > ring->count && (ring->slots & (ring->slots - 1)) == 0 &&
+             ring->map_len == KEYRING_HEADER_SIZE + ring->count * sizeof(keyring_entry_t) + 4 * ring->slots;
+    }
+    if (!ok) {
+        keyring_close(ring);
+        errno = EINVAL;
+        return NULL;
+    }
+    ring->entries = (const keyring_entry_t *)(ring->map + KEYRING_HEADER_SIZE);
+    ring->index = ring->map + KEYRING_HEADER_SIZE + ring->count * sizeof(keyring_entry_t);
+    return ring;
+}
+
+void keyring_close(keyring_t *ring) {
+    if (!ring) return;
+    if (ring->map) unmap_file(ring->map, ring->map_len);
+    free(ring);
+}
+
+size_t keyring_count(const keyring_t *ring) {
+    return (size_t)ring->count;
+}
+
+const keyring_entry_t *keyring_entry(const keyring_t *ring, size_t i) {
+    return i < ring->count ? &ring->entries[i] : NULL;
+}
+
+const keyring_entry_t *keyring_find_id(const keyring_t *ring, const uint8_t *key_id) {
+    return probe(ring->entries, ring->count, ring->index, ring->slots, key_id, NULL);
+}
+
+const keyring_entry_t *keyring_find_key(const keyring_t *ring, const uint8_t *public_key) {
+    uint8_t id[ECC_KEY_ID_SIZE];
+    ecc_key_id(id, public_key);
+    return probe(ring->entries, ring->count, ring->index, ring->slots, id, public_key);
+}
+
+int keyring_parse_id(uint8_t *key_id, const char *hex) {
+    if (strlen(hex) != 2 * ECC_KEY_ID_SIZE) return 0;
+    for (int i = 0; i < 2 * ECC_KEY_ID_SIZE; i++) {
+        char c = hex[i];
+        int v = c >= '0' && c <= '9' ? c - '0'
+              : c >= 'a' && c <= 'f' ? c - 'a' + 10
+              : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+        if (v < 0) return 0;
+        if (i % 2 == 0) key_id[i / 2] = (uint8_t)(v << 4);
+        else key_id[i / 2] |= (uint8_t)v;
+    }
+    return 1;
+}
+
+// ---------- writing ---------------------------------------------------------
+void keyring_make_entry(keyring_entry_t *entry, const uint8_t *public_key, const char *label) {
+    ecc_key_id(entry->key_id, public_key);
+    memcpy(entry->public_key, public_key, FIELD_SIZE);
+    memset(entry->label, 0, KEYRING_LABEL_SIZE);
+    if (label) {
+        size_t len = strlen(label);
+        memcpy(entry->label, label, len < KEYRING_LABEL_SIZE ? len : KEYRING_LABEL_SIZE);
+    }
+}
+
+// Writers of one ring take turns under an flock on "<path>.lock"; the ring
+// itself is replaced by rename, so a lock on it would not outlive the
+// first writer. Returns the lock's fd, or -1 (errno set).
+static int lock_ring(const char *path) {
+#ifdef _WIN32
+    (void)path;
+    return 0;
+#else
+    size_t len = strlen(path) + sizeof ".lock";
+    char *name = malloc(len);
+    if (!name) return -1;
+    snprintf(name, len, "%s.lock", path);
+    int fd = open(name, O_RDWR | O_CREAT, 0600);
+    free(name);
+    if (fd < 0) return -1;
+    while (flock(fd, LOCK_EX) != 0) {
+        if (errno != EINTR) {
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+#endif
+}
+
+static void unlock_ring(int fd) {
+#ifndef _WIN32
+    close(fd);   // releases the flock
+#else
+    (void)fd;
+#endif
+}
+
+// Temporary file next to path for the new ring; unique, so concurrent
+// writers never share one
+static FILE *create_temp(const char *path, char **tmp) {
+    size_t len = strlen(path) + sizeof ".XXXXXX";
+    *tmp = malloc(len);
+    if (!*tmp) return NULL;
+#ifdef _WIN32
+    snprintf(*tmp, len, "%s.tmp", path);
+    return fopen(*tmp, "wb");
+#else
+    snprintf(*tmp, len, "%s.XXXXXX", path);
+    int fd = mkstemp(*tmp);
+    if (fd < 0) return NULL;
+    FILE *f = fchmod(fd, 0644) == 0 ? fdopen(fd, "wb") : NULL;
+    if (!f) {
+        close(fd);
+        remove(*tmp);
+    }
+    return f;
+#endif
+}
+
+static long write_ring(const char *path, const keyring_entry_t *entries, size_t n) {
+    if (n > KEYRING_MAX_KEYS) {
+        errno = EINVAL;
+        return -1;
+    }
+    uint64_t slots = index_slots(n);
+    size_t cap = KEYRING_HEADER_SIZE + n * sizeof(keyring_entry_t) + 4 * slots;
+    uint8_t *buf = calloc(1, cap);
+    if (!buf) return -1;
+
+    // Entries are copied in order and indexed as they go; the index is
+    // placed once the number left after dropping duplicates is known
+    keyring_entry_t *out = (keyring_entry_t *)(buf + KEYRING_HEADER_SIZE);
+    uint8_t *index = calloc(slots, 4);
+    if (!index) {
+        free(buf);
+        return -1;
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint8_t id[ECC_KEY_ID_SIZE];
+        ecc_key_id(id, entries[i].public_key);
+        if (probe(out, count, index, slots, id, entries[i].public_key)) continue;
+        out[count] = entries[i];
+        memcpy(out[count].key_id, id, ECC_KEY_ID_SIZE);
+        uint64_t s = get_u64(id) & (slots - 1);
+        while (get_u32(index + 4 * s) != 0) s = (s + 1) & (slots - 1);
+        put_u32(index + 4 * s, (uint32_t)(++count));
+    }
+    memcpy(buf + KEYRING_HEADER_SIZE + count * sizeof(keyring_entry_t), index, 4 * slots);
+    free(index);
+    size_t len = KEYRING_HEADER_SIZE + count * sizeof(keyring_entry_t) + 4 * slots;
+
+    memcpy(buf, KEYRING_MAGIC, 4);
+    put_u32(buf + 4, KEYRING_VERSION);
+    put_u64(buf + 8, count);
+    put_u64(buf + 16, slots);
+
+    char *tmp;
+    FILE *f = create_temp(path, &tmp);
+    int ok = f != NULL && fwrite(buf, 1, len, f) == len;
+    if (f && fclose(f) != 0) ok = 0;
+#ifdef _WIN32
+    if (ok) remove(path);
+#endif
+    if (ok && rename(tmp, path) != 0) ok = 0;
+    if (!ok && f) remove(tmp);
+    free(tmp);
+    free(buf);
+    return ok ? (long)count : -1;
+}
+
+long keyring_write(const char *path, const keyring_entry_t *entries, size_t n) {
+    int lock = lock_ring(path);
+    if (lock < 0) return -1;
+    long count = write_ring(path, entries, n);
+    unlock_ring(lock);
+    return count;
+}
+
+long keyring_append(const char *path, const keyring_entry_t *entries, size_t n) {
+    // The lock covers reading the old ring too, or a concurrent append
+    // could be dropped
+    int lock = lock_ring(path);
+    if (lock < 0) return -1;
+    long count = -1;
+    keyring_t *ring = keyring_open(path);
+    if (!ring) {
+        if (errno == ENOENT) count = write_ring(path, entries, n);
+        unlock_ring(lock);
+        return count;
+    }
+    size_t old = keyring_count(ring);
+    keyring_entry_t *all = malloc((old + n) * sizeof *all + 1);
+    if (all) {
+        memcpy(all, ring->entries, old * sizeof *all);
+        memcpy(all + old, entries, n * sizeof *all);
+        count = write_ring(path, all, old + n);
+        free(all);
+    }
+    keyring_close(ring);
+    unlock_ring(lock);
+    return count;
+}
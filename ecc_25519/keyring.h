@@ -0,0 +1,56 @@
+#ifndef KEYRING_H
+#define KEYRING_H
+
+#include "curve25519.h"
+
+// Keyring: many public keys in one file, mapped read-only, so loading
+// thousands of recipients costs one open and one mmap instead of a file
+// per key. Layout (integers little-endian):
+//   header   "SCKR" | u32 version | u64 count | u64 index slots | u64 reserved
+//   entries  count * (key id | public key | label), 64 bytes each
+//   index    slots * u32, open addressing with linear probing on the key
+//            id; 0 is empty, otherwise entry number + 1
+// The key id is ecc_key_id of the public key and already uniform, so its
+// first eight bytes are the hash. The index is kept at most half full.
+#define KEYRING_MAGIC       "SCKR"
+#define KEYRING_VERSION     1
+#define KEYRING_HEADER_SIZE 32
+#define KEYRING_LABEL_SIZE  24
+#define KEYRING_MAX_KEYS    (1u << 30)
+
+typedef struct {
+    uint8_t key_id[ECC_KEY_ID_SIZE];
+    uint8_t public_key[FIELD_SIZE];
+    char label[KEYRING_LABEL_SIZE];      // NUL-padded, not always terminated
+} keyring_entry_t;
+
+typedef struct keyring keyring_t;
+
+// Maps a keyring; NULL (errno set) if it cannot be opened or is malformed.
+// Entries point into the mapping and stay valid until keyring_close.
+keyring_t *keyring_open(const char *path);
+void keyring_close(keyring_t *ring);
+
+size_t keyring_count(const keyring_t *ring);
+const keyring_entry_t *keyring_entry(const keyring_t *ring, size_t i);
+
+// O(1) lookups; NULL if the key is not in the ring
+const keyring_entry_t *keyring_find_id(const keyring_t *ring, const uint8_t *key_id);
+const keyring_entry_t *keyring_find_key(const keyring_t *ring, const uint8_t *public_key);
+
+// Parses a key id written as 2 * ECC_KEY_ID_SIZE hex digits; 1 on success
+int keyring_parse_id(uint8_t *key_id, const char *hex);
+
+// Fills an entry for public_key; the label is truncated to fit
+void keyring_make_entry(keyring_entry_t *entry, const uint8_t *public_key, const char *label);
+
+// Writes entries (duplicates of an earlier key skipped) and a fresh index
+// to a temporary file renamed over path, so readers that have the old ring
+// mapped are not disturbed. keyring_append keeps the entries already in
+// path, if it exists. Writers of one ring are serialised by an flock on
+// "<path>.lock", so concurrent appends all land. Both return the number of keys in the new ring, or
+// -1 (errno set) on failure.
+long keyring_write(const char *path, const keyring_entry_t *entries, size_t n);
+long keyring_append(const char *path, const keyring_entry_t *entries, size_t n);
+
+#endif /* KEYRING_H */
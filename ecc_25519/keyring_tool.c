@@ -0,0 +1,128 @@
+#include "common.h"
+#include "keyring.h"
+#include <errno.h>
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s -c <ring> <key.pub> [<key.pub> ...]   create a keyring\n", prog);
+    fprintf(stderr, "       %s -a <ring> <key.pub> [<key.pub> ...]   append keys\n", prog);
+    fprintf(stderr, "       %s -l <ring>                            list keys\n", prog);
+    fprintf(stderr, "       %s -f <ring> <key id | key.pub>         look up one key\n", prog);
+    fprintf(stderr, "  A key file may hold several packed keys (keygen -n); each is labelled\n");
+    fprintf(stderr, "  with the file name, plus :<n> for packed keys\n");
+    exit(EXIT_FAILURE);
+}
+
+static void print_hex(const uint8_t *p, size_t len) {
+    for (size_t i = 0; i < len; i++) printf("%02x", p[i]);
+}
+
+static void print_entry(const keyring_entry_t *e) {
+    print_hex(e->key_id, ECC_KEY_ID_SIZE);
+    printf("  ");
+    print_hex(e->public_key, FIELD_SIZE);
+    printf("  %.*s\n", KEYRING_LABEL_SIZE, e->label);
+}
+
+// Label for key i of n in fname: the file name without directory or .pub
+static void key_label(char *label, size_t size, const char *fname, size_t i, size_t n) {
+    const char *base = strrchr(fname, '/');
+    base = base ? base + 1 : fname;
+    size_t len = strlen(base);
+    if (len > 4 && !strcmp(base + len - 4, ".pub")) len -= 4;
+    if (n > 1) snprintf(label, size, "%.*s:%zu", (int)len, base, i);
+    else snprintf(label, size, "%.*s", (int)len, base);
+}
+
+static int add_keys(const char *ring, char **files, int nfiles, int append) {
+    size_t n = 0, cap = 64;
+    keyring_entry_t *entries = malloc(cap * sizeof *entries);
+    if (!entries) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return EXIT_FAILURE;
+    }
+    for (int f = 0; f < nfiles; f++) {
+        size_t len;
+        uint8_t *keys = read_file(files[f], &len);
+        if (len == 0 || len % FIELD_SIZE) {
+            fprintf(stderr, "%s: not a public key file\n", files[f]);
+            return EXIT_FAILURE;
+        }
+        size_t count = len / FIELD_SIZE;
+        while (n + count > cap) cap *= 2;
+        entries = realloc(entries, cap * sizeof *entries);
+        if (!entries) {
+            fprintf(stderr, "Memory allocation failed\n");
+            return EXIT_FAILURE;
+        }
+        for (size_t i = 0; i < count; i++) {
+            char label[KEYRING_LABEL_SIZE + 1];
+            key_label(label, sizeof label, files[f], i, count);
+            keyring_make_entry(&entries[n++], keys + i * FIELD_SIZE, label);
+        }
+        free(keys);
+    }
+
+    long total = append ? keyring_append(ring, entries, n) : keyring_write(ring, entries, n);
+    free(entries);
+    if (total < 0) {
+        perror(ring);
+        return EXIT_FAILURE;
+    }
+    printf("%s: %ld keys\n", ring, total);
+    return EXIT_SUCCESS;
+}
+
+// A 16-digit hex string is a key id; anything else is a public key file
+static int find_key(const keyring_t *ring, const char *what) {
+    const keyring_entry_t *e;
+    uint8_t id[ECC_KEY_ID_SIZE];
+    if (keyring_parse_id(id, what)) {
+        e = keyring_find_id(ring, id);
+    } else {
+        size_t len;
+        uint8_t *key = read_file(what, &len);
+        if (len != FIELD_SIZE) {
+            fprintf(stderr, "%s: not a public key file\n", what);
+            return EXIT_FAILURE;
+        }
+        e = keyring_find_key(ring, key);
+        free(key);
+    }
+    if (!e) {
+        fprintf(stderr, "%s: not in keyring\n", what);
+        return EXIT_FAILURE;
+    }
+    print_entry(e);
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3 || argv[1][0] != '-' || strlen(argv[1]) != 2) {
+        usage(argv[0]);
+    }
+    char op = argv[1][1];
+    const char *ring_name = argv[2];
+
+    if ((op == 'c' || op == 'a') && argc > 3) {
+        return add_keys(ring_name, argv + 3, argc - 3, op == 'a');
+    }
+    if ((op != 'l' || argc != 3) && (op != 'f' || argc != 4)) {
+        usage(argv[0]);
+    }
+
+    keyring_t *ring = keyring_open(ring_name);
+    if (!ring) {
+        perror(ring_name);
+        return EXIT_FAILURE;
+    }
+    int status = EXIT_SUCCESS;
+    if (op == 'l') {
+        for (size_t i = 0; i < keyring_count(ring); i++) {
+            print_entry(keyring_entry(ring, i));
+        }
+    } else {
+        status = find_key(ring, argv[3]);
+    }
+    keyring_close(ring);
+    return status;
+}
@@ -0,0 +1,261 @@
+#include "poly1305.h"
+#include "sccrypto.h"
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define POLY_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+#define MASK26 0x3ffffff
+
+// Below this many bytes the four-way setup does not pay off
+#define POLY1305_AVX2_MIN 256
+
+static uint32_t load_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void store_le32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+// h = h * r mod 2^130 - 5, partially reduced: limbs end below 2^26 except
+// h1, which may carry a few extra bits. 2^130 = 5, so limb products that
+// wrap past h4 come back multiplied by 5.
+static void poly_mul(uint32_t h[5], const uint32_t r[5]) {
+    uint32_t s1 = r[1] * 5, s2 = r[2] * 5, s3 = r[3] * 5, s4 = r[4] * 5;
+    uint64_t d0, d1, d2, d3, d4, c;
+
+    d0 = (uint64_t)h[0] * r[0] + (uint64_t)h[1] * s4 + (uint64_t)h[2] * s3 + (uint64_t)h[3] * s2 + (uint64_t)h[4] * s1;
+    d1 = (uint64_t)h[0] * r[1] + (uint64_t)h[1] * r[0] + (uint64_t)h[2] * s4 + (uint64_t)h[3] * s3 + (uint64_t)h[4] * s2;
+    d2 = (uint64_t)h[0] * r[2] + (uint64_t)h[1] * r[1] + (uint64_t)h[2] * r[0] + (uint64_t)h[3] * s4 + (uint64_t)h[4] * s3;
+    d3 = (uint64_t)h[0] * r[3] + (uint64_t)h[1] * r[2] + (uint64_t)h[2] * r[1] + (uint64_t)h[3] * r[0] + (uint64_t)h[4] * s4;
+    d4 = (uint64_t)h[0] * r[4] + (uint64_t)h[1] * r[3] + (uint64_t)h[2] * r[2] + (uint64_t)h[3] * r[1] + (uint64_t)h[4] * r[0];
+
+    c = d0 >> 26; h[0] = (uint32_t)d0 & MASK26; d1 += c;
+    c = d1 >> 26; h[1] = (uint32_t)d1 & MASK26; d2 += c;
+    c = d2 >> 26; h[2] = (uint32_t)d2 & MASK26; d3 += c;
+    c = d3 >> 26; h[3] = (uint32_t)d3 & MASK26; d4 += c;
+    c = d4 >> 26; h[4] = (uint32_t)d4 & MASK26;
+    h[0] += (uint32_t)c * 5;
+    h[1] += h[0] >> 26;
+    h[0] &= MASK26;
+}
+
+// One 16-byte block; hibit is 2^128 as seen from limb 4, or 0 for the
+// padded final block
+static void poly_block(poly1305_ctx_t *ctx, const uint8_t *m, uint32_t hibit) {
+    ctx->h[0] += load_le32(m) & MASK26;
+    ctx->h[1] += (load_le32(m + 3) >> 2) & MASK26;
+    ctx->h[2] += (load_le32(m + 6) >> 4) & MASK26;
+    ctx->h[3] += (load_le32(m + 9) >> 6) & MASK26;
+    ctx->h[4] += (load_le32(m + 12) >> 8) | hibit;
+    poly_mul(ctx->h, ctx->r[0]);
+}
+
+#ifdef POLY_HAVE_AVX2
+// poly_mul for four lanes at once; s = 5 r
+__attribute__((target("avx2")))
+static inline void poly_mul4(__m256i h[5], const __m256i r[5], const __m256i s[5]) {
+    const __m256i mask = _mm256_set1_epi64x(MASK26);
+    __m256i d0, d1, d2, d3, d4, c;
+#define M(a, b) _mm256_mul_epu32(a, b)
+#define A(a, b) _mm256_add_epi64(a, b)
+    d0 = A(A(A(A(M(h[0], r[0]), M(h[1], s[4])), M(h[2], s[3])), M(h[3], s[2])), M(h[4], s[1]));
+    d1 = A(A(A(A(M(h[0], r[1]), M(h[1], r[0])), M(h[2], s[4])), M(h[3], s[3])), M(h[4], s[2]));
+    d2 = A(A(A(A(M(h[0], r[2]), M(h[1], r[1])), M(h[2], r[0])), M(h[3], s[4])), M(h[4], s[3]));
+    d3 = A(A(A(A(M(h[0], r[3]), M(h[1], r[2])), M(h[2], r[1])), M(h[3], r[0])), M(h[4], s[4]));
+    d4 = A(A(A(A(M(h[0], r[4]), M(h[1], r[3])), M(h[2], r[2])), M(h[3], r[1])), M(h[4], r[0]));
+#undef M
+    c = _mm256_srli_epi64(d0, 26); d0 = _mm256_and_si256(d0, mask); d1 = A(d1, c);
+    c = _mm256_srli_epi64(d1, 26); d1 = _mm256_and_si256(d1, mask); d2 = A(d2, c);
+    c = _mm256_srli_epi64(d2, 26); d2 = _mm256_and_si256(d2, mask); d3 = A(d3, c);
+    c = _mm256_srli_epi64(d3, 26); d3 = _mm256_and_si256(d3, mask); d4 = A(d4, c);
+    c = _mm256_srli_epi64(d4, 26); d4 = _mm256_and_si256(d4, mask);
+    d0 = A(d0, A(_mm256_slli_epi64(c, 2), c));
+    c = _mm256_srli_epi64(d0, 26); d0 = _mm256_and_si256(d0, mask); d1 = A(d1, c);
+#undef A
+    h[0] = d0; h[1] = d1; h[2] = d2; h[3] = d3; h[4] = d4;
+}
+
+// Four interleaved accumulators, lane j taking blocks j, j + 4, j + 8, ...
+// Each step multiplies all lanes by r^4 and adds the next four blocks; at
+// the end lane j is multiplied by r^(4-j) and the lanes are summed, which
+// gives the same polynomial as the serial Horner evaluation. The running
+// accumulator enters through lane 0. nblocks is a multiple of 4.
+__attribute__((target("avx2")))
+static void poly_blocks_avx2(poly1305_ctx_t *ctx, const uint8_t *m, size_t nblocks) {
+    const __m256i mask = _mm256_set1_epi64x(MASK26);
+    const __m256i hibit = _mm256_set1_epi64x(1 << 24);
+    __m256i r[5], s[5], h[5], t[5];
+
+#define POLY_LOAD(p, l)                                                                  \
+    do {                                                                                 \
+        __m256i a = _mm256_loadu_si256((const __m256i *)(p));                            \
+        __m256i b = _mm256_loadu_si256((const __m256i *)((p) + 32));                     \
+        __m256i lo = _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a, b), _MM_SHUFFLE(3, 1, 2, 0)); \
+        __m256i hi = _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(a, b), _MM_SHUFFLE(3, 1, 2, 0)); \
+        l[0] = _mm256_and_si256(lo, mask);                                               \
+        l[1] = _mm256_and_si256(_mm256_srli_epi64(lo, 26), mask);                        \
+        l[2] = _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(lo, 52),               \
+                                                _mm256_slli_epi64(hi, 12)), mask);       \
+        l[3] = _mm256_and_si256(_mm256_srli_epi64(hi, 14), mask);                        \
+        l[4] = _mm256_or_si256(_mm256_srli_epi64(hi, 40), hibit);                        \
+    } while (0)
+
+    for (int i = 0; i < 5; i++) {
+        r[i] = _mm256_set1_epi64x(ctx->r[3][i]);
+        s[i] = _mm256_set1_epi64x(ctx->r[3][i] * 5);
+    }
+    POLY_LOAD(m, h);
+    for (int i = 0; i < 5; i++) {
+        h[i] = _mm256_add_epi64(h[i], _mm256_set_epi64x(0, 0, 0, ctx->h[i]));
+    }
+    for (size_t k = 4; k < nblocks; k += 4) {
+        m += 64;
+        poly_mul4(h, r, s);
+        POLY_LOAD(m, t);
+        for (int i = 0; i < 5; i++) h[i] = _mm256_add_epi64(h[i], t[i]);
+    }
+
+    // lane j times r^(4-j)
+    for (int i = 0; i < 5; i++) {
+        r[i] = _mm256_set_epi64x(ctx->r[0][i], ctx->r[1][i], ctx->r[2][i], ctx->r[3][i]);
+        s[i] = _mm256_set_epi64x(ctx->r[0][i] * 5, ctx->r[1][i] * 5, ctx->r[2][i] * 5, ctx->r[3][i] * 5);
+    }
+    poly_mul4(h, r, s);
+#undef POLY_LOAD
+
+    uint64_t lane[4], sum[5];
+    for (int i = 0; i < 5; i++) {
+        _mm256_storeu_si256((__m256i *)lane, h[i]);
+        sum[i] = lane[0] + lane[1] + lane[2] + lane[3];
+    }
+    uint64_t c;
+    c = sum[0] >> 26; sum[0] &= MASK26; sum[1] += c;
+    c = sum[1] >> 26; sum[1] &= MASK26; sum[2] += c;
+    c = sum[2] >> 26; sum[2] &= MASK26; sum[3] += c;
+    c = sum[3] >> 26; sum[3] &= MASK26; sum[4] += c;
+    c = sum[4] >> 26; sum[4] &= MASK26; sum[0] += c * 5;
+    c = sum[0] >> 26; sum[0] &= MASK26; sum[1] += c;
+    for (int i = 0; i < 5; i++) ctx->h[i] = (uint32_t)sum[i];
+}
+#endif
+
+// Set by poly1305_set_default_backend("scalar")
+static int poly1305_force_scalar;
+
+int poly1305_set_default_backend(const char *name) {
+    if (!name || !strcmp(name, "avx2")) {
+#ifdef POLY_HAVE_AVX2
+        if (name && !__builtin_cpu_supports("avx2")) return -1;
+#else
+        if (name) return -1;
+#endif
+        poly1305_force_scalar = 0;
+        return 0;
+    }
+    if (!strcmp(name, "scalar")) {
+        poly1305_force_scalar = 1;
+        return 0;
+    }
+    return -1;
+}
+
+void poly1305_init(poly1305_ctx_t *ctx, const uint8_t *key) {
+    sccrypto_init();
+    // clamp r
+    ctx->r[0][0] = load_le32(key) & 0x3ffffff;
+    ctx->r[0][1] = (load_le32(key + 3) >> 2) & 0x3ffff03;
+    ctx->r[0][2] = (load_le32(key + 6) >> 4) & 0x3ffc0ff;
+    ctx->r[0][3] = (load_le32(key + 9) >> 6) & 0x3f03fff;
+    ctx->r[0][4] = (load_le32(key + 12) >> 8) & 0x00fffff;
+    for (int i = 0; i < 4; i++) ctx->pad[i] = load_le32(key + 16 + 4 * i);
+    memset(ctx->h, 0, sizeof ctx->h);
+    ctx->buf_len = 0;
+
+    ctx->use_avx2 = 0;
+#ifdef POLY_HAVE_AVX2
+    ctx->use_avx2 = !poly1305_force_scalar && __builtin_cpu_supports("avx2");
+#endif
+    if (ctx->use_avx2) {
+        for (int k = 1; k < 4; k++) {
+            memcpy(ctx->r[k], ctx->r[k - 1], sizeof ctx->r[k]);
+            poly_mul(ctx->r[k], ctx->r[0]);
+        }
+    }
+}
+
+void poly1305_update(poly1305_ctx_t *ctx, const uint8_t *m, size_t len) {
+    if (ctx->buf_len) {
+        size_t n = 16 - ctx->buf_len < len ? 16 - ctx->buf_len : len;
+        memcpy(ctx->buf + ctx->buf_len, m, n);
+        ctx->buf_len += n;
+        m += n;
+        len -= n;
+        if (ctx->buf_len < 16) return;
+        poly_block(ctx, ctx->buf, 1 << 24);
+        ctx->buf_len = 0;
+    }
+#ifdef POLY_HAVE_AVX2
+    if (ctx->use_avx2 && len >= POLY1305_AVX2_MIN) {
+        size_t n = len / 64 * 4;
+        poly_blocks_avx2(ctx, m, n);
+        m += n * 16;
+        len -= n * 16;
+    }
+#endif
+    for (; len >= 16; m += 16, len -= 16) {
+        poly_block(ctx, m, 1 << 24);
+    }
+    memcpy(ctx->buf, m, len);
+    ctx->buf_len = len;
+}
+
+void poly1305_final(poly1305_ctx_t *ctx, uint8_t *tag) {
+    uint32_t h0, h1, h2, h3, h4, g0, g1, g2, g3, g4, c, mask;
+    uint64_t f;
+
+    if (ctx->buf_len) {
+        ctx->buf[ctx->buf_len] = 1;
+        memset(ctx->buf + ctx->buf_len + 1, 0, 16 - ctx->buf_len - 1);
+        poly_block(ctx, ctx->buf, 0);
+    }
+
+    // fully carry h
+    h0 = ctx->h[0]; h1 = ctx->h[1]; h2 = ctx->h[2]; h3 = ctx->h[3]; h4 = ctx->h[4];
+    c = h1 >> 26; h1 &= MASK26; h2 += c;
+    c = h2 >> 26; h2 &= MASK26; h3 += c;
+    c = h3 >> 26; h3 &= MASK26; h4 += c;
+    c = h4 >> 26; h4 &= MASK26; h0 += c * 5;
+    c = h0 >> 26; h0 &= MASK26; h1 += c;
+
+    // g = h + 5 - 2^130; use g if it did not go negative, i.e. h >= p
+    g0 = h0 + 5; c = g0 >> 26; g0 &= MASK26;
+    g1 = h1 + c; c = g1 >> 26; g1 &= MASK26;
+    g2 = h2 + c; c = g2 >> 26; g2 &= MASK26;
+    g3 = h3 + c; c = g3 >> 26; g3 &= MASK26;
+    g4 = h4 + c - (1u << 26);
+    mask = (g4 >> 31) - 1;
+    h0 = (h0 & ~mask) | (g0 & mask);
+    h1 = (h1 & ~mask) | (g1 & mask);
+    h2 = (h2 & ~mask) | (g2 & mask);
+    h3 = (h3 & ~mask) | (g3 & mask);
+    h4 = (h4 & ~mask) | (g4 & mask);
+
+    // h mod 2^128, plus pad
+    h0 = (h0 | (h1 << 26)) & 0xffffffff;
+    h1 = ((h1 >> 6) | (h2 << 20)) & 0xffffffff;
+    h2 = ((h2 >> 12) | (h3 << 14)) & 0xffffffff;
+    h3 = ((h3 >> 18) | (h4 << 8)) & 0xffffffff;
+    f = (uint64_t)h0 + ctx->pad[0];             store_le32(tag, (uint32_t)f);
+    f = (uint64_t)h1 + ctx->pad[1] + (f >> 32); store_le32(tag + 4, (uint32_t)f);
+    f = (uint64_t)h2 + ctx->pad[2] + (f >> 32); store_le32(tag + 8, (uint32_t)f);
+    f = (uint64_t)h3 + ctx->pad[3] + (f >> 32); store_le32(tag + 12, (uint32_t)f);
+
+    memset(ctx, 0, sizeof *ctx);
+}
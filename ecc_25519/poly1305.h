@@ -0,0 +1,30 @@
+#ifndef POLY1305_H
+#define POLY1305_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Poly1305 one-time authenticator (RFC 8439). The accumulator uses five
+// 26-bit limbs; on AVX2 CPUs long inputs are hashed four blocks at a time
+// with the powers r^1..r^4 kept in the context.
+#define POLY1305_KEY_SIZE 32
+#define POLY1305_TAG_SIZE 16
+
+typedef struct {
+    uint32_t r[4][5];      // r^1 .. r^4
+    uint32_t h[5];
+    uint32_t pad[4];
+    uint8_t buf[16];
+    size_t buf_len;
+    int use_avx2;
+} poly1305_ctx_t;
+
+// "scalar" keeps later inits off the four-way path, "avx2" or NULL
+// restores it; -1 if unknown or not supported by this CPU
+int  poly1305_set_default_backend(const char *name);
+void poly1305_init(poly1305_ctx_t *ctx, const uint8_t *key);
+void poly1305_update(poly1305_ctx_t *ctx, const uint8_t *m, size_t len);
+// Writes the tag and wipes the context
+void poly1305_final(poly1305_ctx_t *ctx, uint8_t *tag);
+
+#endif /* POLY1305_H */
@@ -0,0 +1,31 @@
+#ifndef SHA512_H
+#define SHA512_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// SHA-512 (FIPS 180-4), HMAC-SHA512 (RFC 2104) and HKDF-SHA512 (RFC 5869),
+// used to derive symmetric keys from X25519 shared secrets
+#define SHA512_DIGEST_SIZE 64
+#define SHA512_BLOCK_SIZE  128
+
+typedef struct {
+    uint64_t h[8];
+    uint64_t total;                  // bytes hashed so far
+    uint8_t buf[SHA512_BLOCK_SIZE];
+    size_t buf_len;
+} sha512_ctx_t;
+
+void sha512_init(sha512_ctx_t *ctx);
+void sha512_update(sha512_ctx_t *ctx, const uint8_t *data, size_t len);
+void sha512_final(sha512_ctx_t *ctx, uint8_t *digest);
+void sha512(uint8_t *digest, const uint8_t *data, size_t len);
+
+void hmac_sha512(uint8_t *mac, const uint8_t *key, size_t key_len,
+                 const uint8_t *data, size_t len);
+
+// okm_len <= 255 * SHA512_DIGEST_SIZE
+void hkdf_sha512(uint8_t *okm, size_t okm_len, const uint8_t *salt, size_t salt_len,
+                 const uint8_t *ikm, size_t ikm_len, const uint8_t *info, size_t info_len);
+
+#endif /* SHA512_H */
@@ -0,0 +1,228 @@
+#include "x25519_avx2.h"
+#include <string.h>
+
+// Set by x25519_set_default_backend("scalar")
+static int x25519_force_scalar;
+
+int x25519_set_default_backend(const char *name) {
+    if (!name || !strcmp(name, "avx2")) {
+        int was = x25519_force_scalar;
+        x25519_force_scalar = 0;
+        if (name && !x25519_avx2_available()) {
+            x25519_force_scalar = was;
+            return -1;
+        }
+        return 0;
+    }
+    if (!strcmp(name, "scalar")) {
+        x25519_force_scalar = 1;
+        return 0;
+    }
+    return -1;
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+
+#define AVX2 __attribute__((target("avx2")))
+
+typedef __m256i fe4[10];
+
+#define MASK26 ((1u << 26) - 1)
+#define MASK25 ((1u << 25) - 1)
+
+int x25519_avx2_available(void) {
+    return !x25519_force_scalar && __builtin_cpu_supports("avx2");
+}
+
+// One carry pass, interleaved as two chains for latency. Every limb ends
+// below its width except limb 1, which may exceed 2^25 by a small amount.
+static inline AVX2 void fe4_carry(fe4 h) {
+    const __m256i m26 = _mm256_set1_epi64x(MASK26), m25 = _mm256_set1_epi64x(MASK25);
+    __m256i c;
+#define CARRY(i, bits, mask)                        \
+    c = _mm256_srli_epi64(h[i], bits);              \
+    h[i] = _mm256_and_si256(h[i], mask);            \
+    h[(i) + 1] = _mm256_add_epi64(h[(i) + 1], c);
+    CARRY(0, 26, m26) CARRY(4, 26, m26)
+    CARRY(1, 25, m25) CARRY(5, 25, m25)
+    CARRY(2, 26, m26) CARRY(6, 26, m26)
+    CARRY(3, 25, m25) CARRY(7, 25, m25)
+    CARRY(4, 26, m26) CARRY(8, 26, m26)
+#undef CARRY
+    // 2^255 = 19: fold the top carry back as 19c = 16c + 2c + c
+    c = _mm256_srli_epi64(h[9], 25);
+    h[9] = _mm256_and_si256(h[9], m25);
+    h[0] = _mm256_add_epi64(h[0], _mm256_add_epi64(_mm256_add_epi64(
+               _mm256_slli_epi64(c, 4), _mm256_slli_epi64(c, 1)), c));
+    c = _mm256_srli_epi64(h[0], 26);
+    h[0] = _mm256_and_si256(h[0], m26);
+    h[1] = _mm256_add_epi64(h[1], c);
+}
+
+static inline AVX2 void fe4_add(fe4 h, const fe4 f, const fe4 g) {
+    for (int i = 0; i < 10; i++) h[i] = _mm256_add_epi64(f[i], g[i]);
+}
+
+// f + 4p - g, then carried
+static inline AVX2 void fe4_sub(fe4 h, const fe4 f, const fe4 g) {
+    const __m256i p0 = _mm256_set1_epi64x(4 * (MASK26 - 18));
+    const __m256i pe = _mm256_set1_epi64x(4 * MASK26), po = _mm256_set1_epi64x(4 * MASK25);
+    h[0] = _mm256_sub_epi64(_mm256_add_epi64(f[0], p0), g[0]);
+    for (int i = 1; i < 10; i++)
+        h[i] = _mm256_sub_epi64(_mm256_add_epi64(f[i], (i & 1) ? po : pe), g[i]);
+    fe4_carry(h);
+}
+
+static inline AVX2 void fe4_cswap(fe4 f, fe4 g, __m256i mask) {
+    for (int i = 0; i < 10; i++) {
+        __m256i t = _mm256_and_si256(mask, _mm256_xor_si256(f[i], g[i]));
+        f[i] = _mm256_xor_si256(f[i], t);
+        g[i] = _mm256_xor_si256(g[i], t);
+    }
+}
+
+static inline AVX2 __m256i mul19(__m256i x) {
+    return _mm256_add_epi64(_mm256_add_epi64(_mm256_slli_epi64(x, 4), _mm256_slli_epi64(x, 1)), x);
+}
+
+// h = f * g. Term f_i g_j lands in column i + j, wrapping past 9 with a
+// factor 19; when i and j are both odd the 2^0.5 offsets add up to one
+// extra bit, so the term is doubled. The 2s go on f and the 19s on g so
+// both factors stay below 2^32 for inputs up to 2^27.
+static AVX2 void fe4_mul(fe4 h, const fe4 f, const fe4 g) {
+    __m256i f2[10], g19[10], t[10];
+    for (int i = 0; i < 10; i++) {
+        f2[i] = _mm256_add_epi64(f[i], f[i]);
+        g19[i] = mul19(g[i]);
+        t[i] = _mm256_setzero_si256();
+    }
+#pragma GCC unroll 10
+    for (int i = 0; i < 10; i++) {
+#pragma GCC unroll 10
+        for (int j = 0; j < 10; j++) {
+            __m256i a = (i & j & 1) ? f2[i] : f[i];
+            __m256i b = (i + j >= 10) ? g19[j] : g[j];
+            int k = (i + j) % 10;
+            t[k] = _mm256_add_epi64(t[k], _mm256_mul_epu32(a, b));
+        }
+    }
+    for (int i = 0; i < 10; i++) h[i] = t[i];
+    fe4_carry(h);
+}
+
+// h = f^2: the cross terms f_i f_j (i < j) appear twice, so only 55
+// products are needed
+static AVX2 void fe4_sq(fe4 h, const fe4 f) {
+    __m256i f2[10], f4[10], f19[10], t[10];
+    for (int i = 0; i < 10; i++) {
+        f2[i] = _mm256_add_epi64(f[i], f[i]);
+        f4[i] = _mm256_add_epi64(f2[i], f2[i]);
+        f19[i] = mul19(f[i]);
+        t[i] = _mm256_setzero_si256();
+    }
+#pragma GCC unroll 10
+    for (int i = 0; i < 10; i++) {
+#pragma GCC unroll 10
+        for (int j = i; j < 10; j++) {
+            int twos = (i != j) + (i & j & 1);
+            __m256i a = twos == 2 ? f4[i] : twos == 1 ? f2[i] : f[i];
+            __m256i b = (i + j >= 10) ? f19[j] : f[j];
+            int k = (i + j) % 10;
+            t[k] = _mm256_add_epi64(t[k], _mm256_mul_epu32(a, b));
+        }
+    }
+    for (int i = 0; i < 10; i++) h[i] = t[i];
+    fe4_carry(h);
+}
+
+static inline AVX2 void fe4_mul121665(fe4 h, const fe4 f) {
+    const __m256i k = _mm256_set1_epi64x(121665);
+    for (int i = 0; i < 10; i++) h[i] = _mm256_mul_epu32(f[i], k);
+    fe4_carry(h);
+}
+
+// Lane l of h from the radix-2^51 limbs of a[l] (each below 2^51)
+static AVX2 void fe4_from_gf(fe4 h, const gf a[4]) {
+    for (int k = 0; k < 5; k++) {
+        h[2 * k] = _mm256_set_epi64x((long long)(a[3][k] & MASK26), (long long)(a[2][k] & MASK26),
+                                     (long long)(a[1][k] & MASK26), (long long)(a[0][k] & MASK26));
+        h[2 * k + 1] = _mm256_set_epi64x((long long)(a[3][k] >> 26), (long long)(a[2][k] >> 26),
+                                         (long long)(a[1][k] >> 26), (long long)(a[0][k] >> 26));
+    }
+}
+
+// Limbs 2k and 2k+1 recombine into radix-2^51 limb k
+static AVX2 void fe4_to_gf(gf a[4], const fe4 h) {
+    uint64_t lo[4], hi[4];
+    for (int k = 0; k < 5; k++) {
+        _mm256_storeu_si256((__m256i *)lo, h[2 * k]);
+        _mm256_storeu_si256((__m256i *)hi, h[2 * k + 1]);
+        for (int l = 0; l < 4; l++) a[l][k] = lo[l] + (hi[l] << 26);
+    }
+}
+
+// Same ladder and operation order as x25519_ladder in curve25519.c, with
+// a per-lane swap mask built from each lane's scalar bit
+AVX2 void x25519_ladder4(gf x2[4], gf z2[4], const uint8_t *const n[4], const uint8_t *const p[4]) {
+    uint8_t z[4][32];
+    gf u[4];
+    fe4 x, a, b, c, d, e, f;
+
+    for (int l = 0; l < 4; l++) {
+        memcpy(z[l], n[l], 32);
+        z[l][31] = (n[l][31] & 127) | 64;
+        z[l][0] &= 248;
+        field_unpack(u[l], p[l]);
+    }
+    fe4_from_gf(x, (const gf *)u);
+    for (int i = 0; i < 10; i++) {
+        b[i] = x[i];
+        a[i] = c[i] = d[i] = _mm256_setzero_si256();
+    }
+    a[0] = d[0] = _mm256_set1_epi64x(1);
+
+    for (int i = 254; i >= 0; --i) {
+        __m256i r = _mm256_set_epi64x(-(long long)((z[3][i >> 3] >> (i & 7)) & 1),
+                                      -(long long)((z[2][i >> 3] >> (i & 7)) & 1),
+                                      -(long long)((z[1][i >> 3] >> (i & 7)) & 1),
+                                      -(long long)((z[0][i >> 3] >> (i & 7)) & 1));
+        fe4_cswap(a, b, r);
+        fe4_cswap(c, d, r);
+        fe4_add(e, a, c);
+        fe4_sub(a, a, c);
+        fe4_add(c, b, d);
+        fe4_sub(b, b, d);
+        fe4_sq(d, e);
+        fe4_sq(f, a);
+        fe4_mul(a, c, a);
+        fe4_mul(c, b, e);
+        fe4_add(e, a, c);
+        fe4_sub(a, a, c);
+        fe4_sq(b, a);
+        fe4_sub(c, d, f);
+        fe4_mul121665(a, c);
+        fe4_add(a, a, d);
+        fe4_mul(c, c, a);
+        fe4_mul(a, d, f);
+        fe4_mul(d, b, x);
+        fe4_sq(b, e);
+        fe4_cswap(a, b, r);
+        fe4_cswap(c, d, r);
+    }
+    fe4_to_gf(x2, a);
+    fe4_to_gf(z2, c);
+    memset(z, 0, sizeof z);
+}
+
+#else
+
+int x25519_avx2_available(void) {
+    return 0;
+}
+
+void x25519_ladder4(gf x2[4], gf z2[4], const uint8_t *const n[4], const uint8_t *const p[4]) {
+    (void)x2; (void)z2; (void)n; (void)p;
+}
+
+#endif
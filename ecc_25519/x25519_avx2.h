@@ -0,0 +1,18 @@
+#ifndef X25519_AVX2_H
+#define X25519_AVX2_H
+
+#include "field25519.h"
+
+// Four independent X25519 ladders at once, one per 64-bit AVX2 lane.
+// Field elements use ten limbs in radix 2^25.5 (26/25 bits alternating) so
+// every limb product fits _mm256_mul_epu32. Results are returned in
+// projective form x2/z2 like the scalar ladder, ready for a shared
+// inversion. x25519_avx2_available() tells whether the CPU supports it
+// and x25519_set_default_backend has not switched it off: "scalar" makes
+// the batch code use the one-at-a-time ladder, "avx2" or NULL restores
+// it (-1 if unknown or not supported by this CPU).
+int  x25519_avx2_available(void);
+int  x25519_set_default_backend(const char *name);
+void x25519_ladder4(gf x2[4], gf z2[4], const uint8_t *const n[4], const uint8_t *const p[4]);
+
+#endif /* X25519_AVX2_H */
@@ -0,0 +1,298 @@
+#define _POSIX_C_SOURCE 200809L
+#include "bench.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+double bench_now_ns(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER t;
+    if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&t);
+    return (double)t.QuadPart * 1e9 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+#endif
+}
+
+uint64_t bench_cycles(void) {
+#ifdef HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+int bench_has_cycles(void) {
+#ifdef HAVE_TSC
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+int bench_cpu_count(void) {
+#ifdef _SC_NPROCESSORS_ONLN
+    return (int)sysconf(_SC_NPROCESSORS_ONLN);
+#else
+    return 1;
+#endif
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted v[0..n)
+static double percentile(const double *v, int n, double p) {
+    int k = (int)(p * n + 0.999999) - 1;
+    return v[k < 0 ? 0 : k >= n ? n - 1 : k];
+}
+
+static void put_number(FILE *f, const char *fmt, double v, const char *none) {
+    if (v >= 0) fprintf(f, fmt, v);
+    else fputs(none, f);
+}
+
+// Hardware events reported per result, in table / CSV column order
+static const int hw_events[] = {
+    PERF_CYCLES, PERF_INSTRUCTIONS, PERF_L1D_MISSES, PERF_LLC_MISSES, PERF_BRANCH_MISSES
+};
+#define N_HW_EVENTS (int)(sizeof hw_events / sizeof *hw_events)
+
+// Per-operation count of an event, < 0 if it was not counted
+static double counter(const bench_result_t *r, int event) {
+    return r->counters.valid[event] ? r->counters.value[event] : -1;
+}
+
+static double ipc(const bench_result_t *r) {
+    double c = counter(r, PERF_CYCLES), i = counter(r, PERF_INSTRUCTIONS);
+    return c > 0 && i >= 0 ? i / c : -1;
+}
+
+void bench_init(bench_t *b, const char *suite, FILE *table, FILE *json, FILE *csv) {
+    memset(b, 0, sizeof *b);
+    b->suite = suite;
+    b->samples = BENCH_SAMPLES;
+    b->min_sample_ns = BENCH_MIN_SAMPLE_NS;
+    b->table = table;
+    b->json = json;
+    b->csv = csv;
+    b->latency = 1;
+    perf_group_open(&b->perf);
+    if (table) {
+        if (!b->perf.hardware) fprintf(table, "# hardware counters: %s\n", perf_unavailable());
+        fprintf(table, "%-24s %-7s %3s %10s %11s %11s %11s %11s %9s %8s", "benchmark", "backend",
+                "thr", "bytes", "ns/op", "lat p50", "lat p99", "cycles/op", "cycles/B", "GB/s");
+        if (b->perf.hardware)
+            fprintf(table, " %5s %9s %9s %9s", "IPC", "L1Dm/op", "LLCm/op", "brm/op");
+        fputc('\n', table);
+    }
+    if (json) {
+        fprintf(json, "{\n  \"suite\": \"%s\",\n  \"host\": {\"cpus\": %d, \"cycle_counter\": %s, "
+                "\"compiler\": \"%s\", \"perf_counters\": [", suite, bench_cpu_count(),
+                bench_has_cycles() ? "\"tsc\"" : "null", __VERSION__);
+        for (int e = 0, first = 1; e < PERF_NEVENTS; e++) {
+            if (b->perf.fd[e] < 0) continue;
+            fprintf(json, "%s\"%s\"", first ? "" : ", ", perf_event_name(e));
+            first = 0;
+        }
+        fputc(']', json);
+        if (!b->perf.hardware) fprintf(json, ", \"perf_unavailable\": \"%s\"", perf_unavailable());
+        fprintf(json, "},\n  \"results\": [");
+    }
+    if (csv) {
+        fprintf(csv, "suite,name,backend,threads,bytes,iters,samples,ns_per_op,ns_min,"
+                "lat_p50_ns,lat_p99_ns,cycles_per_op,cycles_per_byte,gb_per_s,"
+                "core_cycles_per_op,instructions_per_op,l1d_misses_per_op,llc_misses_per_op,"
+                "branch_misses_per_op,ipc\n");
+    }
+}
+
+// Median cost of the timer reads around a call, subtracted from every
+// single-call time
+static double timer_overhead(int tsc) {
+    double t[101];
+    for (int i = 0; i < 101; i++) {
+        if (tsc) {
+            uint64_t c0 = bench_cycles();
+            t[i] = (double)(bench_cycles() - c0);
+        } else {
+            double t0 = bench_now_ns();
+            t[i] = bench_now_ns() - t0;
+        }
+    }
+    qsort(t, 101, sizeof *t, cmp_double);
+    return t[50];
+}
+
+// Single-call latencies for fast operations. Calls are timed with the
+// cycle counter when there is one (clock reads cost about as much as the
+// shortest calls) and converted at the rate seen over the samples.
+static void measure_latency(bench_t *b, bench_fn_t fn, void *ctx, bench_result_t *r) {
+    double budget = b->samples * b->min_sample_ns;
+    int n = budget / r->ns_p50 < BENCH_LATENCY_CALLS ? (int)(budget / r->ns_p50)
+                                                     : BENCH_LATENCY_CALLS;
+    if (n < b->samples) n = b->samples;
+    double *lat = malloc(n * sizeof *lat);
+    if (!lat) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    int tsc = r->cycles_p50 > 0;
+    double ns_per_cycle = tsc ? r->ns_p50 / r->cycles_p50 : 0, overhead = timer_overhead(tsc);
+    for (int i = 0; i < n; i++) {
+        double t;
+        if (tsc) {
+            uint64_t c0 = bench_cycles();
+            fn(ctx, 1);
+            t = (double)(bench_cycles() - c0);
+        } else {
+            double t0 = bench_now_ns();
+            fn(ctx, 1);
+            t = bench_now_ns() - t0;
+        }
+        t = t > overhead ? t - overhead : 0;
+        lat[i] = tsc ? t * ns_per_cycle : t;
+    }
+    qsort(lat, n, sizeof *lat, cmp_double);
+    r->lat_p50 = percentile(lat, n, 0.5);
+    r->lat_p99 = percentile(lat, n, 0.99);
+    free(lat);
+}
+
+int bench_run(bench_t *b, const char *name, size_t bytes, bench_fn_t fn, void *ctx,
+              bench_result_t *r) {
+    if (b->filter && !strstr(name, b->filter)) return 0;
+
+    // Calibrate: grow the count until a sample is long enough to time
+    size_t iters = 1;
+    for (;;) {
+        double t0 = bench_now_ns();
+        fn(ctx, iters);
+        double t = bench_now_ns() - t0;
+        if (t >= b->min_sample_ns || iters >= ((size_t)1 << 30)) break;
+        double scale = t > 0 ? b->min_sample_ns / t * 1.2 : 100;
+        iters = (size_t)((double)iters * (scale > 100 ? 100 : scale < 2 ? 2 : scale));
+    }
+    if (iters > 1) fn(ctx, iters);
+
+    int n = b->samples > 0 ? b->samples : 1;
+    double ops = (double)iters * (b->ops_per_call > 1 ? b->ops_per_call : 1);
+    double *ns = malloc(2 * n * sizeof *ns), *cyc = ns + n;
+    if (!ns) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(EXIT_FAILURE);
+    }
+    perf_counts_t before, after;
+    perf_group_read(&b->perf, &before);
+    for (int i = 0; i < n; i++) {
+        double t0 = bench_now_ns();
+        uint64_t c0 = bench_cycles();
+        fn(ctx, iters);
+        uint64_t c1 = bench_cycles();
+        ns[i] = (bench_now_ns() - t0) / ops;
+        cyc[i] = (double)(c1 - c0) / ops;
+    }
+    perf_group_read(&b->perf, &after);
+    qsort(ns, n, sizeof *ns, cmp_double);
+    qsort(cyc, n, sizeof *cyc, cmp_double);
+
+    bench_result_t res = { name, bytes, iters, n, percentile(ns, n, 0.5), ns[0], -1, -1,
+                           bench_has_cycles() ? percentile(cyc, n, 0.5) : -1, {{0}, {0}} };
+    perf_counts_sub(&res.counters, &after, &before);
+    for (int e = 0; e < PERF_NEVENTS; e++) res.counters.value[e] /= ops * n;
+    if (b->latency && b->ops_per_call <= 1) {
+        if (iters == 1) {
+            res.lat_p50 = res.ns_p50;
+            res.lat_p99 = percentile(ns, n, 0.99);
+        } else {
+            measure_latency(b, fn, ctx, &res);
+        }
+    }
+    free(ns);
+    double cpb = bytes && res.cycles_p50 >= 0 ? res.cycles_p50 / bytes : -1;
+    double gbps = bytes ? bytes / res.ns_p50 : -1;
+
+    if (b->table) {
+        fprintf(b->table, "%-24s %-7s ", name, b->backend ? b->backend : "-");
+        if (b->threads) fprintf(b->table, "%3d ", b->threads);
+        else fprintf(b->table, "%3s ", "-");
+        fprintf(b->table, "%10zu %11.1f ", bytes, res.ns_p50);
+        put_number(b->table, "%11.1f ", res.lat_p50, "          - ");
+        put_number(b->table, "%11.1f ", res.lat_p99, "          - ");
+        put_number(b->table, "%11.0f ", res.cycles_p50, "          - ");
+        put_number(b->table, "%9.2f ", cpb, "        - ");
+        put_number(b->table, "%8.3f", gbps, "       -");
+        if (b->perf.hardware) {
+            put_number(b->table, " %5.2f", ipc(&res), "     -");
+            put_number(b->table, " %9.2f", counter(&res, PERF_L1D_MISSES), "         -");
+            put_number(b->table, " %9.2f", counter(&res, PERF_LLC_MISSES), "         -");
+            put_number(b->table, " %9.2f", counter(&res, PERF_BRANCH_MISSES), "         -");
+        }
+        fputc('\n', b->table);
+        fflush(b->table);
+    }
+    if (b->json) {
+        fprintf(b->json, "%s\n    {\"name\": \"%s\", ", b->count ? "," : "", name);
+        if (b->backend) fprintf(b->json, "\"backend\": \"%s\", ", b->backend);
+        if (b->threads) fprintf(b->json, "\"threads\": %d, ", b->threads);
+        fprintf(b->json, "\"bytes\": %zu, \"iters\": %zu, \"samples\": %d, "
+                "\"ns_per_op\": %.2f, \"ns_min\": %.2f, ", bytes, iters, n, res.ns_p50, res.ns_min);
+        put_number(b->json, "\"lat_p50_ns\": %.1f, ", res.lat_p50, "\"lat_p50_ns\": null, ");
+        put_number(b->json, "\"lat_p99_ns\": %.1f, ", res.lat_p99, "\"lat_p99_ns\": null, ");
+        put_number(b->json, "\"cycles_per_op\": %.1f, ", res.cycles_p50, "\"cycles_per_op\": null, ");
+        put_number(b->json, "\"cycles_per_byte\": %.3f, ", cpb, "\"cycles_per_byte\": null, ");
+        put_number(b->json, "\"gb_per_s\": %.4f, ", gbps, "\"gb_per_s\": null, ");
+        if (b->perf.hardware) {
+            fprintf(b->json, "\"counters\": {");
+            for (int k = 0; k < N_HW_EVENTS; k++) {
+                fprintf(b->json, "%s\"%s\": ", k ? ", " : "", perf_event_name(hw_events[k]));
+                put_number(b->json, "%.3f", counter(&res, hw_events[k]), "null");
+            }
+            put_number(b->json, ", \"ipc\": %.3f}}", ipc(&res), ", \"ipc\": null}}");
+        } else {
+            fprintf(b->json, "\"counters\": null}");
+        }
+    }
+    if (b->csv) {
+        fprintf(b->csv, "%s,%s,%s,", b->suite, name, b->backend ? b->backend : "");
+        if (b->threads) fprintf(b->csv, "%d", b->threads);
+        fprintf(b->csv, ",%zu,%zu,%d,%.2f,%.2f,", bytes, iters, n, res.ns_p50, res.ns_min);
+        put_number(b->csv, "%.1f,", res.lat_p50, ",");
+        put_number(b->csv, "%.1f,", res.lat_p99, ",");
+        put_number(b->csv, "%.1f,", res.cycles_p50, ",");
+        put_number(b->csv, "%.3f,", cpb, ",");
+        put_number(b->csv, "%.4f", gbps, "");
+        for (int k = 0; k < N_HW_EVENTS; k++)
+            put_number(b->csv, ",%.3f", counter(&res, hw_events[k]), ",");
+        put_number(b->csv, ",%.3f\n", ipc(&res), ",\n");
+    }
+    b->count++;
+    if (r) *r = res;
+    return 1;
+}
+
+void bench_finish(bench_t *b) {
+    perf_group_close(&b->perf);
+    if (b->json) {
+        fprintf(b->json, "\n  ]\n}\n");
+        fflush(b->json);
+    }
+    if (b->csv) fflush(b->csv);
+}
@@ -0,0 +1,71 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "perfcnt.h"
+
+// Microbenchmark harness for the bench_* programs. Each measurement first
+// calibrates how many operations make one sample last at least
+// min_sample_ns (which doubles as warmup), runs one more untimed sample,
+// then takes `samples` timed samples; the median per operation is the
+// headline number. Per-call latency p50/p99 come from timing up to
+// BENCH_LATENCY_CALLS single calls, less the cost of reading the timer;
+// when one call already fills a sample, the samples themselves are used.
+// Cycles come from the time-stamp counter where there is one (x86:
+// reference cycles at the TSC rate, not core clocks under turbo). Where
+// perf_event_open allows it, a counter group runs for the whole suite and
+// each result also carries core cycles, instructions and cache / branch
+// misses per operation, summed over the timed samples.
+typedef void (*bench_fn_t)(void *ctx, size_t iters);
+
+typedef struct {
+    const char *name;
+    size_t bytes;          // payload per operation, 0 for fixed-size ops
+    size_t iters;          // operations per sample
+    int samples;
+    double ns_p50, ns_min; // per operation, over the samples
+    double lat_p50, lat_p99;   // ns per single call; < 0 if not measured
+    double cycles_p50;     // per operation; < 0 without a cycle counter
+    perf_counts_t counters;    // per operation, all threads; see perfcnt.h
+} bench_result_t;
+
+typedef struct {
+    const char *suite;
+    int samples;
+    double min_sample_ns;
+    FILE *table;           // human-readable lines, NULL for none
+    FILE *json;            // JSON document, NULL for none
+    FILE *csv;             // one row per result, NULL for none
+    const char *filter;    // only names containing this, NULL for all
+    // Recorded with the following results: the kernel set and thread
+    // count (NULL / 0: not applicable), and whether to time single calls.
+    // ops_per_call > 1 says each call of fn(ctx, 1) does that many
+    // operations side by side (one per thread); per-operation figures are
+    // then aggregate costs and single calls are not timed.
+    const char *backend;
+    int threads;
+    int latency;
+    int ops_per_call;
+    int count;             // results written so far
+    perf_group_t perf;     // opened by bench_init, closed by bench_finish
+} bench_t;
+
+#define BENCH_SAMPLES       15
+#define BENCH_MIN_SAMPLE_NS 2e6   // 2 ms
+#define BENCH_LATENCY_CALLS 1000
+
+void bench_init(bench_t *b, const char *suite, FILE *table, FILE *json, FILE *csv);
+// Measures fn under name; returns 0 (and fills nothing) if the filter
+// skips it. r may be NULL.
+int  bench_run(bench_t *b, const char *name, size_t bytes, bench_fn_t fn, void *ctx,
+               bench_result_t *r);
+void bench_finish(bench_t *b);
+
+double   bench_now_ns(void);
+uint64_t bench_cycles(void);      // 0 if there is no cycle counter
+int      bench_has_cycles(void);
+int      bench_cpu_count(void);
+
+#endif /* BENCH_H */
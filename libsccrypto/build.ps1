@@ -0,0 +1,144 @@
+# PowerShell Build Script for libsccrypto (AES, TEA and Curve25519 in one library)
+# Usage: .\build.ps1 [clean|all|lib|info]
+
+param(
+    [string]$Target = "all"
+)
+
+$ErrorActionPreference = "Stop"
+
+# Code the tools of all three directories share, kept here once
+$Shared = @("compress", "perfcnt", "bench")
+# Cores of the three tool directories, compiled into obj\
+$AesCore = @("aes", "modes", "aes_reader")
+$TeaCore = @("tea", "tea_simd", "tea_mt")
+$EccCore = @("curve25519", "field25519", "ge25519", "ge25519_base", "x25519_avx2", "keypool", "sha512", "chacha20", "poly1305", "chacha20poly1305", "keyring", "ecc_stream", "ed25519")
+$Includes = @("-I.", "-I..\AES", "-I..\TEA", "-I..\ecc_25519")
+
+function Build-Object {
+    param([string]$Source, [string]$Object, [string[]]$Flags = @())
+
+    Write-Host "Compiling $Source..." -ForegroundColor Green
+    gcc -Wall -Wextra -O2 -std=c99 @Flags -c $Source -o $Object
+    if ($LASTEXITCODE -ne 0) {
+        throw "Failed to compile $Source"
+    }
+}
+
+function Build-Executable {
+    param([string]$Name, [string[]]$Objects)
+
+    Write-Host "Linking $Name.exe..." -ForegroundColor Blue
+    gcc -Wall -Wextra -O2 -std=c99 -o "$Name.exe" @Objects
+    if ($LASTEXITCODE -ne 0) {
+        throw "Failed to link $Name.exe"
+    }
+}
+
+function Clear-Build {
+    Write-Host "Cleaning build artifacts..." -ForegroundColor Yellow
+    Remove-Item -Recurse -Force -ErrorAction SilentlyContinue "obj", "*.a", "*.dll", "*.exe"
+    Write-Host "Clean complete." -ForegroundColor Green
+}
+
+# The fixed-base table ge25519_base.c includes, as the ecc_25519 build makes it
+function Build-BaseTable {
+    if (Test-Path "..\ecc_25519\ge25519_base_table.h") {
+        return
+    }
+    Build-Object "..\ecc_25519\field25519.c" "obj\gen_field25519.o"
+    Build-Object "..\ecc_25519\ge25519.c" "obj\gen_ge25519.o"
+    Build-Object "..\ecc_25519\ge25519_gen.c" "obj\ge25519_gen.o"
+    Build-Executable "obj\ge25519_gen" @("obj\ge25519_gen.o", "obj\gen_ge25519.o", "obj\gen_field25519.o")
+    Write-Host "Generating ge25519_base_table.h..." -ForegroundColor Green
+    .\obj\ge25519_gen.exe | Out-File -Encoding ascii "..\ecc_25519\ge25519_base_table.h"
+    if ($LASTEXITCODE -ne 0) {
+        throw "Failed to generate ge25519_base_table.h"
+    }
+}
+
+function Build-Library {
+    Write-Host "Building libsccrypto..." -ForegroundColor Cyan
+    New-Item -ItemType Directory -Force "obj" | Out-Null
+    Build-BaseTable
+
+    $Objects = @("obj\sccrypto.o")
+    Build-Object "sccrypto.c" "obj\sccrypto.o" $Includes
+    foreach ($Name in $Shared) {
+        Build-Object "$Name.c" "obj\$Name.o" $Includes
+        $Objects += "obj\$Name.o"
+    }
+    foreach ($Name in $AesCore) {
+        Build-Object "..\AES\$Name.c" "obj\aes_$Name.o" $Includes
+        $Objects += "obj\aes_$Name.o"
+    }
+    foreach ($Name in $TeaCore) {
+        Build-Object "..\TEA\$Name.c" "obj\tea_$Name.o" $Includes
+        $Objects += "obj\tea_$Name.o"
+    }
+    foreach ($Name in $EccCore) {
+        Build-Object "..\ecc_25519\$Name.c" "obj\ecc_$Name.o" $Includes
+        $Objects += "obj\ecc_$Name.o"
+    }
+
+    Write-Host "Archiving libsccrypto.a..." -ForegroundColor Blue
+    Remove-Item -Force -ErrorAction SilentlyContinue "libsccrypto.a"
+    ar rcs libsccrypto.a @Objects
+    if ($LASTEXITCODE -ne 0) {
+        throw "Failed to archive libsccrypto.a"
+    }
+    Write-Host "Linking sccrypto.dll..." -ForegroundColor Blue
+    gcc -shared -o sccrypto.dll @Objects -pthread
+    if ($LASTEXITCODE -ne 0) {
+        throw "Failed to link sccrypto.dll"
+    }
+}
+
+function Build-All {
+    Build-Library
+    Build-Object "sccrypto_info.c" "obj\sccrypto_info.o" $Includes
+    Build-Executable "sccrypto_info" @("obj\sccrypto_info.o", "sccrypto.dll", "-pthread")
+
+    Write-Host "`nBuild complete! Generated files:" -ForegroundColor Green
+    Write-Host "  - libsccrypto.a      (static library)" -ForegroundColor White
+    Write-Host "  - sccrypto.dll       (shared library)" -ForegroundColor White
+    Write-Host "  - sccrypto_info.exe  (CPU features and bound implementations)" -ForegroundColor White
+}
+
+function Show-Info {
+    Build-All
+    .\sccrypto_info.exe
+}
+
+function Show-Usage {
+    Write-Host "`nlibsccrypto Build Script" -ForegroundColor Cyan
+    Write-Host "Usage: .\build.ps1 [command]" -ForegroundColor White
+    Write-Host "`nCommands:" -ForegroundColor Yellow
+    Write-Host "  all     - Build the libraries and sccrypto_info (default)" -ForegroundColor White
+    Write-Host "  lib     - Build only libsccrypto.a and sccrypto.dll" -ForegroundColor White
+    Write-Host "  clean   - Clean build artifacts" -ForegroundColor White
+    Write-Host "  info    - Build and show the implementation bound to each primitive" -ForegroundColor White
+    Write-Host "  help    - Show this help message" -ForegroundColor White
+    Write-Host "`nExamples:" -ForegroundColor Yellow
+    Write-Host "  .\build.ps1                      # Build everything" -ForegroundColor White
+    Write-Host "  `$env:SCCRYPTO_IMPL='scalar'; .\sccrypto_info.exe" -ForegroundColor White
+}
+
+# Main execution
+try {
+    switch ($Target.ToLower()) {
+        "all" { Build-All }
+        "lib" { Build-Library }
+        "clean" { Clear-Build }
+        "info" { Show-Info }
+        "help" { Show-Usage }
+        default {
+            Write-Host "Unknown target: $Target" -ForegroundColor Red
+            Show-Usage
+            exit 1
+        }
+    }
+} catch {
+    Write-Host "Build failed: $($_.Exception.Message)" -ForegroundColor Red
+    exit 1
+}
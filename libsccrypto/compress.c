@@ -0,0 +1,289 @@
+#define _POSIX_C_SOURCE 200809L
+#include "compress.h"
+#include "byteorder.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define LZ_HASH_BITS   14
+#define LZ_MIN_MATCH   4
+#define LZ_MAX_OFFSET  65535
+#define LZ_TAIL        5      /* the last bytes are always emitted as literals */
+#define LZ_MAX_THREADS 64
+
+#define CZ_MAGIC       "SCZ1"
+#define CZ_HDR_SIZE    20
+#define CZ_CHUNK_HDR   5
+
+static uint32_t load32(const uint8_t *p) { uint32_t v; memcpy(&v, p, 4); return v; }
+static uint32_t lz_hash(uint32_t v) { return (v * 2654435761u) >> (32 - LZ_HASH_BITS); }
+
+/* ---------- LZ block codec --------------------------------------------
+ * LZ4-style sequences: token (literal len << 4 | match len - 4), optional
+ * 255-run length extensions, literals, u16 offset, match extension.  The
+ * final sequence carries literals only.                                  */
+static uint8_t *put_len(uint8_t *op, const uint8_t *oend, size_t len)
+{
+    for (; len >= 255; len -= 255) {
+        if (op >= oend) return NULL;
+        *op++ = 255;
+    }
+    if (op >= oend) return NULL;
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+static uint8_t *emit(uint8_t *op, const uint8_t *oend, const uint8_t *lit,
+                     size_t nlit, size_t offset, size_t mlen)
+{
+    if (!op || op >= oend) return NULL;
+    uint8_t *token = op++;
+    *token = (uint8_t)((nlit < 15 ? nlit : 15) << 4);
+    if (nlit >= 15 && !(op = put_len(op, oend, nlit - 15))) return NULL;
+    if ((size_t)(oend - op) < nlit) return NULL;
+    memcpy(op, lit, nlit);
+    op += nlit;
+    if (!mlen) return op;
+
+    if (oend - op < 2) return NULL;
+    *op++ = (uint8_t)offset;
+    *op++ = (uint8_t)(offset >> 8);
+    mlen -= LZ_MIN_MATCH;
+    *token |= (uint8_t)(mlen < 15 ? mlen : 15);
+    if (mlen >= 15 && !(op = put_len(op, oend, mlen - 15))) return NULL;
+    return op;
+}
+
+size_t lz_compress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap)
+{
+    uint32_t *table = calloc((size_t)1 << LZ_HASH_BITS, sizeof *table);
+    if (!table) return 0;
+
+    uint8_t *op = dst;
+    const uint8_t *oend = dst + cap;
+    size_t ip = 0, anchor = 0;
+    size_t limit = len > LZ_TAIL + LZ_MIN_MATCH ? len - LZ_TAIL : 0;
+
+    while (op && ip < limit) {
+        uint32_t seq = load32(src + ip);
+        uint32_t h = lz_hash(seq);
+        size_t ref = table[h];
+        table[h] = (uint32_t)ip;
+
+        if (ref >= ip || ip - ref > LZ_MAX_OFFSET || load32(src + ref) != seq) {
+            ip += 1 + ((ip - anchor) >> 6);   /* skip faster through noise */
+            continue;
+        }
+        size_t mlen = LZ_MIN_MATCH;
+        while (ip + mlen < limit && src[ref + mlen] == src[ip + mlen]) ++mlen;
+
+        op = emit(op, oend, src + anchor, ip - anchor, ip - ref, mlen);
+        ip += mlen;
+        anchor = ip;
+    }
+    op = emit(op, oend, src + anchor, len - anchor, 0, 0);
+    free(table);
+    return op ? (size_t)(op - dst) : 0;
+}
+
+static int get_len(const uint8_t **ip, const uint8_t *iend, size_t *len)
+{
+    uint8_t b;
+    do {
+        if (*ip >= iend) return -1;
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return 0;
+}
+
+int lz_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t out_len)
+{
+    const uint8_t *ip = src, *iend = src + len;
+    uint8_t *op = dst, *oend = dst + out_len;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+        size_t nlit = token >> 4;
+        if (nlit == 15 && get_len(&ip, iend, &nlit)) return -1;
+        if ((size_t)(iend - ip) < nlit || (size_t)(oend - op) < nlit) return -1;
+        memcpy(op, ip, nlit);
+        op += nlit; ip += nlit;
+        if (ip == iend) break;                 /* final literal-only sequence */
+
+        if (iend - ip < 2) return -1;
+        size_t offset = ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        size_t mlen = token & 15;
+        if (mlen == 15 && get_len(&ip, iend, &mlen)) return -1;
+        mlen += LZ_MIN_MATCH;
+        if (offset == 0 || offset > (size_t)(op - dst) || (size_t)(oend - op) < mlen)
+            return -1;
+        const uint8_t *m = op - offset;
+        for (size_t i = 0; i < mlen; ++i) op[i] = m[i];   /* may overlap */
+        op += mlen;
+    }
+    return op == oend ? 0 : -1;
+}
+
+/* ---------- parallel chunk container ---------------------------------- */
+typedef struct {
+    const uint8_t  *src;        /* chunk input                            */
+    size_t          src_len;
+    uint8_t        *dst;        /* compressor output / decompressed chunk */
+    size_t          dst_len;
+    uint8_t         flag;
+    int             failed;
+} cz_chunk_t;
+
+typedef struct {
+    cz_chunk_t     *chunks;
+    size_t          n, next;
+    int             decompress;
+    pthread_mutex_t lock;
+} cz_job_t;
+
+static void cz_run(cz_job_t *job, cz_chunk_t *c)
+{
+    if (!job->decompress) {
+        c->dst_len = c->src_len > 1 ? lz_compress(c->src, c->src_len, c->dst, c->src_len - 1) : 0;
+        c->flag = c->dst_len ? LZ_CHUNK_LZ : LZ_CHUNK_RAW;
+    } else if (c->flag == LZ_CHUNK_LZ) {
+        c->failed = lz_decompress(c->src, c->src_len, c->dst, c->dst_len) != 0;
+    } else {
+        c->failed = c->flag != LZ_CHUNK_RAW || c->src_len != c->dst_len;
+        if (!c->failed) memcpy(c->dst, c->src, c->src_len);
+    }
+}
+
+static void *cz_worker(void *arg)
+{
+    cz_job_t *job = arg;
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        size_t i = job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if (i >= job->n) return NULL;
+        cz_run(job, &job->chunks[i]);
+    }
+}
+
+static void cz_parallel(cz_job_t *job)
+{
+    long nthreads = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+    nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (nthreads > LZ_MAX_THREADS) nthreads = LZ_MAX_THREADS;
+    if (nthreads > (long)job->n) nthreads = (long)job->n;
+
+    pthread_t tid[LZ_MAX_THREADS];
+    int started = 0;
+    pthread_mutex_init(&job->lock, NULL);
+    for (; started < nthreads - 1; ++started)
+        if (pthread_create(&tid[started], NULL, cz_worker, job) != 0) break;
+    cz_worker(job);                            /* the caller works too */
+    for (int t = 0; t < started; ++t) pthread_join(tid[t], NULL);
+    pthread_mutex_destroy(&job->lock);
+}
+
+uint8_t *compress_chunks(const uint8_t *in, size_t len, size_t *out_len)
+{
+    size_t n = (len + LZ_CHUNK_SIZE - 1) / LZ_CHUNK_SIZE;
+    cz_job_t job = { 0 };
+    job.n = n;
+    job.chunks = calloc(n ? n : 1, sizeof *job.chunks);
+    uint8_t *scratch = malloc(len ? len : 1);
+    if (!job.chunks || !scratch) { free(job.chunks); free(scratch); return NULL; }
+
+    for (size_t i = 0; i < n; ++i) {
+        job.chunks[i].src = in + i * LZ_CHUNK_SIZE;
+        job.chunks[i].src_len = len - i * LZ_CHUNK_SIZE < LZ_CHUNK_SIZE ?
+                                len - i * LZ_CHUNK_SIZE : LZ_CHUNK_SIZE;
+        job.chunks[i].dst = scratch + i * LZ_CHUNK_SIZE;
+    }
+    cz_parallel(&job);
+
+    size_t total = CZ_HDR_SIZE;
+    for (size_t i = 0; i < n; ++i)
+        total += CZ_CHUNK_HDR + (job.chunks[i].flag == LZ_CHUNK_LZ ?
+                                 job.chunks[i].dst_len : job.chunks[i].src_len);
+    uint8_t *out = malloc(total), *p = out;
+    if (out) {
+        memcpy(p, CZ_MAGIC, 4);
+        put_u32(p + 4, LZ_CHUNK_SIZE);
+        put_u64(p + 8, len);
+        put_u32(p + 16, (uint32_t)n);
+        p += CZ_HDR_SIZE;
+        for (size_t i = 0; i < n; ++i) {
+            cz_chunk_t *c = &job.chunks[i];
+            const uint8_t *data = c->flag == LZ_CHUNK_LZ ? c->dst : c->src;
+            size_t dlen = c->flag == LZ_CHUNK_LZ ? c->dst_len : c->src_len;
+            p[0] = c->flag;
+            put_u32(p + 1, (uint32_t)dlen);
+            memcpy(p + CZ_CHUNK_HDR, data, dlen);
+            p += CZ_CHUNK_HDR + dlen;
+        }
+        *out_len = total;
+    }
+    free(scratch);
+    free(job.chunks);
+    return out;
+}
+
+int compress_is_container(const uint8_t *buf, size_t len)
+{
+    return len >= LZ_MAGIC_SIZE && memcmp(buf, CZ_MAGIC, LZ_MAGIC_SIZE) == 0;
+}
+
+int compress_needed(const uint8_t *buf, size_t len, int forced)
+{
+    return forced || compress_is_container(buf, len);
+}
+
+uint8_t *decompress_chunks(const uint8_t *in, size_t len, size_t *out_len)
+{
+    if (len < CZ_HDR_SIZE || memcmp(in, CZ_MAGIC, 4)) return NULL;
+    size_t chunk = get_u32(in + 4);
+    uint64_t total = get_u64(in + 8);
+    size_t n = get_u32(in + 16);
+    if (chunk == 0 || n != (total + chunk - 1) / chunk) return NULL;
+    if (total > SIZE_MAX - 1) return NULL;
+
+    cz_job_t job = { 0 };
+    job.n = n;
+    job.decompress = 1;
+    job.chunks = calloc(n ? n : 1, sizeof *job.chunks);
+    uint8_t *out = malloc(total ? (size_t)total : 1);
+    if (!job.chunks || !out) { free(job.chunks); free(out); return NULL; }
+
+    /* walk the chunk headers first so the workers can run independently */
+    size_t at = CZ_HDR_SIZE;
+    for (size_t i = 0; i < n; ++i) {
+        cz_chunk_t *c = &job.chunks[i];
+        if (len - at < CZ_CHUNK_HDR) goto bad;
+        c->flag = in[at];
+        c->src_len = get_u32(in + at + 1);
+        at += CZ_CHUNK_HDR;
+        if (len - at < c->src_len) goto bad;
+        c->src = in + at;
+        at += c->src_len;
+        c->dst = out + i * chunk;
+        c->dst_len = total - i * chunk < chunk ? (size_t)(total - i * chunk) : chunk;
+    }
+    if (at != len) goto bad;
+
+    cz_parallel(&job);
+    for (size_t i = 0; i < n; ++i)
+        if (job.chunks[i].failed) goto bad;
+
+    free(job.chunks);
+    *out_len = (size_t)total;
+    return out;
+
+bad:
+    free(job.chunks);
+    free(out);
+    return NULL;
+}
@@ -0,0 +1,35 @@
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Chunked LZ container placed in front of the cipher with -z:
+ *   "SCZ1" | u32 chunk_size | u64 total_len | u32 nchunks
+ *   nchunks * ( u8 flag | u32 stored_len | data )
+ * flag is LZ_CHUNK_RAW for chunks that did not shrink. */
+#define LZ_CHUNK_SIZE (1u << 20)
+#define LZ_CHUNK_RAW  0
+#define LZ_CHUNK_LZ   1
+
+/* Raw LZ block codec; compress returns 0 when the output would not fit */
+size_t lz_compress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap);
+int    lz_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t out_len);
+
+/* Whole-buffer container, chunks are (de)compressed in parallel.
+ * Both return a malloc'd buffer, or NULL on malformed input. */
+uint8_t *compress_chunks(const uint8_t *in, size_t len, size_t *out_len);
+uint8_t *decompress_chunks(const uint8_t *in, size_t len, size_t *out_len);
+
+/* Nonzero if buf starts with the container magic (LZ_MAGIC_SIZE bytes);
+ * decrypting tools check the plaintext with it to tell whether to unpack. */
+#define LZ_MAGIC_SIZE 4
+int compress_is_container(const uint8_t *buf, size_t len);
+
+/* Nonzero if an encrypting tool must put the input (or at least its first
+ * LZ_MAGIC_SIZE bytes) into a container: when -z is forced, or when it
+ * already starts with the magic. Ciphertexts do not record -z, so such an
+ * input left as is would be unpacked on decrypt. */
+int compress_needed(const uint8_t *buf, size_t len, int forced);
+
+#endif
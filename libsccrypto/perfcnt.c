@@ -0,0 +1,342 @@
+#define _GNU_SOURCE            // syscall()
+#include "perfcnt.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+static const char *const event_names[PERF_NEVENTS] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses",
+    "task_clock_ns", "page_faults"
+};
+
+const char *perf_event_name(int event) {
+    return event >= 0 && event < PERF_NEVENTS ? event_names[event] : "?";
+}
+
+void perf_counts_sub(perf_counts_t *d, const perf_counts_t *a, const perf_counts_t *b) {
+    for (int i = 0; i < PERF_NEVENTS; i++) {
+        d->valid[i] = a->valid[i] && b->valid[i];
+        d->value[i] = d->valid[i] ? a->value[i] - b->value[i] : 0;
+    }
+}
+
+#ifdef __linux__
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static char unavailable[160] = "not opened";
+
+static const struct { uint32_t type; uint64_t config; } events[PERF_NEVENTS] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+};
+
+static int open_event(int event, int group, int inherit) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof attr);
+    attr.size = sizeof attr;
+    attr.type = events[event].type;
+    attr.config = events[event].config;
+    attr.disabled = group < 0;            // the leader starts the group
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = (unsigned)inherit;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+static void note_unavailable(int err) {
+    int paranoid = -9;
+    FILE *f = fopen("/proc/sys/kernel/perf_event_paranoid", "r");
+    if (f) {
+        if (fscanf(f, "%d", &paranoid) != 1) paranoid = -9;
+        fclose(f);
+    }
+    if (paranoid != -9) {
+        snprintf(unavailable, sizeof unavailable, "%s (perf_event_paranoid=%d)",
+                 strerror(err), paranoid);
+    } else {
+        snprintf(unavailable, sizeof unavailable, "%s", strerror(err));
+    }
+}
+
+static int open_group(perf_group_t *g, int inherit) {
+    int first_err = 0;
+    g->leader = -1;
+    g->n_open = 0;
+    g->hardware = 0;
+    for (int i = 0; i < PERF_NEVENTS; i++) {
+        g->fd[i] = open_event(i, g->leader, inherit);
+        if (g->fd[i] < 0) {
+            if (events[i].type != PERF_TYPE_SOFTWARE && !first_err) first_err = errno;
+            continue;
+        }
+        if (g->leader < 0) g->leader = g->fd[i];
+        g->n_open++;
+        if (events[i].type != PERF_TYPE_SOFTWARE) g->hardware = 1;
+    }
+    if (g->hardware) unavailable[0] = '\0';
+    else note_unavailable(first_err ? first_err : ENOENT);
+    return g->n_open;
+}
+
+int perf_group_open(perf_group_t *g) {
+    // Older kernels refuse inherited group reads; count this thread only
+    if (open_group(g, 1) == 0 || perf_group_read(g, &(perf_counts_t){0}) == 0) {
+        perf_group_close(g);
+        open_group(g, 0);
+    }
+    if (g->leader >= 0) {
+        ioctl(g->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(g->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    return g->n_open;
+}
+
+void perf_group_close(perf_group_t *g) {
+    for (int i = 0; i < PERF_NEVENTS; i++) {
+        if (g->fd[i] >= 0) close(g->fd[i]);
+        g->fd[i] = -1;
+    }
+    g->leader = -1;
+    g->n_open = 0;
+    g->hardware = 0;
+}
+
+int perf_group_read(const perf_group_t *g, perf_counts_t *c) {
+    // nr, time_enabled, time_running, then one value per open event in
+    // the order they were opened
+    uint64_t buf[3 + PERF_NEVENTS];
+    memset(c, 0, sizeof *c);
+    if (g->leader < 0) return 0;
+    ssize_t got = read(g->leader, buf, sizeof buf);
+    if (got < (ssize_t)(3 * sizeof *buf) || buf[0] != (uint64_t)g->n_open) return 0;
+    double scale = buf[2] ? (double)buf[1] / (double)buf[2] : 0;
+    for (int i = 0, k = 0; i < PERF_NEVENTS; i++) {
+        if (g->fd[i] < 0) continue;
+        c->value[i] = (double)buf[3 + k++] * scale;
+        c->valid[i] = buf[2] != 0;
+    }
+    return 1;
+}
+
+const char *perf_unavailable(void) {
+    return unavailable[0] ? unavailable : NULL;
+}
+
+#else
+const char *perf_unavailable(void) {
+    return "perf_event_open is Linux-only";
+}
+
+int perf_group_open(perf_group_t *g) {
+    for (int i = 0; i < PERF_NEVENTS; i++) g->fd[i] = -1;
+    g->leader = -1;
+    g->n_open = 0;
+    g->hardware = 0;
+    return 0;
+}
+
+void perf_group_close(perf_group_t *g) {
+    (void)g;
+}
+
+int perf_group_read(const perf_group_t *g, perf_counts_t *c) {
+    (void)g;
+    memset(c, 0, sizeof *c);
+    return 0;
+}
+
+#endif
+
+double perf_now_ns(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER t;
+    if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&t);
+    return (double)t.QuadPart * 1e9 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+#endif
+}
+
+static long thread_id(void) {
+#if defined(_WIN32)
+    return (long)GetCurrentThreadId();
+#elif defined(__linux__)
+    return (long)syscall(SYS_gettid);
+#else
+    return 0;
+#endif
+}
+
+// One trace per process; spans from worker threads are serialised on the
+// lock, which costs far less than the chunk each span stands for
+static struct {
+    FILE *f;
+    double t0;
+    pthread_mutex_t lock;
+} trace = { NULL, 0, PTHREAD_MUTEX_INITIALIZER };
+
+int perf_trace_open(const char *fname, const char *process) {
+    FILE *f = fopen(fname, "w");
+    if (!f) return 0;
+    // Program name without its directory, which could hold JSON escapes
+    for (const char *c = process; *c; c++)
+        if (*c == '/' || *c == '\\') process = c + 1;
+    pthread_mutex_lock(&trace.lock);
+    trace.f = f;
+    trace.t0 = perf_now_ns();
+    fprintf(f, "[\n{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %ld, "
+            "\"args\": {\"name\": \"%s\"}}", thread_id(), process);
+    pthread_mutex_unlock(&trace.lock);
+    return 1;
+}
+
+void perf_trace_close(void) {
+    pthread_mutex_lock(&trace.lock);
+    if (trace.f) {
+        fprintf(trace.f, "\n]\n");
+        fclose(trace.f);
+        trace.f = NULL;
+    }
+    pthread_mutex_unlock(&trace.lock);
+}
+
+int perf_trace_enabled(void) {
+    return trace.f != NULL;
+}
+
+void perf_trace_span(const char *name, double t0, double t1, size_t bytes) {
+    long tid = thread_id();
+    pthread_mutex_lock(&trace.lock);
+    if (trace.f) {
+        fprintf(trace.f, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %ld, "
+                "\"ts\": %.3f, \"dur\": %.3f, \"args\": {\"bytes\": %zu}}",
+                name, tid, (t0 - trace.t0) / 1e3, (t1 - t0) / 1e3, bytes);
+    }
+    pthread_mutex_unlock(&trace.lock);
+}
+
+void perf_profile_init(perf_profile_t *p, int *argc, char **argv) {
+    const char *trace_fname = NULL;
+    memset(p, 0, sizeof *p);
+    p->current = -1;
+    for (int i = 0; i < PERF_NEVENTS; i++) p->group.fd[i] = -1;
+    p->group.leader = -1;
+
+    int kept = 1;
+    for (int i = 1; i < *argc; i++) {
+        if (!strcmp(argv[i], "--stats")) {
+            p->stats = 1;
+        } else if (!strcmp(argv[i], "--trace")) {
+            if (i + 1 == *argc) {
+                fprintf(stderr, "--trace needs a file name\n");
+                exit(EXIT_FAILURE);
+            }
+            trace_fname = argv[++i];
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argv[kept] = NULL;
+    *argc = kept;
+
+    if (trace_fname && !perf_trace_open(trace_fname, argv[0])) {
+        perror(trace_fname);
+        exit(EXIT_FAILURE);
+    }
+    const char *env = getenv(PERF_ENV);
+    if (env && *env && strcmp(env, "0") != 0) {
+        p->stats = 1;
+        if (perf_group_open(&p->group) == 0) {
+            fprintf(stderr, "%s: no counters available (%s)\n", PERF_ENV, perf_unavailable());
+        } else if (!p->group.hardware) {
+            fprintf(stderr, "%s: hardware counters unavailable (%s)\n", PERF_ENV, perf_unavailable());
+        }
+    }
+    p->enabled = p->stats || trace_fname;
+}
+
+void perf_profile_begin(perf_profile_t *p, const char *stage) {
+    if (!p->enabled) return;
+    int i = 0;
+    while (i < p->n_stages && strcmp(p->stage[i].name, stage) != 0) i++;
+    if (i == p->n_stages) {
+        if (i == PERF_MAX_STAGES) return;
+        p->stage[p->n_stages++].name = stage;
+    }
+    p->current = i;
+    perf_group_read(&p->group, &p->at_begin);
+    p->t_begin = perf_now_ns();
+}
+
+void perf_profile_end(perf_profile_t *p, size_t bytes) {
+    if (!p->enabled || p->current < 0) return;
+    perf_counts_t now, d;
+    double t = perf_now_ns();
+    perf_group_read(&p->group, &now);
+    perf_counts_sub(&d, &now, &p->at_begin);
+    perf_stage_t *s = &p->stage[p->current];
+    s->calls++;
+    s->bytes += bytes;
+    s->ns += t - p->t_begin;
+    for (int i = 0; i < PERF_NEVENTS; i++) {
+        s->counts.valid[i] = d.valid[i];
+        s->counts.value[i] += d.value[i];
+    }
+    perf_trace_span(s->name, p->t_begin, t, bytes);
+    p->current = -1;
+}
+
+void perf_profile_finish(perf_profile_t *p, FILE *out) {
+    if (!p->enabled) return;
+    if (p->stats) {
+        fprintf(out, "%-12s %6s %12s %14s %10s", "stage", "calls", "ms", "bytes", "MB/s");
+        for (int e = 0; e < PERF_NEVENTS; e++)
+            if (p->group.fd[e] >= 0) fprintf(out, " %14s", perf_event_name(e));
+        if (p->group.fd[PERF_CYCLES] >= 0 && p->group.fd[PERF_INSTRUCTIONS] >= 0)
+            fprintf(out, " %6s", "IPC");
+        fputc('\n', out);
+    }
+    for (int i = 0; p->stats && i < p->n_stages; i++) {
+        const perf_stage_t *s = &p->stage[i];
+        fprintf(out, "%-12s %6llu %12.3f %14llu", s->name, (unsigned long long)s->calls,
+                s->ns / 1e6, (unsigned long long)s->bytes);
+        if (s->bytes && s->ns > 0) fprintf(out, " %10.1f", (double)s->bytes * 1e3 / s->ns);
+        else fprintf(out, " %10s", "-");
+        for (int e = 0; e < PERF_NEVENTS; e++) {
+            if (p->group.fd[e] < 0) continue;
+            if (s->counts.valid[e]) fprintf(out, " %14.0f", s->counts.value[e]);
+            else fprintf(out, " %14s", "-");
+        }
+        if (p->group.fd[PERF_CYCLES] >= 0 && p->group.fd[PERF_INSTRUCTIONS] >= 0) {
+            if (s->counts.valid[PERF_CYCLES] && s->counts.value[PERF_CYCLES] > 0)
+                fprintf(out, " %6.2f", s->counts.value[PERF_INSTRUCTIONS] / s->counts.value[PERF_CYCLES]);
+            else fprintf(out, " %6s", "-");
+        }
+        fputc('\n', out);
+    }
+    perf_group_close(&p->group);
+    perf_trace_close();
+    p->enabled = 0;
+}
@@ -0,0 +1,102 @@
+#ifndef PERFCNT_H
+#define PERFCNT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Hardware performance counters through Linux perf_event_open, counted
+// in user space for the calling thread and the threads it creates after
+// the group is opened. The events form one group, so they are scheduled
+// together and their ratios (IPC, misses per instruction) are consistent;
+// when the PMU multiplexes the group, values are scaled by enabled /
+// running time. Every event is optional: one the kernel, the hypervisor
+// or perf_event_paranoid refuses is simply left out, and with none at all
+// (containers, other OSes) the group is empty and readers see zeros.
+enum {
+    PERF_CYCLES,          // core cycles (unlike the TSC, follows the clock)
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,      // L1 data cache read misses
+    PERF_LLC_MISSES,      // last-level cache read misses
+    PERF_BRANCH_MISSES,
+    PERF_TASK_CLOCK,      // software: CPU time in ns, summed over threads
+    PERF_PAGE_FAULTS,     // software
+    PERF_NEVENTS
+};
+
+typedef struct {
+    int fd[PERF_NEVENTS];         // -1 where the event is not counted
+    int leader;                   // fd of the group leader, -1 if empty
+    int n_open;
+    int hardware;                 // any hardware event counted
+} perf_group_t;
+
+typedef struct {
+    double value[PERF_NEVENTS];   // scaled for multiplexing
+    int valid[PERF_NEVENTS];
+} perf_counts_t;
+
+// Returns the number of events opened (0: none; see perf_unavailable)
+int  perf_group_open(perf_group_t *g);
+void perf_group_close(perf_group_t *g);
+// Current totals since the group was opened; 0 if nothing was read
+int  perf_group_read(const perf_group_t *g, perf_counts_t *c);
+// d = a - b per event (valid where both are)
+void perf_counts_sub(perf_counts_t *d, const perf_counts_t *a, const perf_counts_t *b);
+
+const char *perf_event_name(int event);   // "cycles", "l1d_misses", ...
+// Why no hardware event could be opened, or NULL if one was
+const char *perf_unavailable(void);
+
+// Pipeline stages of a CLI run. perf_profile_init takes the options
+// --stats and --trace FILE out of argv (before the tool parses the rest)
+// and reads SCCRYPTO_PERF from the environment:
+//   --stats        time, bytes and throughput per stage on exit
+//   SCCRYPTO_PERF  the same plus the counter group (implies --stats)
+//   --trace FILE   Chrome trace events, one span per stage call
+// Every begin / end pair adds to the named stage; with none of the three
+// all calls are no-ops. Stages do not nest. Threads started inside a
+// stage are counted in it once they have been joined.
+#define PERF_MAX_STAGES 16
+#define PERF_ENV        "SCCRYPTO_PERF"
+
+typedef struct {
+    const char *name;
+    uint64_t calls;
+    uint64_t bytes;
+    double ns;
+    perf_counts_t counts;
+} perf_stage_t;
+
+typedef struct {
+    int enabled;                  // any of the three above
+    int stats;
+    perf_group_t group;
+    perf_stage_t stage[PERF_MAX_STAGES];
+    int n_stages;
+    int current;                  // stage index between begin and end, else -1
+    double t_begin;
+    perf_counts_t at_begin;
+} perf_profile_t;
+
+// Exits with a message if --trace has no file or the file cannot be created
+void perf_profile_init(perf_profile_t *p, int *argc, char **argv);
+void perf_profile_begin(perf_profile_t *p, const char *stage);
+// bytes: payload the stage call handled, 0 if it has none
+void perf_profile_end(perf_profile_t *p, size_t bytes);
+// Writes one line per stage to out (with --stats) and closes the group
+// and the trace
+void perf_profile_finish(perf_profile_t *p, FILE *out);
+
+// Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev): one
+// complete event per span, written as it ends, from any thread. The file
+// is an event array, which the viewers accept even without the closing
+// bracket of a run that died.
+int    perf_trace_open(const char *fname, const char *process);
+void   perf_trace_close(void);
+int    perf_trace_enabled(void);
+// A span on the calling thread from t0 to t1 (perf_now_ns clock)
+void   perf_trace_span(const char *name, double t0, double t1, size_t bytes);
+double perf_now_ns(void);
+
+#endif /* PERFCNT_H */
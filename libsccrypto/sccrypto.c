@@ -0,0 +1,190 @@
+#define _POSIX_C_SOURCE 200809L
+#include "sccrypto.h"
+#include "chacha20.h"
+#include "poly1305.h"
+#include "x25519_avx2.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCC_HAVE_X86 1
+#endif
+
+#define SCC_MAX_IMPLS 4
+
+typedef struct {
+    const char *name;
+    unsigned needs;                  // SCCRYPTO_CPU_* bits
+} scc_impl_t;
+
+// Primitives and their implementations, fastest first. bind makes the
+// module use one for the contexts set up from then on and returns -1 if it
+// is not compiled in; NULL for primitives with a single implementation.
+typedef struct {
+    const char *name;
+    int (*bind)(const char *impl);
+    scc_impl_t impls[SCC_MAX_IMPLS];
+    const char *bound;
+} scc_primitive_t;
+
+static scc_primitive_t primitives[] = {
+    { "aes", NULL,
+      { { "table", 0 } }, NULL },
+    { "tea", tea_set_default_backend,
+      { { "avx512", SCCRYPTO_CPU_AVX512F }, { "avx2", SCCRYPTO_CPU_AVX2 },
+        { "sse2", SCCRYPTO_CPU_SSE2 }, { "scalar", 0 } }, NULL },
+    { "chacha20", chacha20_set_default_backend,
+      { { "avx512", SCCRYPTO_CPU_AVX512F }, { "avx2", SCCRYPTO_CPU_AVX2 },
+        { "sse2", SCCRYPTO_CPU_SSE2 }, { "scalar", 0 } }, NULL },
+    { "poly1305", poly1305_set_default_backend,
+      { { "avx2", SCCRYPTO_CPU_AVX2 }, { "scalar", 0 } }, NULL },
+    { "x25519", x25519_set_default_backend,
+      { { "avx2", SCCRYPTO_CPU_AVX2 }, { "scalar", 0 } }, NULL },
+};
+
+#define SCC_NPRIMITIVES (sizeof primitives / sizeof primitives[0])
+
+static unsigned cpu_features;
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+
+static unsigned probe_cpu(void) {
+    unsigned f = 0;
+#ifdef SCC_HAVE_X86
+    // may run from a constructor, before libgcc has initialised its copy
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))    f |= SCCRYPTO_CPU_SSE2;
+    if (__builtin_cpu_supports("avx2"))    f |= SCCRYPTO_CPU_AVX2;
+    if (__builtin_cpu_supports("avx512f")) f |= SCCRYPTO_CPU_AVX512F;
+#endif
+    return f;
+}
+
+static scc_primitive_t *find_primitive(const char *name) {
+    for (size_t i = 0; i < SCC_NPRIMITIVES; i++) {
+        if (!strcmp(primitives[i].name, name)) return &primitives[i];
+    }
+    return NULL;
+}
+
+static const scc_impl_t *find_impl(const scc_primitive_t *p, const char *name) {
+    for (int j = 0; j < SCC_MAX_IMPLS && p->impls[j].name; j++) {
+        if (!strcmp(p->impls[j].name, name)) return &p->impls[j];
+    }
+    return NULL;
+}
+
+static int bind_impl(scc_primitive_t *p, const char *name) {
+    const scc_impl_t *impl = find_impl(p, name);
+    if (!impl || (impl->needs & ~cpu_features)) return -1;
+    if (p->bind && p->bind(impl->name) != 0) return -1;
+    p->bound = impl->name;
+    return 0;
+}
+
+static int bind_fastest(scc_primitive_t *p) {
+    for (int j = 0; j < SCC_MAX_IMPLS && p->impls[j].name; j++) {
+        if (bind_impl(p, p->impls[j].name) == 0) return 0;
+    }
+    return -1;
+}
+
+// One SCCRYPTO_IMPL item, "primitive=impl" or "impl"
+static void apply_override(char *item) {
+    char *eq = strchr(item, '=');
+    if (eq) {
+        *eq = '\0';
+        scc_primitive_t *p = find_primitive(item);
+        if (!p) {
+            fprintf(stderr, "libsccrypto: %s: unknown primitive '%s'\n", SCCRYPTO_ENV, item);
+        } else if (bind_impl(p, eq + 1) != 0) {
+            fprintf(stderr, "libsccrypto: %s: %s=%s not available, using %s\n",
+                    SCCRYPTO_ENV, item, eq + 1, p->bound);
+        }
+        return;
+    }
+
+    int known = 0;
+    for (size_t i = 0; i < SCC_NPRIMITIVES; i++) {
+        scc_primitive_t *p = &primitives[i];
+        if (!find_impl(p, item)) continue;
+        known = 1;
+        if (bind_impl(p, item) != 0) {
+            fprintf(stderr, "libsccrypto: %s: %s=%s not available, using %s\n",
+                    SCCRYPTO_ENV, p->name, item, p->bound);
+        }
+    }
+    if (!known) {
+        fprintf(stderr, "libsccrypto: %s: unknown implementation '%s'\n", SCCRYPTO_ENV, item);
+    }
+}
+
+static void init_registry(void) {
+    cpu_features = probe_cpu();
+    for (size_t i = 0; i < SCC_NPRIMITIVES; i++) {
+        bind_fastest(&primitives[i]);
+    }
+
+    const char *spec = getenv(SCCRYPTO_ENV);
+    while (spec && *spec) {
+        size_t len = strcspn(spec, ",");
+        char item[64];
+        if (len >= sizeof item) {
+            fprintf(stderr, "libsccrypto: %s: item too long: %.*s\n", SCCRYPTO_ENV, (int)len, spec);
+        } else if (len) {
+            memcpy(item, spec, len);
+            item[len] = '\0';
+            apply_override(item);
+        }
+        spec += len;
+        if (*spec == ',') spec++;
+    }
+}
+
+void sccrypto_init(void) {
+    pthread_once(&init_once, init_registry);
+}
+
+#ifdef __GNUC__
+__attribute__((constructor)) static void sccrypto_load(void) {
+    sccrypto_init();
+}
+#endif
+
+unsigned sccrypto_cpu_features(void) {
+    sccrypto_init();
+    return cpu_features;
+}
+
+const char *sccrypto_impl(const char *primitive) {
+    sccrypto_init();
+    scc_primitive_t *p = find_primitive(primitive);
+    return p ? p->bound : NULL;
+}
+
+int sccrypto_set_impl(const char *primitive, const char *impl) {
+    sccrypto_init();
+    scc_primitive_t *p = find_primitive(primitive);
+    if (!p) return -1;
+    return impl ? bind_impl(p, impl) : bind_fastest(p);
+}
+
+void sccrypto_report(FILE *out) {
+    static const char *const feature_names[] = { "sse2", "avx2", "avx512f" };
+    sccrypto_init();
+
+    fprintf(out, "libsccrypto: cpu");
+    for (int b = 0; b < 3; b++) {
+        if (cpu_features & (1u << b)) fprintf(out, " %s", feature_names[b]);
+    }
+    fprintf(out, "%s\n", cpu_features ? "" : " (no SIMD features)");
+
+    for (size_t i = 0; i < SCC_NPRIMITIVES; i++) {
+        const scc_primitive_t *p = &primitives[i];
+        fprintf(out, "  %-10s %-8s  of", p->name, p->bound ? p->bound : "-");
+        for (int j = 0; j < SCC_MAX_IMPLS && p->impls[j].name; j++) {
+            if (!(p->impls[j].needs & ~cpu_features)) fprintf(out, " %s", p->impls[j].name);
+        }
+        fputc('\n', out);
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef SCCRYPTO_H
+#define SCCRYPTO_H
+
+// libsccrypto: the AES, TEA and Curve25519 cores of the three tool
+// directories, and the code their tools share (the -z codec, the
+// perfcnt.h profiling layer and the bench.h harness), as one static
+// (libsccrypto.a) or shared (libsccrypto.so) library behind this header.
+// Compile with -I for libsccrypto, AES, TEA and ecc_25519.
+#include "aes.h"
+#include "modes.h"
+#include "aes_reader.h"
+#include "tea.h"
+#include "tea_mt.h"
+#include "curve25519.h"
+#include "compress.h"
+#include "perfcnt.h"
+#include <stdio.h>
+
+// Kernel dispatch. Every primitive has its implementations listed fastest
+// first; the CPU features are probed once when the library is loaded and
+// each primitive is bound to the first implementation both the CPU and the
+// build support. SCCRYPTO_IMPL in the environment overrides the choice with
+// a comma-separated list of primitive=impl pairs, or bare implementation
+// names that apply to every primitive having one:
+//   SCCRYPTO_IMPL=scalar                  portable code everywhere
+//   SCCRYPTO_IMPL=tea=sse2,x25519=scalar
+// A name that is unknown or not usable on this machine is reported on
+// stderr and the fastest implementation kept.
+//
+//   primitive  implementations
+//   aes        table
+//   tea        avx512 avx2 sse2 scalar
+//   chacha20   avx512 avx2 sse2 scalar
+//   poly1305   avx2 scalar
+//   x25519     avx2 scalar    (the four-way ladders of the batch calls)
+//
+// Bindings apply to contexts set up (and batches started) afterwards.
+#define SCCRYPTO_ENV "SCCRYPTO_IMPL"
+
+enum {
+    SCCRYPTO_CPU_SSE2    = 1 << 0,
+    SCCRYPTO_CPU_AVX2    = 1 << 1,
+    SCCRYPTO_CPU_AVX512F = 1 << 2,
+};
+
+// Probes, binds and reads SCCRYPTO_IMPL the first time; later calls do
+// nothing. Runs as a load-time constructor with GCC and Clang, before
+// main, and every function below calls it, as do the cores when they set
+// up a key or a batch, which is what links the registry into any program
+// using them; programs only need to call it
+// with other compilers, before setting up any contexts.
+void        sccrypto_init(void);
+unsigned    sccrypto_cpu_features(void);    // SCCRYPTO_CPU_* bits
+// Bound implementation of a primitive, NULL if there is no such primitive
+const char *sccrypto_impl(const char *primitive);
+// Binds impl (NULL: the fastest usable one); -1 if either name is unknown
+// or the implementation is not usable here, leaving the binding as it was.
+// Not thread-safe against contexts being set up at the same time.
+int         sccrypto_set_impl(const char *primitive, const char *impl);
+// CPU features, then one line per primitive: the bound implementation and
+// the ones this CPU supports
+void        sccrypto_report(FILE *out);
+
+#endif /* SCCRYPTO_H */
@@ -0,0 +1,10 @@
+// sccrypto_info – prints the CPU features libsccrypto found and the
+// implementation bound to each primitive (after SCCRYPTO_IMPL)
+#include "sccrypto.h"
+#include <stdlib.h>
+
+int main(void) {
+    sccrypto_init();
+    sccrypto_report(stdout);
+    return EXIT_SUCCESS;
+}